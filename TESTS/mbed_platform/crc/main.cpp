@@ -0,0 +1,84 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include "platform/mbed_crc.h"
+#include "greentea-client/test_env.h"
+#include "utest/utest.h"
+#include "unity/unity.h"
+
+using utest::v1::Case;
+
+
+static uint32_t bitwise_crc32(uint32_t crc, const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+        }
+    }
+
+    return crc;
+}
+
+void test_check_value()
+{
+    uint32_t crc = mbed_crc32_update(0xffffffff, "123456789", 9);
+    TEST_ASSERT_EQUAL_HEX32(0xcbf43926, crc ^ 0xffffffff);
+
+    // split across calls
+    crc = 0xffffffff;
+    crc = mbed_crc32_update(crc, "1234", 4);
+    crc = mbed_crc32_update(crc, "", 0);
+    crc = mbed_crc32_update(crc, "56789", 5);
+    TEST_ASSERT_EQUAL_HEX32(0xcbf43926, crc ^ 0xffffffff);
+}
+
+void test_alignment()
+{
+    static uint8_t buffer[256 + 8];
+    srand(1);
+    for (size_t i = 0; i < sizeof(buffer); i++) {
+        buffer[i] = rand();
+    }
+
+    // every alignment, including the unaligned word loads of slice-by-8
+    for (size_t off = 0; off < 8; off++) {
+        for (size_t len = 0; len <= 256; len += 7) {
+            uint32_t state = rand();
+            TEST_ASSERT_EQUAL_HEX32(bitwise_crc32(state, &buffer[off], len),
+                    mbed_crc32_update(state, &buffer[off], len));
+        }
+    }
+}
+
+utest::v1::status_t test_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(10, "default_auto");
+    return utest::v1::verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("Test CRC check value", test_check_value),
+    Case("Test CRC alignment", test_alignment),
+};
+
+utest::v1::Specification specification(test_setup, cases);
+
+int main()
+{
+    return !utest::v1::Harness::run(specification);
+}
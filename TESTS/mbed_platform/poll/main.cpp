@@ -0,0 +1,354 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "utest/utest.h"
+#include "unity/unity.h"
+
+#if !defined(MBED_CONF_RTOS_PRESENT)
+  #error [NOT_SUPPORTED] test not supported
+#endif
+
+using utest::v1::Case;
+
+
+#define HANDLES         16
+#define READY_HANDLE    7
+#define WAIT_MS         500
+
+
+/** A file handle whose state is set from interrupt context
+ *
+ *  Without poll listener support poll() and Poller have to scan it
+ *  periodically.
+ */
+class PlainHandle : public FileHandle {
+public:
+    PlainHandle() : _state(0), _polls(0) {}
+
+    virtual ssize_t read(void *buffer, size_t size) { return -EAGAIN; }
+    virtual ssize_t write(const void *buffer, size_t size) { return -EAGAIN; }
+    virtual off_t seek(off_t offset, int whence) { return -ESPIPE; }
+    virtual int close() { return 0; }
+
+    virtual short poll(short events) const
+    {
+        _polls += 1;
+        return _state & events;
+    }
+
+    virtual void sigio(Callback<void()> func)
+    {
+        core_util_critical_section_enter();
+        _sigio = func;
+        core_util_critical_section_exit();
+    }
+
+    virtual void set(short state)
+    {
+        _state = state;
+        if (_sigio) {
+            _sigio();
+        }
+    }
+
+    void make_readable()
+    {
+        set(POLLIN);
+    }
+
+    volatile short _state;
+    mutable volatile unsigned _polls;
+    Callback<void()> _sigio;
+};
+
+/** A file handle that wakes poll listeners on state changes
+ */
+class TestHandle : public PlainHandle {
+public:
+    virtual bool attach_poll(PollListener *listener)
+    {
+        _listeners.attach(listener);
+        return true;
+    }
+
+    virtual void detach_poll(PollListener *listener)
+    {
+        _listeners.detach(listener);
+    }
+
+    virtual void set(short state)
+    {
+        PlainHandle::set(state);
+        _listeners.wake();
+    }
+
+    PollListenerList _listeners;
+};
+
+TestHandle handles[HANDLES];
+Timeout timeout;
+
+volatile unsigned sigio_count;
+
+void count_sigio()
+{
+    sigio_count += 1;
+}
+
+volatile uint32_t idle_count;
+
+void idle_hook()
+{
+    idle_count += 1;
+}
+
+void reset_handles()
+{
+    for (int i = 0; i < HANDLES; i++) {
+        handles[i]._state = 0;
+        handles[i]._polls = 0;
+    }
+}
+
+unsigned count_polls()
+{
+    unsigned polls = 0;
+    for (int i = 0; i < HANDLES; i++) {
+        polls += handles[i]._polls;
+    }
+    return polls;
+}
+
+// How poll used to wait, scanning every handle each tick
+int spin_poll(pollfh fhs[], unsigned nfhs)
+{
+    for (;;) {
+        int count = 0;
+        for (unsigned n = 0; n < nfhs; n++) {
+            fhs[n].revents = fhs[n].fh->poll(fhs[n].events) & fhs[n].events;
+            if (fhs[n].revents) {
+                count++;
+            }
+        }
+
+        if (count) {
+            return count;
+        }
+        Thread::wait(1);
+    }
+}
+
+enum wait_kind { SPIN, POLL, POLLER };
+
+// Idle-waits on all handles until one becomes readable from
+// an interrupt and reports the cpu used while waiting
+template <wait_kind kind>
+void test_idle_wait()
+{
+    const char *names[] = {"spinning scan", "poll", "Poller"};
+    pollfh fhs[HANDLES];
+    for (int i = 0; i < HANDLES; i++) {
+        fhs[i].fh = &handles[i];
+        fhs[i].events = POLLIN;
+    }
+    reset_handles();
+
+    Poller poller;
+    if (kind == POLLER) {
+        for (int i = 0; i < HANDLES; i++) {
+            TEST_ASSERT_EQUAL(0, poller.add(&handles[i], POLLIN));
+        }
+        pollfh ready[HANDLES];
+        TEST_ASSERT_EQUAL(0, poller.wait(ready, HANDLES, 0));
+    }
+
+    // calibrate the idle loop while nothing else is running
+    Thread::attach_idle_hook(idle_hook);
+    idle_count = 0;
+    Thread::wait(100);
+    uint32_t idle_per_ms = idle_count / 100;
+
+    unsigned polls_before = count_polls();
+    Timer timer;
+    timer.start();
+    timeout.attach_us(callback(&handles[READY_HANDLE], &PlainHandle::make_readable), WAIT_MS*1000);
+    idle_count = 0;
+
+    int count;
+    pollfh ready[HANDLES];
+    if (kind == SPIN) {
+        count = spin_poll(fhs, HANDLES);
+    } else if (kind == POLL) {
+        count = poll(fhs, HANDLES, -1);
+    } else {
+        count = poller.wait(ready, HANDLES, -1);
+    }
+
+    uint32_t idle = idle_count;
+    int us = timer.read_us();
+    Thread::attach_idle_hook(NULL);
+    unsigned polls = count_polls() - polls_before;
+
+    TEST_ASSERT_EQUAL(1, count);
+    if (kind == POLLER) {
+        TEST_ASSERT_EQUAL_PTR(&handles[READY_HANDLE], ready[0].fh);
+        TEST_ASSERT_EQUAL(POLLIN, ready[0].revents);
+    } else {
+        TEST_ASSERT_EQUAL(POLLIN, fhs[READY_HANDLE].revents);
+    }
+
+    int idle_us = idle_per_ms ? (int)(1000ull*idle / idle_per_ms) : 0;
+    int busy_us = us > idle_us ? us - idle_us : 0;
+    printf("MBED: %s: woke after %d us, %u handle polls, %d us cpu (%d.%d%%)\r\n",
+            names[kind], us, polls, busy_us,
+            busy_us*100 / us, (busy_us*1000 / us) % 10);
+
+    if (kind == POLL) {
+        // one scan before sleeping and one after waking
+        TEST_ASSERT(polls <= 2*HANDLES);
+    } else if (kind == POLLER) {
+        // only the handle that signalled is examined
+        TEST_ASSERT_EQUAL(1, polls);
+    }
+}
+
+void test_poll_timeout()
+{
+    pollfh fhs[HANDLES];
+    for (int i = 0; i < HANDLES; i++) {
+        fhs[i].fh = &handles[i];
+        fhs[i].events = POLLIN;
+    }
+    reset_handles();
+
+    Timer timer;
+    timer.start();
+    TEST_ASSERT_EQUAL(0, poll(fhs, HANDLES, 100));
+    TEST_ASSERT_INT_WITHIN(20, 100, timer.read_ms());
+    TEST_ASSERT(count_polls() <= 2*HANDLES);
+}
+
+void test_poll_keeps_sigio()
+{
+    reset_handles();
+    sigio_count = 0;
+    handles[0].sigio(count_sigio);
+
+    pollfh fhs[1] = {{&handles[0], POLLIN, 0}};
+    TEST_ASSERT_EQUAL(0, poll(fhs, 1, 10));
+
+    // both the owner and poll() are woken while polling
+    timeout.attach_us(callback(&handles[0], &PlainHandle::make_readable), 10000);
+    TEST_ASSERT_EQUAL(1, poll(fhs, 1, -1));
+    TEST_ASSERT_EQUAL(1, sigio_count);
+
+    Poller poller;
+    TEST_ASSERT_EQUAL(0, poller.add(&handles[0], POLLIN));
+    TEST_ASSERT_EQUAL(0, poller.remove(&handles[0]));
+
+    // the callback registered before polling still fires afterwards
+    handles[0].set(POLLOUT);
+    TEST_ASSERT_EQUAL(2, sigio_count);
+    handles[0].sigio(Callback<void()>());
+}
+
+void test_poll_rescan()
+{
+    PlainHandle plain;
+    pollfh fhs[2] = {{&handles[0], POLLIN, 0}, {&plain, POLLIN, 0}};
+    reset_handles();
+
+    // the plain handle never wakes poll() but is scanned again
+    // well before the timeout
+    Timer timer;
+    timer.start();
+    timeout.attach_us(callback(&plain, &PlainHandle::make_readable), 10000);
+    TEST_ASSERT_EQUAL(1, poll(fhs, 2, WAIT_MS));
+    TEST_ASSERT(timer.read_ms() < WAIT_MS / 2);
+    TEST_ASSERT_EQUAL(POLLIN, fhs[1].revents);
+
+    Poller poller;
+    TEST_ASSERT_EQUAL(0, poller.add(&plain, POLLIN));
+    plain._state = 0;
+    pollfh ready[1];
+    TEST_ASSERT_EQUAL(0, poller.wait(ready, 1, 0));
+
+    timer.reset();
+    timeout.attach_us(callback(&plain, &PlainHandle::make_readable), 10000);
+    TEST_ASSERT_EQUAL(1, poller.wait(ready, 1, WAIT_MS));
+    TEST_ASSERT(timer.read_ms() < WAIT_MS / 2);
+    TEST_ASSERT_EQUAL_PTR(&plain, ready[0].fh);
+}
+
+void test_poller_level_triggered()
+{
+    reset_handles();
+    Poller poller;
+    for (int i = 0; i < HANDLES; i++) {
+        TEST_ASSERT_EQUAL(0, poller.add(&handles[i], POLLIN));
+    }
+    TEST_ASSERT_EQUAL(-EEXIST, poller.add(&handles[0], POLLIN));
+
+    pollfh ready[HANDLES];
+    TEST_ASSERT_EQUAL(0, poller.wait(ready, HANDLES, 0));
+
+    handles[3].set(POLLIN);
+    handles[5].set(POLLHUP);
+    TEST_ASSERT_EQUAL(2, poller.wait(ready, HANDLES, 0));
+    TEST_ASSERT_EQUAL_PTR(&handles[3], ready[0].fh);
+    TEST_ASSERT_EQUAL(POLLIN, ready[0].revents);
+    TEST_ASSERT_EQUAL_PTR(&handles[5], ready[1].fh);
+    TEST_ASSERT_EQUAL(POLLHUP, ready[1].revents);
+
+    // still ready handles are reported again
+    handles[5]._state = 0;
+    TEST_ASSERT_EQUAL(1, poller.wait(ready, HANDLES, 0));
+    TEST_ASSERT_EQUAL_PTR(&handles[3], ready[0].fh);
+
+    TEST_ASSERT_EQUAL(0, poller.modify(&handles[3], POLLOUT));
+    TEST_ASSERT_EQUAL(0, poller.wait(ready, HANDLES, 0));
+
+    TEST_ASSERT_EQUAL(0, poller.remove(&handles[3]));
+    TEST_ASSERT_EQUAL(-ENOENT, poller.remove(&handles[3]));
+
+    // removed handles are no longer reported
+    handles[3].set(POLLIN);
+    TEST_ASSERT_EQUAL(0, poller.wait(ready, HANDLES, 0));
+}
+
+utest::v1::status_t test_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(20, "default_auto");
+    return utest::v1::verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("Test idle wait on 16 handles, spinning scan", test_idle_wait<SPIN>),
+    Case("Test idle wait on 16 handles, poll", test_idle_wait<POLL>),
+    Case("Test idle wait on 16 handles, Poller", test_idle_wait<POLLER>),
+    Case("Test poll timeout", test_poll_timeout),
+    Case("Test poll keeps sigio callbacks", test_poll_keeps_sigio),
+    Case("Test poll rescans plain handles", test_poll_rescan),
+    Case("Test Poller level-triggered readiness", test_poller_level_triggered),
+};
+
+utest::v1::Specification specification(test_setup, cases);
+
+int main()
+{
+    return !utest::v1::Harness::run(specification);
+}
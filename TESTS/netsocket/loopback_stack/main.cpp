@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2013-2017, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(MBED_CONF_RTOS_PRESENT)
+    #error [NOT_SUPPORTED] LoopbackStack benchmarks need the RTOS
+#endif
+
+#include "mbed.h"
+#include "LoopbackStack.h"
+#include "TCPSocket.h"
+#include "TCPServer.h"
+#include "UDPSocket.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest.h"
+
+using namespace utest::v1;
+
+
+// These benchmarks run the real sockets over an in-memory stack, so the
+// numbers measure the socket layer without any network or driver costs
+
+#ifndef MBED_CFG_LOOPBACK_PORT
+#define MBED_CFG_LOOPBACK_PORT 7031
+#endif
+
+#ifndef MBED_CFG_LOOPBACK_TCP_SIZE
+#define MBED_CFG_LOOPBACK_TCP_SIZE (256*1024)
+#endif
+
+#ifndef MBED_CFG_LOOPBACK_TCP_CHUNK
+#define MBED_CFG_LOOPBACK_TCP_CHUNK 512
+#endif
+
+#ifndef MBED_CFG_LOOPBACK_UDP_COUNT
+#define MBED_CFG_LOOPBACK_UDP_COUNT 8
+#endif
+
+#ifndef MBED_CFG_LOOPBACK_UDP_ROUNDS
+#define MBED_CFG_LOOPBACK_UDP_ROUNDS 500
+#endif
+
+#ifndef MBED_CFG_LOOPBACK_UDP_PACKET_SIZE
+#define MBED_CFG_LOOPBACK_UDP_PACKET_SIZE 32
+#endif
+
+#ifndef MBED_CFG_LOOPBACK_CONNECTIONS
+#define MBED_CFG_LOOPBACK_CONNECTIONS 200
+#endif
+
+#ifndef MBED_CFG_LOOPBACK_LOOKUPS
+#define MBED_CFG_LOOPBACK_LOOKUPS 100
+#endif
+
+#define LOOPBACK_ADDR "127.0.0.1"
+#define DNS_NAME "bench.example.com"
+#define DNS_ANSWER "10.1.2.3"
+
+
+LoopbackStack loopback;
+NetworkStack *stack = &loopback;
+
+static uint8_t pattern(int i)
+{
+    return (uint8_t)(i ^ (i >> 8));
+}
+
+
+// Stream data through a single connection while the other end reads it
+uint8_t tx_chunk[MBED_CFG_LOOPBACK_TCP_CHUNK];
+uint8_t rx_chunk[MBED_CFG_LOOPBACK_TCP_CHUNK];
+
+void tcp_writer(TCPSocket *sock)
+{
+    int sent = 0;
+    while (sent < MBED_CFG_LOOPBACK_TCP_SIZE) {
+        int size = MBED_CFG_LOOPBACK_TCP_SIZE - sent;
+        if (size > MBED_CFG_LOOPBACK_TCP_CHUNK) {
+            size = MBED_CFG_LOOPBACK_TCP_CHUNK;
+        }
+
+        for (int i = 0; i < size; i++) {
+            tx_chunk[i] = pattern(sent + i);
+        }
+
+        int td = sock->send(tx_chunk, size);
+        if (td <= 0) {
+            return;
+        }
+        sent += td;
+    }
+}
+
+void test_tcp_throughput()
+{
+    TCPServer server(stack);
+    int err = server.bind(MBED_CFG_LOOPBACK_PORT);
+    TEST_ASSERT_EQUAL(0, err);
+    err = server.listen(1);
+    TEST_ASSERT_EQUAL(0, err);
+
+    TCPSocket tx(stack);
+    err = tx.connect(LOOPBACK_ADDR, MBED_CFG_LOOPBACK_PORT);
+    TEST_ASSERT_EQUAL(0, err);
+
+    TCPSocket rx;
+    err = server.accept(&rx);
+    TEST_ASSERT_EQUAL(0, err);
+    rx.set_timeout(5000);
+
+    Timer timer;
+    timer.start();
+
+    Thread thread;
+    thread.start(callback(tcp_writer, &tx));
+
+    int received = 0;
+    while (received < MBED_CFG_LOOPBACK_TCP_SIZE) {
+        int rd = rx.recv(rx_chunk, sizeof(rx_chunk));
+        TEST_ASSERT(rd > 0);
+
+        for (int i = 0; i < rd; i++) {
+            TEST_ASSERT_EQUAL(pattern(received + i), rx_chunk[i]);
+        }
+        received += rd;
+    }
+
+    int us = timer.read_us();
+    thread.join();
+
+    printf("MBED: TCP stream: %d bytes in %d us, %d KiB/s\r\n",
+            received, us, (int)(1000000ull*received / 1024 / us));
+
+    // Closing one end ends the stream at the other
+    tx.close();
+    TEST_ASSERT_EQUAL(0, rx.recv(rx_chunk, sizeof(rx_chunk)));
+
+    rx.close();
+    server.close();
+}
+
+
+// Rounds of small packets, either one call per packet or one per round
+uint8_t tx_buffers[MBED_CFG_LOOPBACK_UDP_COUNT][MBED_CFG_LOOPBACK_UDP_PACKET_SIZE];
+uint8_t rx_buffers[MBED_CFG_LOOPBACK_UDP_COUNT][MBED_CFG_LOOPBACK_UDP_PACKET_SIZE];
+
+template <bool batch>
+void test_udp_pps()
+{
+    UDPSocket rx(stack);
+    int err = rx.bind(MBED_CFG_LOOPBACK_PORT+1);
+    TEST_ASSERT_EQUAL(0, err);
+    rx.set_timeout(500);
+
+    UDPSocket tx(stack);
+    err = tx.bind(MBED_CFG_LOOPBACK_PORT+2);
+    TEST_ASSERT_EQUAL(0, err);
+
+    SocketAddress addr(LOOPBACK_ADDR, MBED_CFG_LOOPBACK_PORT+1);
+    nsapi_datagram_t tx_datagrams[MBED_CFG_LOOPBACK_UDP_COUNT];
+    nsapi_datagram_t rx_datagrams[MBED_CFG_LOOPBACK_UDP_COUNT];
+    for (int i = 0; i < MBED_CFG_LOOPBACK_UDP_COUNT; i++) {
+        memset(tx_buffers[i], i, MBED_CFG_LOOPBACK_UDP_PACKET_SIZE);
+        tx_datagrams[i].addr = addr.get_addr();
+        tx_datagrams[i].port = addr.get_port();
+        tx_datagrams[i].data = tx_buffers[i];
+        tx_datagrams[i].size = MBED_CFG_LOOPBACK_UDP_PACKET_SIZE;
+        rx_datagrams[i].data = rx_buffers[i];
+        rx_datagrams[i].size = MBED_CFG_LOOPBACK_UDP_PACKET_SIZE;
+    }
+
+    Timer timer;
+    timer.start();
+
+    int received = 0;
+    for (int round = 0; round < MBED_CFG_LOOPBACK_UDP_ROUNDS; round++) {
+        if (batch) {
+            int td = tx.sendto_batch(tx_datagrams, MBED_CFG_LOOPBACK_UDP_COUNT);
+            TEST_ASSERT_EQUAL(MBED_CFG_LOOPBACK_UDP_COUNT, td);
+        } else {
+            for (int i = 0; i < MBED_CFG_LOOPBACK_UDP_COUNT; i++) {
+                int td = tx.sendto(addr, tx_buffers[i], MBED_CFG_LOOPBACK_UDP_PACKET_SIZE);
+                TEST_ASSERT_EQUAL(MBED_CFG_LOOPBACK_UDP_PACKET_SIZE, td);
+            }
+        }
+
+        int count = 0;
+        while (count < MBED_CFG_LOOPBACK_UDP_COUNT) {
+            int rd;
+            if (batch) {
+                rd = rx.recvfrom_batch(&rx_datagrams[count], MBED_CFG_LOOPBACK_UDP_COUNT - count);
+            } else {
+                rd = rx.recvfrom(NULL, rx_buffers[count], MBED_CFG_LOOPBACK_UDP_PACKET_SIZE);
+                rd = (rd >= 0) ? 1 : rd;
+            }
+
+            TEST_ASSERT(rd > 0);
+            count += rd;
+        }
+        received += count;
+    }
+
+    int us = timer.read_us();
+    printf("MBED: UDP %s: %d packets of %d bytes in %d us, %d packets/s\r\n",
+            batch ? "sendto_batch/recvfrom_batch" : "sendto/recvfrom",
+            received, MBED_CFG_LOOPBACK_UDP_PACKET_SIZE, us,
+            (int)(1000000ull*received / us));
+
+    // The loopback stack only drops when a queue is full
+    TEST_ASSERT_EQUAL(MBED_CFG_LOOPBACK_UDP_ROUNDS*MBED_CFG_LOOPBACK_UDP_COUNT, received);
+
+    tx.close();
+    rx.close();
+}
+
+
+// Open, connect, accept and close connections one after another
+void test_tcp_connect_rate()
+{
+    TCPServer server(stack);
+    int err = server.bind(MBED_CFG_LOOPBACK_PORT+3);
+    TEST_ASSERT_EQUAL(0, err);
+    err = server.listen(1);
+    TEST_ASSERT_EQUAL(0, err);
+
+    Timer timer;
+    timer.start();
+
+    for (int i = 0; i < MBED_CFG_LOOPBACK_CONNECTIONS; i++) {
+        TCPSocket client(stack);
+        err = client.connect(LOOPBACK_ADDR, MBED_CFG_LOOPBACK_PORT+3);
+        TEST_ASSERT_EQUAL(0, err);
+
+        TCPSocket conn;
+        SocketAddress addr;
+        err = server.accept(&conn, &addr);
+        TEST_ASSERT_EQUAL(0, err);
+
+        client.close();
+        conn.close();
+    }
+
+    int us = timer.read_us();
+    printf("MBED: TCP connect/accept/close: %d connections in %d us, %d connections/s\r\n",
+            MBED_CFG_LOOPBACK_CONNECTIONS, us,
+            (int)(1000000ull*MBED_CFG_LOOPBACK_CONNECTIONS / us));
+
+    // Nobody is listening once the server is gone
+    server.close();
+    TCPSocket client(stack);
+    err = client.connect(LOOPBACK_ADDR, MBED_CFG_LOOPBACK_PORT+3);
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_NO_CONNECTION, err);
+}
+
+
+// Every address is local, so a responder on port 53 answers the queries
+// nsapi_dns sends to its default servers
+volatile bool dns_done;
+
+void dns_responder(UDPSocket *sock)
+{
+    uint8_t packet[512];
+    while (!dns_done) {
+        SocketAddress from;
+        int rd = sock->recvfrom(&from, packet, sizeof(packet));
+        if (rd < 12) {
+            continue;
+        }
+
+        // Turn the query into a response with one A record pointing
+        // back at the question's name
+        SocketAddress answer(DNS_ANSWER);
+        const uint8_t record[] = {
+            0xc0, 0x0c,             // name, pointer to question
+            0x00, 0x01,             // type A
+            0x00, 0x01,             // class IN
+            0x00, 0x00, 0x00, 0x3c, // ttl
+            0x00, 0x04,             // rdlength
+        };
+        if (rd + sizeof(record) + 4 > sizeof(packet)) {
+            continue;
+        }
+
+        packet[2] = 0x81; // response, recursion desired
+        packet[3] = 0x80; // recursion available, no error
+        packet[6] = 0x00; // ancount = 1
+        packet[7] = 0x01;
+        memcpy(&packet[rd], record, sizeof(record));
+        memcpy(&packet[rd + sizeof(record)], answer.get_ip_bytes(), 4);
+
+        sock->sendto(from, packet, rd + sizeof(record) + 4);
+    }
+}
+
+void test_gethostbyname()
+{
+    UDPSocket server(stack);
+    int err = server.bind(53);
+    TEST_ASSERT_EQUAL(0, err);
+    server.set_timeout(100);
+
+    dns_done = false;
+    Thread thread;
+    thread.start(callback(dns_responder, &server));
+
+    Timer timer;
+    timer.start();
+
+    for (int i = 0; i < MBED_CFG_LOOPBACK_LOOKUPS; i++) {
+        SocketAddress addr;
+        err = stack->gethostbyname(DNS_NAME, &addr);
+        TEST_ASSERT_EQUAL(0, err);
+        TEST_ASSERT_EQUAL_STRING(DNS_ANSWER, addr.get_ip_address());
+    }
+
+    int us = timer.read_us();
+    printf("MBED: gethostbyname: %d lookups in %d us, %d us/lookup\r\n",
+            MBED_CFG_LOOPBACK_LOOKUPS, us, us / MBED_CFG_LOOPBACK_LOOKUPS);
+
+    dns_done = true;
+    thread.join();
+    server.close();
+}
+
+
+// Test setup
+utest::v1::status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(120, "default_auto");
+    return verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("TCP stream throughput", test_tcp_throughput),
+    Case("UDP sendto/recvfrom packet rate", test_udp_pps<false>),
+    Case("UDP sendto_batch/recvfrom_batch packet rate", test_udp_pps<true>),
+    Case("TCP connection setup rate", test_tcp_connect_rate),
+    Case("gethostbyname latency", test_gethostbyname),
+};
+
+Specification specification(test_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
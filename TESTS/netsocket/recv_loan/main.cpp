@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2013-2017, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+ #ifndef MBED_CONF_APP_CONNECT_STATEMENT
+     #error [NOT_SUPPORTED] No network configuration found for this target.
+ #endif
+
+#if !MBED_CONF_LWIP_LOOPBACK_ENABLED
+    #error [NOT_SUPPORTED] Loopback tests need lwip.loopback-enabled
+#endif
+
+#include "mbed.h"
+#include MBED_CONF_APP_HEADER_FILE
+#include "TCPSocket.h"
+#include "TCPServer.h"
+#include "UDPSocket.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest.h"
+
+using namespace utest::v1;
+
+
+#ifndef MBED_CFG_RECV_LOAN_SIZE
+#define MBED_CFG_RECV_LOAN_SIZE (1024*1024)
+#endif
+
+#ifndef MBED_CFG_RECV_LOAN_BUFFER_SIZE
+#define MBED_CFG_RECV_LOAN_BUFFER_SIZE 1024
+#endif
+
+#ifndef MBED_CFG_RECV_LOAN_PORT
+#define MBED_CFG_RECV_LOAN_PORT 7007
+#endif
+
+#define LOOPBACK_ADDR "127.0.0.1"
+
+
+NetworkInterface *net;
+uint8_t tx_buffer[MBED_CFG_RECV_LOAN_BUFFER_SIZE];
+uint8_t rx_buffer[MBED_CFG_RECV_LOAN_BUFFER_SIZE];
+
+// Idle loop iterations, used to estimate how much of the
+// benchmark the cpu spent doing actual work
+volatile uint32_t idle_count;
+
+void idle_hook() {
+    idle_count += 1;
+}
+
+// Streams MBED_CFG_RECV_LOAN_SIZE bytes of a counting
+// pattern to the receiving side of the loopback
+void sender(uint16_t *port) {
+    TCPSocket sock;
+    int err = sock.open(net);
+    TEST_ASSERT_EQUAL(0, err);
+    err = sock.connect(LOOPBACK_ADDR, *port);
+    TEST_ASSERT_EQUAL(0, err);
+
+    for (size_t i = 0; i < sizeof(tx_buffer); i++) {
+        tx_buffer[i] = i & 0xff;
+    }
+
+    for (size_t sent = 0; sent < MBED_CFG_RECV_LOAN_SIZE;) {
+        size_t chunk = MBED_CFG_RECV_LOAN_SIZE - sent;
+        if (chunk > sizeof(tx_buffer)) {
+            chunk = sizeof(tx_buffer);
+        }
+
+        int td = sock.send(tx_buffer, chunk);
+        TEST_ASSERT(td > 0);
+        sent += td;
+    }
+
+    sock.close();
+}
+
+// Checks the counting pattern, touching every byte
+// received so both variants do the same work
+size_t check(size_t count, const uint8_t *data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        TEST_ASSERT_EQUAL_UINT8((count + i) % sizeof(tx_buffer) & 0xff, data[i]);
+    }
+
+    return count + size;
+}
+
+template <bool loan>
+void test_tcp_recv() {
+    // calibrate the idle loop while nothing else is running
+    Thread::attach_idle_hook(idle_hook);
+    idle_count = 0;
+    Thread::wait(100);
+    uint32_t idle_per_ms = idle_count / 100;
+
+    // each case gets its own port to avoid connections in TIME_WAIT
+    uint16_t port = MBED_CFG_RECV_LOAN_PORT + loan;
+    TCPServer server;
+    int err = server.open(net);
+    TEST_ASSERT_EQUAL(0, err);
+    err = server.bind(LOOPBACK_ADDR, port);
+    TEST_ASSERT_EQUAL(0, err);
+    err = server.listen(1);
+    TEST_ASSERT_EQUAL(0, err);
+
+    Thread thread(osPriorityNormal, 2048);
+    thread.start(callback(sender, &port));
+
+    TCPSocket sock;
+    err = server.accept(&sock);
+    TEST_ASSERT_EQUAL(0, err);
+
+    Timer timer;
+    timer.start();
+    idle_count = 0;
+
+    size_t count = 0;
+    while (count < MBED_CFG_RECV_LOAN_SIZE) {
+        if (loan) {
+            nsapi_loan_t rx_loan;
+            int rd = sock.recv_loan(&rx_loan);
+            TEST_ASSERT(rd > 0);
+            for (unsigned i = 0; i < rx_loan.count; i++) {
+                count = check(count,
+                        (const uint8_t *)rx_loan.segments[i].iov_base,
+                        rx_loan.segments[i].iov_len);
+            }
+            sock.release(&rx_loan);
+        } else {
+            int rd = sock.recv(rx_buffer, sizeof(rx_buffer));
+            TEST_ASSERT(rd > 0);
+            count = check(count, rx_buffer, rd);
+        }
+    }
+
+    timer.stop();
+    uint32_t idle = idle_count;
+    Thread::attach_idle_hook(NULL);
+    thread.join();
+
+    int us = timer.read_us();
+    int idle_us = idle_per_ms ? (int)(1000ull*idle / idle_per_ms) : 0;
+    int busy_us = us > idle_us ? us - idle_us : 0;
+
+    printf("MBED: %s: %d bytes in %d us, %d KiB/s, %d us cpu per MiB\r\n",
+            loan ? "recv_loan" : "recv", count, us,
+            (int)(1000000ull*count / 1024 / (us ? us : 1)),
+            (int)(1024ull*1024*busy_us / count));
+
+    sock.close();
+    server.close();
+}
+
+void test_udp_recvfrom_loan() {
+    UDPSocket rx;
+    int err = rx.open(net);
+    TEST_ASSERT_EQUAL(0, err);
+    err = rx.bind(LOOPBACK_ADDR, MBED_CFG_RECV_LOAN_PORT+2);
+    TEST_ASSERT_EQUAL(0, err);
+    rx.set_timeout(5000);
+
+    UDPSocket tx;
+    err = tx.open(net);
+    TEST_ASSERT_EQUAL(0, err);
+    err = tx.bind(LOOPBACK_ADDR, MBED_CFG_RECV_LOAN_PORT+3);
+    TEST_ASSERT_EQUAL(0, err);
+
+    for (size_t i = 0; i < sizeof(tx_buffer); i++) {
+        tx_buffer[i] = i & 0xff;
+    }
+
+    // sizes around a single pbuf, and larger than one
+    const size_t sizes[] = {0, 1, 100, 512, sizeof(tx_buffer)};
+    for (size_t i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++) {
+        int td = tx.sendto(LOOPBACK_ADDR, MBED_CFG_RECV_LOAN_PORT+2, tx_buffer, sizes[i]);
+        TEST_ASSERT_EQUAL(sizes[i], td);
+
+        SocketAddress addr;
+        nsapi_loan_t rx_loan;
+        int rd = rx.recvfrom_loan(&addr, &rx_loan);
+        TEST_ASSERT(rd >= 0 && (size_t)rd <= sizes[i]);
+        TEST_ASSERT_EQUAL(rd, rx_loan.size);
+        TEST_ASSERT_EQUAL(MBED_CFG_RECV_LOAN_PORT+3, addr.get_port());
+
+        size_t count = 0;
+        for (unsigned j = 0; j < rx_loan.count; j++) {
+            count = check(count,
+                    (const uint8_t *)rx_loan.segments[j].iov_base,
+                    rx_loan.segments[j].iov_len);
+        }
+        TEST_ASSERT_EQUAL(rd, count);
+        rx.release(&rx_loan);
+    }
+
+    // loans outlive their socket
+    int td = tx.sendto(LOOPBACK_ADDR, MBED_CFG_RECV_LOAN_PORT+2, tx_buffer, 100);
+    TEST_ASSERT_EQUAL(100, td);
+    nsapi_loan_t rx_loan;
+    int rd = rx.recvfrom_loan(NULL, &rx_loan);
+    TEST_ASSERT_EQUAL(100, rd);
+    rx.close();
+    TEST_ASSERT_EQUAL(100, check(0,
+            (const uint8_t *)rx_loan.segments[0].iov_base,
+            rx_loan.segments[0].iov_len));
+    rx.release(&rx_loan);
+
+    tx.close();
+}
+
+
+// Test setup
+utest::v1::status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(120, "default_auto");
+
+    net = MBED_CONF_APP_OBJECT_CONSTRUCTION;
+    int err = MBED_CONF_APP_CONNECT_STATEMENT;
+    TEST_ASSERT_EQUAL(0, err);
+
+    return verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("TCP recv over loopback", test_tcp_recv<false>),
+    Case("TCP recv_loan over loopback", test_tcp_recv<true>),
+    Case("UDP recvfrom_loan over loopback", test_udp_recvfrom_loan),
+};
+
+Specification specification(test_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
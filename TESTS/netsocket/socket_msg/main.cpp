@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2013-2017, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+ #ifndef MBED_CONF_APP_CONNECT_STATEMENT
+     #error [NOT_SUPPORTED] No network configuration found for this target.
+ #endif
+
+#if !MBED_CONF_LWIP_LOOPBACK_ENABLED
+    #error [NOT_SUPPORTED] Loopback tests need lwip.loopback-enabled
+#endif
+
+#include "mbed.h"
+#include MBED_CONF_APP_HEADER_FILE
+#include "TCPSocket.h"
+#include "TCPServer.h"
+#include "UDPSocket.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest.h"
+
+using namespace utest::v1;
+
+
+#ifndef MBED_CFG_SOCKET_MSG_PORT
+#define MBED_CFG_SOCKET_MSG_PORT 7011
+#endif
+
+#define LOOPBACK_ADDR "127.0.0.1"
+
+
+NetworkInterface *net;
+
+// A header and payload sent without assembling them first
+char header[] = "HDR:";
+char empty[] = "";
+char payload[] = "the payload follows the header";
+
+nsapi_iovec_t tx_iov[] = {
+    {header, sizeof(header)-1},
+    {empty, 0},
+    {payload, sizeof(payload)-1},
+};
+
+const char expected[] = "HDR:the payload follows the header";
+
+void test_tcp_msg() {
+    TCPServer server;
+    int err = server.open(net);
+    TEST_ASSERT_EQUAL(0, err);
+    err = server.bind(LOOPBACK_ADDR, MBED_CFG_SOCKET_MSG_PORT);
+    TEST_ASSERT_EQUAL(0, err);
+    err = server.listen(1);
+    TEST_ASSERT_EQUAL(0, err);
+
+    TCPSocket tx;
+    err = tx.open(net);
+    TEST_ASSERT_EQUAL(0, err);
+    tx.set_blocking(false);
+    err = tx.connect(LOOPBACK_ADDR, MBED_CFG_SOCKET_MSG_PORT);
+    TEST_ASSERT(err == 0 || err == NSAPI_ERROR_IN_PROGRESS);
+
+    TCPSocket rx;
+    err = server.accept(&rx);
+    TEST_ASSERT_EQUAL(0, err);
+    tx.set_blocking(true);
+
+    int td = tx.sendmsg(tx_iov, sizeof(tx_iov)/sizeof(tx_iov[0]));
+    TEST_ASSERT_EQUAL(sizeof(expected)-1, td);
+
+    // Receive into buffers that split the data at different points
+    char rx_a[7];
+    char rx_b[sizeof(expected)];
+    char stream[sizeof(expected)] = {0};
+    size_t count = 0;
+    while (count < sizeof(expected)-1) {
+        nsapi_iovec_t rx_iov[] = {{rx_a, sizeof(rx_a)}, {rx_b, sizeof(rx_b)}};
+        int rd = rx.recvmsg(rx_iov, 2);
+        TEST_ASSERT(rd > 0);
+
+        size_t a = ((size_t)rd < sizeof(rx_a)) ? rd : sizeof(rx_a);
+        memcpy(&stream[count], rx_a, a);
+        memcpy(&stream[count+a], rx_b, rd-a);
+        count += rd;
+    }
+
+    TEST_ASSERT_EQUAL_STRING(expected, stream);
+
+    tx.close();
+    rx.close();
+    server.close();
+}
+
+void test_udp_msg() {
+    UDPSocket rx;
+    int err = rx.open(net);
+    TEST_ASSERT_EQUAL(0, err);
+    err = rx.bind(LOOPBACK_ADDR, MBED_CFG_SOCKET_MSG_PORT+1);
+    TEST_ASSERT_EQUAL(0, err);
+    rx.set_timeout(5000);
+
+    UDPSocket tx;
+    err = tx.open(net);
+    TEST_ASSERT_EQUAL(0, err);
+    err = tx.bind(LOOPBACK_ADDR, MBED_CFG_SOCKET_MSG_PORT+2);
+    TEST_ASSERT_EQUAL(0, err);
+
+    SocketAddress addr(LOOPBACK_ADDR, MBED_CFG_SOCKET_MSG_PORT+1);
+    int td = tx.sendmsg(addr, tx_iov, sizeof(tx_iov)/sizeof(tx_iov[0]));
+    TEST_ASSERT_EQUAL(sizeof(expected)-1, td);
+
+    // The packet arrives whole, split over the buffers
+    char rx_a[4];
+    char rx_b[sizeof(expected)] = {0};
+    nsapi_iovec_t rx_iov[] = {{rx_a, sizeof(rx_a)}, {rx_b, sizeof(rx_b)}};
+    SocketAddress from;
+    int rd = rx.recvmsg(&from, rx_iov, 2);
+    TEST_ASSERT_EQUAL(sizeof(expected)-1, rd);
+    TEST_ASSERT_EQUAL(MBED_CFG_SOCKET_MSG_PORT+2, from.get_port());
+    TEST_ASSERT_EQUAL_MEMORY(header, rx_a, sizeof(rx_a));
+    TEST_ASSERT_EQUAL_STRING(payload, rx_b);
+
+    // An empty packet
+    td = tx.sendmsg(addr, tx_iov, 0);
+    TEST_ASSERT_EQUAL(0, td);
+    rd = rx.recvmsg(NULL, rx_iov, 2);
+    TEST_ASSERT_EQUAL(0, rd);
+
+    tx.close();
+    rx.close();
+}
+
+
+// Test setup
+utest::v1::status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(60, "default_auto");
+
+    net = MBED_CONF_APP_OBJECT_CONSTRUCTION;
+    int err = MBED_CONF_APP_CONNECT_STATEMENT;
+    TEST_ASSERT_EQUAL(0, err);
+
+    return verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("TCP sendmsg/recvmsg over loopback", test_tcp_msg),
+    Case("UDP sendmsg/recvmsg over loopback", test_udp_msg),
+};
+
+Specification specification(test_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
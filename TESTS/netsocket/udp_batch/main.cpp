@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2013-2017, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+ #ifndef MBED_CONF_APP_CONNECT_STATEMENT
+     #error [NOT_SUPPORTED] No network configuration found for this target.
+ #endif
+
+#if !MBED_CONF_LWIP_LOOPBACK_ENABLED
+    #error [NOT_SUPPORTED] Loopback tests need lwip.loopback-enabled
+#endif
+
+#include "mbed.h"
+#include MBED_CONF_APP_HEADER_FILE
+#include "UDPSocket.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest.h"
+
+using namespace utest::v1;
+
+
+#ifndef MBED_CFG_UDP_BATCH_PORT
+#define MBED_CFG_UDP_BATCH_PORT 7021
+#endif
+
+// Packets in flight at once, kept within the stack's receive mailbox
+#ifndef MBED_CFG_UDP_BATCH_COUNT
+#define MBED_CFG_UDP_BATCH_COUNT 8
+#endif
+
+#ifndef MBED_CFG_UDP_BATCH_ROUNDS
+#define MBED_CFG_UDP_BATCH_ROUNDS 500
+#endif
+
+#ifndef MBED_CFG_UDP_BATCH_PACKET_SIZE
+#define MBED_CFG_UDP_BATCH_PACKET_SIZE 32
+#endif
+
+#define LOOPBACK_ADDR "127.0.0.1"
+
+
+NetworkInterface *net;
+uint8_t tx_buffers[MBED_CFG_UDP_BATCH_COUNT][MBED_CFG_UDP_BATCH_PACKET_SIZE];
+uint8_t rx_buffers[MBED_CFG_UDP_BATCH_COUNT][MBED_CFG_UDP_BATCH_PACKET_SIZE];
+
+// Sends rounds of small packets to ourselves, either one call per
+// packet or one call per round, and reports the packet rate
+template <bool batch>
+void test_udp_pps()
+{
+    UDPSocket rx;
+    int err = rx.open(net);
+    TEST_ASSERT_EQUAL(0, err);
+    err = rx.bind(LOOPBACK_ADDR, MBED_CFG_UDP_BATCH_PORT);
+    TEST_ASSERT_EQUAL(0, err);
+    rx.set_timeout(500);
+
+    UDPSocket tx;
+    err = tx.open(net);
+    TEST_ASSERT_EQUAL(0, err);
+    err = tx.bind(LOOPBACK_ADDR, MBED_CFG_UDP_BATCH_PORT+1);
+    TEST_ASSERT_EQUAL(0, err);
+
+    SocketAddress addr(LOOPBACK_ADDR, MBED_CFG_UDP_BATCH_PORT);
+    nsapi_datagram_t tx_datagrams[MBED_CFG_UDP_BATCH_COUNT];
+    nsapi_datagram_t rx_datagrams[MBED_CFG_UDP_BATCH_COUNT];
+    for (int i = 0; i < MBED_CFG_UDP_BATCH_COUNT; i++) {
+        memset(tx_buffers[i], i, MBED_CFG_UDP_BATCH_PACKET_SIZE);
+        tx_datagrams[i].addr = addr.get_addr();
+        tx_datagrams[i].port = addr.get_port();
+        tx_datagrams[i].data = tx_buffers[i];
+        tx_datagrams[i].size = MBED_CFG_UDP_BATCH_PACKET_SIZE;
+        rx_datagrams[i].data = rx_buffers[i];
+        rx_datagrams[i].size = MBED_CFG_UDP_BATCH_PACKET_SIZE;
+    }
+
+    Timer timer;
+    timer.start();
+
+    int sent = 0;
+    int received = 0;
+    for (int round = 0; round < MBED_CFG_UDP_BATCH_ROUNDS; round++) {
+        if (batch) {
+            int td = tx.sendto_batch(tx_datagrams, MBED_CFG_UDP_BATCH_COUNT);
+            TEST_ASSERT_EQUAL(MBED_CFG_UDP_BATCH_COUNT, td);
+        } else {
+            for (int i = 0; i < MBED_CFG_UDP_BATCH_COUNT; i++) {
+                int td = tx.sendto(addr, tx_buffers[i], MBED_CFG_UDP_BATCH_PACKET_SIZE);
+                TEST_ASSERT_EQUAL(MBED_CFG_UDP_BATCH_PACKET_SIZE, td);
+            }
+        }
+        sent += MBED_CFG_UDP_BATCH_COUNT;
+
+        // Loopback may drop, so stop the round on a timeout
+        int count = 0;
+        while (count < MBED_CFG_UDP_BATCH_COUNT) {
+            int rd;
+            if (batch) {
+                rd = rx.recvfrom_batch(&rx_datagrams[count], MBED_CFG_UDP_BATCH_COUNT - count);
+            } else {
+                rd = rx.recvfrom(NULL, rx_buffers[count], MBED_CFG_UDP_BATCH_PACKET_SIZE);
+                rd = (rd >= 0) ? 1 : rd;
+            }
+
+            if (rd == NSAPI_ERROR_WOULD_BLOCK) {
+                break;
+            }
+            TEST_ASSERT(rd > 0);
+            count += rd;
+        }
+        received += count;
+    }
+
+    int us = timer.read_us();
+    printf("MBED: %s: %d/%d packets of %d bytes in %d us, %d packets/s\r\n",
+            batch ? "sendto_batch/recvfrom_batch" : "sendto/recvfrom",
+            received, sent, MBED_CFG_UDP_BATCH_PACKET_SIZE, us,
+            (int)(1000000ull*received / us));
+
+    // Drops over loopback should be rare
+    TEST_ASSERT(received >= sent - sent/100);
+
+    tx.close();
+    rx.close();
+}
+
+void test_udp_batch_contents()
+{
+    UDPSocket rx;
+    int err = rx.open(net);
+    TEST_ASSERT_EQUAL(0, err);
+    err = rx.bind(LOOPBACK_ADDR, MBED_CFG_UDP_BATCH_PORT+2);
+    TEST_ASSERT_EQUAL(0, err);
+    rx.set_timeout(5000);
+
+    UDPSocket tx;
+    err = tx.open(net);
+    TEST_ASSERT_EQUAL(0, err);
+    err = tx.bind(LOOPBACK_ADDR, MBED_CFG_UDP_BATCH_PORT+3);
+    TEST_ASSERT_EQUAL(0, err);
+
+    // Packets of different sizes, including an empty one
+    SocketAddress addr(LOOPBACK_ADDR, MBED_CFG_UDP_BATCH_PORT+2);
+    nsapi_datagram_t tx_datagrams[3];
+    for (int i = 0; i < 3; i++) {
+        memset(tx_buffers[i], 'a'+i, MBED_CFG_UDP_BATCH_PACKET_SIZE);
+        tx_datagrams[i].addr = addr.get_addr();
+        tx_datagrams[i].port = addr.get_port();
+        tx_datagrams[i].data = tx_buffers[i];
+        tx_datagrams[i].size = 3*i;
+    }
+
+    int td = tx.sendto_batch(tx_datagrams, 3);
+    TEST_ASSERT_EQUAL(3, td);
+
+    nsapi_datagram_t rx_datagrams[4];
+    for (int i = 0; i < 4; i++) {
+        rx_datagrams[i].data = rx_buffers[i];
+        rx_datagrams[i].size = MBED_CFG_UDP_BATCH_PACKET_SIZE;
+    }
+
+    int count = 0;
+    while (count < 3) {
+        int rd = rx.recvfrom_batch(&rx_datagrams[count], 4 - count);
+        TEST_ASSERT(rd > 0);
+        count += rd;
+    }
+    TEST_ASSERT_EQUAL(3, count);
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(3*i, rx_datagrams[i].length);
+        TEST_ASSERT_EQUAL(MBED_CFG_UDP_BATCH_PORT+3, rx_datagrams[i].port);
+        if (rx_datagrams[i].length) {
+            TEST_ASSERT_EQUAL_MEMORY(tx_buffers[i], rx_buffers[i], rx_datagrams[i].length);
+        }
+    }
+
+    // Nothing left to receive
+    rx.set_blocking(false);
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_WOULD_BLOCK, rx.recvfrom_batch(rx_datagrams, 4));
+
+    tx.close();
+    rx.close();
+}
+
+
+// Test setup
+utest::v1::status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(120, "default_auto");
+
+    net = MBED_CONF_APP_OBJECT_CONSTRUCTION;
+    int err = MBED_CONF_APP_CONNECT_STATEMENT;
+    TEST_ASSERT_EQUAL(0, err);
+
+    return verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("UDP sendto_batch/recvfrom_batch contents", test_udp_batch_contents),
+    Case("UDP packet rate, sendto/recvfrom", test_udp_pps<false>),
+    Case("UDP packet rate, sendto_batch/recvfrom_batch", test_udp_pps<true>),
+};
+
+Specification specification(test_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
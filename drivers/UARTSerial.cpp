@@ -133,6 +133,17 @@ void UARTSerial::sigio(Callback<void()> func) {
     core_util_critical_section_exit();
 }
 
+bool UARTSerial::attach_poll(PollListener *listener)
+{
+    _poll_listeners.attach(listener);
+    return true;
+}
+
+void UARTSerial::detach_poll(PollListener *listener)
+{
+    _poll_listeners.detach(listener);
+}
+
 ssize_t UARTSerial::write(const void* buffer, size_t length)
 {
     size_t data_written = 0;
@@ -233,6 +244,7 @@ void UARTSerial::wake()
     if (_sigio_cb) {
         _sigio_cb();
     }
+    _poll_listeners.wake();
 }
 
 short UARTSerial::poll(short events) const {
@@ -161,6 +161,21 @@ public:
      */
     virtual void sigio(Callback<void()> func);
 
+    /** Attach a listener woken on state change of the serial port
+     *
+     *  @see FileHandle::attach_poll
+     *
+     *  @param listener Listener to attach, must stay valid until detached
+     *  @return         true, the listener is woken wherever sigio() would be
+     */
+    virtual bool attach_poll(PollListener *listener);
+
+    /** Detach a listener attached with attach_poll()
+     *
+     *  @param listener Listener to detach
+     */
+    virtual void detach_poll(PollListener *listener);
+
     /** Setup interrupt handler for DCD line
      *
      *  If DCD line is connected, an IRQ handler will be setup.
@@ -238,6 +253,7 @@ private:
     PlatformMutex _mutex;
 
     Callback<void()> _sigio_cb;
+    PollListenerList _poll_listeners;
 
     bool _blocking;
     bool _tx_irq_enabled;
@@ -56,6 +56,7 @@ public:
             _event->equeue = &q->_equeue;
             _event->id = 0;
             _event->delay = 0;
+            _event->slack = 0;
             _event->period = -1;
 
             _event->post = &Event::event_post<F>;
@@ -120,6 +121,20 @@ public:
         }
     }
 
+    /** Configure the slack of an event
+     *
+     *  The event may be dispatched up to the slack later than its delay
+     *  or period would require, allowing the event queue to batch it with
+     *  other events into a single wakeup.
+     *
+     *  @param slack    Millisecond tolerance for dispatching the event late
+     */
+    void slack(int slack) {
+        if (_event) {
+            _event->slack = slack;
+        }
+    }
+
     /** Posts an event onto the underlying event queue
      *
      *  The event is posted to the underlying queue and is executed in the
@@ -189,6 +204,7 @@ private:
 
         int delay;
         int period;
+        int slack;
 
         int (*post)(struct event *);
         void (*dtor)(struct event *);
@@ -208,6 +224,7 @@ private:
         new (p) C(*(F*)(e + 1));
         equeue_event_delay(p, e->delay);
         equeue_event_period(p, e->period);
+        equeue_event_slack(p, e->slack);
         equeue_event_dtor(p, &EventQueue::function_dtor<C>);
         return equeue_post(e->equeue, &EventQueue::function_call<C>, p);
     }
@@ -470,6 +487,7 @@ public:
             _event->equeue = &q->_equeue;
             _event->id = 0;
             _event->delay = 0;
+            _event->slack = 0;
             _event->period = -1;
 
             _event->post = &Event::event_post<F>;
@@ -534,6 +552,20 @@ public:
         }
     }
 
+    /** Configure the slack of an event
+     *
+     *  The event may be dispatched up to the slack later than its delay
+     *  or period would require, allowing the event queue to batch it with
+     *  other events into a single wakeup.
+     *
+     *  @param slack    Millisecond tolerance for dispatching the event late
+     */
+    void slack(int slack) {
+        if (_event) {
+            _event->slack = slack;
+        }
+    }
+
     /** Posts an event onto the underlying event queue
      *
      *  The event is posted to the underlying queue and is executed in the
@@ -607,6 +639,7 @@ private:
 
         int delay;
         int period;
+        int slack;
 
         int (*post)(struct event *, A0 a0);
         void (*dtor)(struct event *);
@@ -626,6 +659,7 @@ private:
         new (p) C(*(F*)(e + 1), a0);
         equeue_event_delay(p, e->delay);
         equeue_event_period(p, e->period);
+        equeue_event_slack(p, e->slack);
         equeue_event_dtor(p, &EventQueue::function_dtor<C>);
         return equeue_post(e->equeue, &EventQueue::function_call<C>, p);
     }
@@ -888,6 +922,7 @@ public:
             _event->equeue = &q->_equeue;
             _event->id = 0;
             _event->delay = 0;
+            _event->slack = 0;
             _event->period = -1;
 
             _event->post = &Event::event_post<F>;
@@ -952,6 +987,20 @@ public:
         }
     }
 
+    /** Configure the slack of an event
+     *
+     *  The event may be dispatched up to the slack later than its delay
+     *  or period would require, allowing the event queue to batch it with
+     *  other events into a single wakeup.
+     *
+     *  @param slack    Millisecond tolerance for dispatching the event late
+     */
+    void slack(int slack) {
+        if (_event) {
+            _event->slack = slack;
+        }
+    }
+
     /** Posts an event onto the underlying event queue
      *
      *  The event is posted to the underlying queue and is executed in the
@@ -1025,6 +1074,7 @@ private:
 
         int delay;
         int period;
+        int slack;
 
         int (*post)(struct event *, A0 a0, A1 a1);
         void (*dtor)(struct event *);
@@ -1044,6 +1094,7 @@ private:
         new (p) C(*(F*)(e + 1), a0, a1);
         equeue_event_delay(p, e->delay);
         equeue_event_period(p, e->period);
+        equeue_event_slack(p, e->slack);
         equeue_event_dtor(p, &EventQueue::function_dtor<C>);
         return equeue_post(e->equeue, &EventQueue::function_call<C>, p);
     }
@@ -1306,6 +1357,7 @@ public:
             _event->equeue = &q->_equeue;
             _event->id = 0;
             _event->delay = 0;
+            _event->slack = 0;
             _event->period = -1;
 
             _event->post = &Event::event_post<F>;
@@ -1370,6 +1422,20 @@ public:
         }
     }
 
+    /** Configure the slack of an event
+     *
+     *  The event may be dispatched up to the slack later than its delay
+     *  or period would require, allowing the event queue to batch it with
+     *  other events into a single wakeup.
+     *
+     *  @param slack    Millisecond tolerance for dispatching the event late
+     */
+    void slack(int slack) {
+        if (_event) {
+            _event->slack = slack;
+        }
+    }
+
     /** Posts an event onto the underlying event queue
      *
      *  The event is posted to the underlying queue and is executed in the
@@ -1443,6 +1509,7 @@ private:
 
         int delay;
         int period;
+        int slack;
 
         int (*post)(struct event *, A0 a0, A1 a1, A2 a2);
         void (*dtor)(struct event *);
@@ -1462,6 +1529,7 @@ private:
         new (p) C(*(F*)(e + 1), a0, a1, a2);
         equeue_event_delay(p, e->delay);
         equeue_event_period(p, e->period);
+        equeue_event_slack(p, e->slack);
         equeue_event_dtor(p, &EventQueue::function_dtor<C>);
         return equeue_post(e->equeue, &EventQueue::function_call<C>, p);
     }
@@ -1724,6 +1792,7 @@ public:
             _event->equeue = &q->_equeue;
             _event->id = 0;
             _event->delay = 0;
+            _event->slack = 0;
             _event->period = -1;
 
             _event->post = &Event::event_post<F>;
@@ -1788,6 +1857,20 @@ public:
         }
     }
 
+    /** Configure the slack of an event
+     *
+     *  The event may be dispatched up to the slack later than its delay
+     *  or period would require, allowing the event queue to batch it with
+     *  other events into a single wakeup.
+     *
+     *  @param slack    Millisecond tolerance for dispatching the event late
+     */
+    void slack(int slack) {
+        if (_event) {
+            _event->slack = slack;
+        }
+    }
+
     /** Posts an event onto the underlying event queue
      *
      *  The event is posted to the underlying queue and is executed in the
@@ -1861,6 +1944,7 @@ private:
 
         int delay;
         int period;
+        int slack;
 
         int (*post)(struct event *, A0 a0, A1 a1, A2 a2, A3 a3);
         void (*dtor)(struct event *);
@@ -1880,6 +1964,7 @@ private:
         new (p) C(*(F*)(e + 1), a0, a1, a2, a3);
         equeue_event_delay(p, e->delay);
         equeue_event_period(p, e->period);
+        equeue_event_slack(p, e->slack);
         equeue_event_dtor(p, &EventQueue::function_dtor<C>);
         return equeue_post(e->equeue, &EventQueue::function_call<C>, p);
     }
@@ -2142,6 +2227,7 @@ public:
             _event->equeue = &q->_equeue;
             _event->id = 0;
             _event->delay = 0;
+            _event->slack = 0;
             _event->period = -1;
 
             _event->post = &Event::event_post<F>;
@@ -2206,6 +2292,20 @@ public:
         }
     }
 
+    /** Configure the slack of an event
+     *
+     *  The event may be dispatched up to the slack later than its delay
+     *  or period would require, allowing the event queue to batch it with
+     *  other events into a single wakeup.
+     *
+     *  @param slack    Millisecond tolerance for dispatching the event late
+     */
+    void slack(int slack) {
+        if (_event) {
+            _event->slack = slack;
+        }
+    }
+
     /** Posts an event onto the underlying event queue
      *
      *  The event is posted to the underlying queue and is executed in the
@@ -2279,6 +2379,7 @@ private:
 
         int delay;
         int period;
+        int slack;
 
         int (*post)(struct event *, A0 a0, A1 a1, A2 a2, A3 a3, A4 a4);
         void (*dtor)(struct event *);
@@ -2298,6 +2399,7 @@ private:
         new (p) C(*(F*)(e + 1), a0, a1, a2, a3, a4);
         equeue_event_delay(p, e->delay);
         equeue_event_period(p, e->period);
+        equeue_event_slack(p, e->slack);
         equeue_event_dtor(p, &EventQueue::function_dtor<C>);
         return equeue_post(e->equeue, &EventQueue::function_call<C>, p);
     }
@@ -76,6 +76,10 @@ public:
      *  to terminate. When called with a timeout of 0, the dispatch function
      *  does not wait and is irq safe.
      *
+     *  If the events.parallel-dispatch option is enabled, dispatch may be
+     *  called from multiple threads to run events concurrently. Events that
+     *  must not run concurrently can be posted with call_serialized.
+     *
      *  @param ms       Time to wait for events in milliseconds, a negative
      *                  value will dispatch events indefinitely
      *                  (default to -1)
@@ -94,7 +98,8 @@ public:
     /** Break out of a running event loop
      *
      *  Forces the specified event queue's dispatch loop to terminate. Pending
-     *  events may finish executing, but no new events will be executed.
+     *  events may finish executing, but no new events will be executed. Each
+     *  call terminates a single dispatch loop.
      */
     void break_dispatch();
 
@@ -426,6 +431,92 @@ public:
         return call(mbed::callback(obj, method), a0, a1, a2, a3, a4);
     }
 
+#if defined(EQUEUE_PARALLEL_DISPATCH) || defined(DOXYGEN_ONLY)
+    /** Calls an event on the queue serialized by a key
+     *
+     *  The specified callback will be executed in the context of one of the
+     *  event queue's dispatch loops. Events posted with the same nonzero key
+     *  never execute concurrently and are executed in the order they were
+     *  posted.
+     *
+     *  The call_serialized function is irq safe and is only available if
+     *  the events.parallel-dispatch option is enabled.
+     *
+     *  @param key      Key identifying events that must be serialized
+     *  @param f        Function to execute in the context of the dispatch loop
+     *  @return         A unique id that represents the posted event and can
+     *                  be passed to cancel, or an id of 0 if there is not
+     *                  enough memory to allocate the event.
+     */
+    template <typename F>
+    int call_serialized(uintptr_t key, F f) {
+        void *p = equeue_alloc(&_equeue, sizeof(F));
+        if (!p) {
+            return 0;
+        }
+
+        F *e = new (p) F(f);
+        equeue_event_key(e, key);
+        equeue_event_dtor(e, &EventQueue::function_dtor<F>);
+        return equeue_post(&_equeue, &EventQueue::function_call<F>, e);
+    }
+
+    /** Calls an event on the queue serialized by a key
+     *  @see                        EventQueue::call_serialized
+     *  @param key                  Key identifying events that must be serialized
+     *  @param f                    Function to execute in the context of the dispatch loop
+     *  @param a0                   Argument to pass to the callback
+     */
+    template <typename F, typename A0>
+    int call_serialized(uintptr_t key, F f, A0 a0) {
+        return call_serialized(key, context10<F, A0>(f, a0));
+    }
+
+    /** Calls an event on the queue serialized by a key
+     *  @see                        EventQueue::call_serialized
+     *  @param key                  Key identifying events that must be serialized
+     *  @param f                    Function to execute in the context of the dispatch loop
+     *  @param a0,a1                Arguments to pass to the callback
+     */
+    template <typename F, typename A0, typename A1>
+    int call_serialized(uintptr_t key, F f, A0 a0, A1 a1) {
+        return call_serialized(key, context20<F, A0, A1>(f, a0, a1));
+    }
+
+    /** Calls an event on the queue serialized by a key
+     *  @see                        EventQueue::call_serialized
+     *  @param key                  Key identifying events that must be serialized
+     *  @param f                    Function to execute in the context of the dispatch loop
+     *  @param a0,a1,a2             Arguments to pass to the callback
+     */
+    template <typename F, typename A0, typename A1, typename A2>
+    int call_serialized(uintptr_t key, F f, A0 a0, A1 a1, A2 a2) {
+        return call_serialized(key, context30<F, A0, A1, A2>(f, a0, a1, a2));
+    }
+
+    /** Calls an event on the queue serialized by a key
+     *  @see                        EventQueue::call_serialized
+     *  @param key                  Key identifying events that must be serialized
+     *  @param f                    Function to execute in the context of the dispatch loop
+     *  @param a0,a1,a2,a3          Arguments to pass to the callback
+     */
+    template <typename F, typename A0, typename A1, typename A2, typename A3>
+    int call_serialized(uintptr_t key, F f, A0 a0, A1 a1, A2 a2, A3 a3) {
+        return call_serialized(key, context40<F, A0, A1, A2, A3>(f, a0, a1, a2, a3));
+    }
+
+    /** Calls an event on the queue serialized by a key
+     *  @see                        EventQueue::call_serialized
+     *  @param key                  Key identifying events that must be serialized
+     *  @param f                    Function to execute in the context of the dispatch loop
+     *  @param a0,a1,a2,a3,a4       Arguments to pass to the callback
+     */
+    template <typename F, typename A0, typename A1, typename A2, typename A3, typename A4>
+    int call_serialized(uintptr_t key, F f, A0 a0, A1 a1, A2 a2, A3 a3, A4 a4) {
+        return call_serialized(key, context50<F, A0, A1, A2, A3, A4>(f, a0, a1, a2, a3, a4));
+    }
+#endif
+
     /** Calls an event on the queue after a specified delay
      *
      *  The specified callback will be executed in the context of the event
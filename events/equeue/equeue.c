@@ -34,6 +34,18 @@ static inline int equeue_clampdiff(unsigned a, unsigned b) {
     return ~(diff >> (8*sizeof(int)-1)) & diff;
 }
 
+// Round a target up to the coarsest power-of-two tick boundary that is
+// within the slack, so events with overlapping windows land on the same
+// tick and are dispatched in a single wakeup
+static inline unsigned equeue_slacktarget(unsigned target, unsigned slack) {
+    unsigned mask = 0;
+    while (((mask << 1) | 1) <= slack) {
+        mask = (mask << 1) | 1;
+    }
+
+    return (target + mask) & ~mask;
+}
+
 // Increment the unique id in an event, hiding the event from cancel
 static inline void equeue_incid(equeue_t *q, struct equeue_event *e) {
     e->id += 1;
@@ -66,14 +78,32 @@ int equeue_create_inplace(equeue_t *q, size_t size, void *buffer) {
         q->npw2++;
     }
 
-    q->chunks = 0;
+    for (int i = 0; i < EQUEUE_MEM_BINS; i++) {
+        q->chunks[i] = 0;
+    }
+
     q->slab.size = size;
     q->slab.data = buffer;
 
+    q->usage.allocated = 0;
+    q->usage.high_water = 0;
+    q->usage.failures = 0;
+
     q->queue = 0;
+#ifdef EQUEUE_STAGED_POST
+    q->staged = 0;
+#endif
+#ifdef EQUEUE_PARALLEL_DISPATCH
+    q->ready = 0;
+    q->running = 0;
+#endif
     q->tick = equeue_tick();
     q->generation = 0;
     q->breaks = 0;
+    q->wakeups = 0;
+#ifdef EQUEUE_HEAP_QUEUE
+    q->seq = 0;
+#endif
 
     q->background.active = false;
     q->background.update = 0;
@@ -99,15 +129,45 @@ int equeue_create_inplace(equeue_t *q, size_t size, void *buffer) {
     return 0;
 }
 
+#ifdef EQUEUE_HEAP_QUEUE
+static void equeue_queue_remove(equeue_t *q, struct equeue_event *e);
+#endif
+
 void equeue_destroy(equeue_t *q) {
     // call destructors on pending events
+#ifdef EQUEUE_PARALLEL_DISPATCH
+    for (struct equeue_event *e = q->ready; e; e = e->next) {
+        if (e->dtor) {
+            e->dtor(e + 1);
+        }
+    }
+#endif
+
+#ifdef EQUEUE_STAGED_POST
+    for (struct equeue_event *e = q->staged; e; e = e->next) {
+        if (e->dtor) {
+            e->dtor(e + 1);
+        }
+    }
+#endif
+
+#ifdef EQUEUE_HEAP_QUEUE
+    while (q->queue) {
+        struct equeue_event *e = q->queue;
+        equeue_queue_remove(q, e);
+        if (e->dtor) {
+            e->dtor(e + 1);
+        }
+    }
+#else
     for (struct equeue_event *es = q->queue; es; es = es->next) {
-        for (struct equeue_event *e = q->queue; e; e = e->sibling) {
+        for (struct equeue_event *e = es; e; e = e->sibling) {
             if (e->dtor) {
                 e->dtor(e + 1);
             }
         }
     }
+#endif
 
     // notify background timer
     if (q->background.update) {
@@ -123,6 +183,32 @@ void equeue_destroy(equeue_t *q) {
 
 
 // equeue chunk allocation functions
+// Free chunks are binned by power-of-two size class relative to the size
+// of the event header. Each bin is a stack of chunks linked through next.
+// Every chunk in a larger class fits any request in a smaller class, so
+// only the head of a bin ever needs to be checked.
+static inline unsigned equeue_mem_bin(size_t size) {
+    unsigned bin = 0;
+    for (size_t s = size / sizeof(struct equeue_event); s > 1; s >>= 1) {
+        bin++;
+    }
+
+    return bin < EQUEUE_MEM_BINS ? bin : EQUEUE_MEM_BINS-1;
+}
+
+static inline struct equeue_event *equeue_mem_take(struct equeue_event **p) {
+    struct equeue_event *e = *p;
+    *p = e->next;
+    return e;
+}
+
+static inline void equeue_mem_claim(equeue_t *q, struct equeue_event *e) {
+    q->usage.allocated += e->size;
+    if (q->usage.allocated > q->usage.high_water) {
+        q->usage.high_water = q->usage.allocated;
+    }
+}
+
 static struct equeue_event *equeue_mem_alloc(equeue_t *q, size_t size) {
     // add event overhead
     size += sizeof(struct equeue_event);
@@ -130,20 +216,14 @@ static struct equeue_event *equeue_mem_alloc(equeue_t *q, size_t size) {
 
     equeue_mutex_lock(&q->memlock);
 
-    // check if a good chunk is available
-    for (struct equeue_event **p = &q->chunks; *p; p = &(*p)->next) {
-        if ((*p)->size >= size) {
-            struct equeue_event *e = *p;
-            if (e->sibling) {
-                *p = e->sibling;
-                (*p)->next = e->next;
-            } else {
-                *p = e->next;
-            }
+    // check if the most recently freed chunk in the size class fits
+    unsigned bin = equeue_mem_bin(size);
+    if (q->chunks[bin] && q->chunks[bin]->size >= size) {
+        struct equeue_event *e = equeue_mem_take(&q->chunks[bin]);
+        equeue_mem_claim(q, e);
 
-            equeue_mutex_unlock(&q->memlock);
-            return e;
-        }
+        equeue_mutex_unlock(&q->memlock);
+        return e;
     }
 
     // otherwise allocate a new chunk out of the slab
@@ -153,36 +233,72 @@ static struct equeue_event *equeue_mem_alloc(equeue_t *q, size_t size) {
         q->slab.size -= size;
         e->size = size;
         e->id = 1;
+        equeue_mem_claim(q, e);
 
         equeue_mutex_unlock(&q->memlock);
         return e;
     }
 
+    // fall back to the head of a larger size class
+    for (unsigned b = bin+1; b < EQUEUE_MEM_BINS; b++) {
+        if (q->chunks[b]) {
+            struct equeue_event *e = equeue_mem_take(&q->chunks[b]);
+            equeue_mem_claim(q, e);
+
+            equeue_mutex_unlock(&q->memlock);
+            return e;
+        }
+    }
+
+    // before failing, look for any chunk in the size class that fits
+    for (struct equeue_event **p = &q->chunks[bin]; *p; p = &(*p)->next) {
+        if ((*p)->size >= size) {
+            struct equeue_event *e = equeue_mem_take(p);
+            equeue_mem_claim(q, e);
+
+            equeue_mutex_unlock(&q->memlock);
+            return e;
+        }
+    }
+
+    q->usage.failures += 1;
     equeue_mutex_unlock(&q->memlock);
     return 0;
 }
 
 static void equeue_mem_dealloc(equeue_t *q, struct equeue_event *e) {
     equeue_mutex_lock(&q->memlock);
+    q->usage.allocated -= e->size;
 
-    // stick chunk into list of chunks
-    struct equeue_event **p = &q->chunks;
-    while (*p && (*p)->size < e->size) {
-        p = &(*p)->next;
-    }
-
-    if (*p && (*p)->size == e->size) {
-        e->sibling = *p;
-        e->next = (*p)->next;
-    } else {
-        e->sibling = 0;
-        e->next = *p;
-    }
+    // push chunk onto its size class, chunks keep their boundaries so
+    // stale ids only ever point at event headers
+    struct equeue_event **p = &q->chunks[equeue_mem_bin(e->size)];
+    e->next = *p;
     *p = e;
 
     equeue_mutex_unlock(&q->memlock);
 }
 
+void equeue_stats(equeue_t *q, struct equeue_stats *stats) {
+    equeue_mutex_lock(&q->memlock);
+    stats->size = (q->slab.data - q->buffer) + q->slab.size;
+    stats->allocated = q->usage.allocated;
+    stats->high_water = q->usage.high_water;
+    stats->slab = q->slab.size;
+    stats->fragmented = 0;
+    stats->chunks = 0;
+    stats->failures = q->usage.failures;
+    stats->wakeups = q->wakeups;
+
+    for (unsigned bin = 0; bin < EQUEUE_MEM_BINS; bin++) {
+        for (struct equeue_event *e = q->chunks[bin]; e; e = e->next) {
+            stats->fragmented += e->size;
+            stats->chunks += 1;
+        }
+    }
+    equeue_mutex_unlock(&q->memlock);
+}
+
 void *equeue_alloc(equeue_t *q, size_t size) {
     struct equeue_event *e = equeue_mem_alloc(q, size);
     if (!e) {
@@ -192,6 +308,10 @@ void *equeue_alloc(equeue_t *q, size_t size) {
     e->target = 0;
     e->period = -1;
     e->dtor = 0;
+    e->slack = 0;
+#ifdef EQUEUE_PARALLEL_DISPATCH
+    e->key = 0;
+#endif
 
     return e + 1;
 }
@@ -208,14 +328,118 @@ void equeue_dealloc(equeue_t *q, void *p) {
 
 
 // equeue scheduling functions
-static int equeue_enqueue(equeue_t *q, struct equeue_event *e, unsigned tick) {
-    // setup event and hash local id with buffer offset for unique id
-    int id = (e->id << q->npw2) | ((unsigned char *)e - q->buffer);
-    e->target = tick + equeue_clampdiff(e->target, tick);
-    e->generation = q->generation;
+#ifdef EQUEUE_HEAP_QUEUE
+// Pending events are stored in a pairing heap ordered by target tick. Ties
+// are broken by insertion order so events with the same target are still
+// dispatched in the order they were posted. In the heap, next points to
+// an event's first child, sibling points to the next child of the event's
+// parent, and ref points to whichever pointer references the event.
+static inline bool equeue_heap_before(
+        struct equeue_event *a, struct equeue_event *b) {
+    int diff = equeue_tickdiff(a->target, b->target);
+    return diff < 0 || (diff == 0 && (int)(a->seq - b->seq) < 0);
+}
 
-    equeue_mutex_lock(&q->queuelock);
+// link two heap roots, returning the new root, the new root's sibling
+// and ref are left for the caller to update
+static struct equeue_event *equeue_heap_meld(
+        struct equeue_event *a, struct equeue_event *b) {
+    if (equeue_heap_before(b, a)) {
+        struct equeue_event *t = a;
+        a = b;
+        b = t;
+    }
+
+    b->sibling = a->next;
+    if (b->sibling) {
+        b->sibling->ref = &b->sibling;
+    }
+
+    a->next = b;
+    b->ref = &a->next;
+    return a;
+}
+
+// combine a list of sibling heaps with the standard two-pass pairing
+static struct equeue_event *equeue_heap_merge(struct equeue_event *es) {
+    // pair up siblings left to right, collecting the pairs in reverse
+    struct equeue_event *pairs = 0;
+    while (es) {
+        struct equeue_event *a = es;
+        struct equeue_event *b = a->sibling;
+        if (b) {
+            es = b->sibling;
+            a = equeue_heap_meld(a, b);
+        } else {
+            es = 0;
+        }
+
+        a->sibling = pairs;
+        pairs = a;
+    }
+
+    // meld the pairs right to left into a single heap
+    struct equeue_event *root = 0;
+    while (pairs) {
+        struct equeue_event *a = pairs;
+        pairs = a->sibling;
+        root = root ? equeue_heap_meld(root, a) : a;
+    }
+
+    return root;
+}
+
+static void equeue_heap_setroot(equeue_t *q, struct equeue_event *e) {
+    q->queue = e;
+    if (e) {
+        e->sibling = 0;
+        e->ref = &q->queue;
+    }
+}
+
+static void equeue_queue_insert(equeue_t *q, struct equeue_event *e) {
+    e->seq = q->seq++;
+    e->next = 0;
+    e->sibling = 0;
+
+    equeue_heap_setroot(q, q->queue ? equeue_heap_meld(q->queue, e) : e);
+}
+
+static void equeue_queue_remove(equeue_t *q, struct equeue_event *e) {
+    // cut the event's subtree out of the heap
+    *e->ref = e->sibling;
+    if (e->sibling) {
+        e->sibling->ref = e->ref;
+    }
+
+    // and meld the event's children back in
+    struct equeue_event *es = equeue_heap_merge(e->next);
+    if (es) {
+        equeue_heap_setroot(q, q->queue ? equeue_heap_meld(q->queue, es) : es);
+    }
+}
+
+static struct equeue_event *equeue_queue_pop(equeue_t *q, unsigned target) {
+    // pop expired events in order, which already matches insertion order
+    struct equeue_event *head = 0;
+    struct equeue_event **tail = &head;
+    while (q->queue && equeue_tickdiff(q->queue->target, target) <= 0) {
+        struct equeue_event *e = q->queue;
+        equeue_heap_setroot(q, equeue_heap_merge(e->next));
 
+        e->next = 0;
+        *tail = e;
+        tail = &e->next;
+    }
+
+    return head;
+}
+#else
+// Pending events are stored in a list of slots sorted by target tick. Each
+// slot is linked through next and holds a stack of events with the same
+// target linked through sibling. The ref pointer points to whichever pointer
+// references the event.
+static void equeue_queue_insert(equeue_t *q, struct equeue_event *e) {
     // find the event slot
     struct equeue_event **p = &q->queue;
     while (*p && equeue_tickdiff((*p)->target, e->target) < 0) {
@@ -230,6 +454,7 @@ static int equeue_enqueue(equeue_t *q, struct equeue_event *e, unsigned tick) {
         }
 
         e->sibling = *p;
+        e->sibling->next = 0;
         e->sibling->ref = &e->sibling;
     } else {
         e->next = *p;
@@ -242,6 +467,116 @@ static int equeue_enqueue(equeue_t *q, struct equeue_event *e, unsigned tick) {
 
     *p = e;
     e->ref = p;
+}
+
+static void equeue_queue_remove(equeue_t *q, struct equeue_event *e) {
+    (void)q;
+
+    // disentangle from queue
+    if (e->sibling) {
+        e->sibling->next = e->next;
+        if (e->sibling->next) {
+            e->sibling->next->ref = &e->sibling->next;
+        }
+
+        *e->ref = e->sibling;
+        e->sibling->ref = e->ref;
+    } else {
+        *e->ref = e->next;
+        if (e->next) {
+            e->next->ref = e->ref;
+        }
+    }
+}
+
+static struct equeue_event *equeue_queue_pop(equeue_t *q, unsigned target) {
+    struct equeue_event *head = q->queue;
+    struct equeue_event **p = &head;
+    while (*p && equeue_tickdiff((*p)->target, target) <= 0) {
+        p = &(*p)->next;
+    }
+
+    q->queue = *p;
+    if (q->queue) {
+        q->queue->ref = &q->queue;
+    }
+
+    *p = 0;
+
+    // reverse and flatten each slot to match insertion order
+    struct equeue_event **tail = &head;
+    struct equeue_event *ess = head;
+    while (ess) {
+        struct equeue_event *es = ess;
+        ess = es->next;
+
+        struct equeue_event *prev = 0;
+        for (struct equeue_event *e = es; e; e = e->sibling) {
+            e->next = prev;
+            prev = e;
+        }
+
+        *tail = prev;
+        tail = &es->next;
+    }
+
+    return head;
+}
+#endif
+
+#ifdef EQUEUE_STAGED_POST
+// Events posted without a delay may be pushed onto a lock-free stack of
+// staged events linked through next, with ref cleared to mark them as
+// staged. The stack is moved into the queue under the queue lock.
+static int equeue_stage(equeue_t *q, struct equeue_event *e, unsigned tick) {
+    // setup event and hash local id with buffer offset for unique id
+    int id = (e->id << q->npw2) | ((unsigned char *)e - q->buffer);
+    e->target = tick;
+    e->ref = 0;
+
+    // push onto the staged stack without taking the queue lock
+    void *head = q->staged;
+    do {
+        e->next = head;
+    } while (!equeue_atomic_cas((void **)&q->staged, &head, e));
+
+    return id;
+}
+
+static void equeue_unstage(equeue_t *q, unsigned tick) {
+    // take the whole staged stack at once
+    void *head = q->staged;
+    while (head && !equeue_atomic_cas((void **)&q->staged, &head, 0));
+
+    // reverse to match post order
+    struct equeue_event *es = 0;
+    while (head) {
+        struct equeue_event *e = head;
+        head = e->next;
+        e->next = es;
+        es = e;
+    }
+
+    while (es) {
+        struct equeue_event *e = es;
+        es = e->next;
+
+        e->target = tick + equeue_clampdiff(e->target, tick);
+        e->generation = q->generation;
+        equeue_queue_insert(q, e);
+    }
+}
+#endif
+
+static int equeue_enqueue(equeue_t *q, struct equeue_event *e, unsigned tick) {
+    // setup event and hash local id with buffer offset for unique id
+    int id = (e->id << q->npw2) | ((unsigned char *)e - q->buffer);
+    e->target = tick + equeue_clampdiff(e->target, tick);
+    e->generation = q->generation;
+
+    equeue_mutex_lock(&q->queuelock);
+
+    equeue_queue_insert(q, e);
 
     // notify background timer
     if ((q->background.update && q->background.active) &&
@@ -270,75 +605,122 @@ static struct equeue_event *equeue_unqueue(equeue_t *q, int id) {
     e->cb = 0;
     e->period = -1;
 
+#ifdef EQUEUE_STAGED_POST
+    // staged events need to be moved into the queue before removal
+    if (!e->ref) {
+        equeue_unstage(q, q->tick);
+    }
+#endif
+
     int diff = equeue_tickdiff(e->target, q->tick);
     if (diff < 0 || (diff == 0 && e->generation != q->generation)) {
         equeue_mutex_unlock(&q->queuelock);
         return 0;
     }
 
-    // disentangle from queue
-    if (e->sibling) {
-        e->sibling->next = e->next;
-        if (e->sibling->next) {
-            e->sibling->next->ref = &e->sibling->next;
+    equeue_queue_remove(q, e);
+
+    equeue_incid(q, e);
+    equeue_mutex_unlock(&q->queuelock);
+
+    return e;
+}
+
+#ifdef EQUEUE_PARALLEL_DISPATCH
+// Expired events wait in a ready list linked through next until a
+// dispatcher takes them. Keyed events that are currently executing are
+// kept in a running list linked through sibling, and a ready event is
+// skipped while an event with the same key is running. Both lists are
+// protected by the queue lock.
+static bool equeue_running(equeue_t *q, uintptr_t key) {
+    for (struct equeue_event *e = q->running; e; e = e->sibling) {
+        if (e->key == key) {
+            return true;
         }
+    }
 
-        *e->ref = e->sibling;
-        e->sibling->ref = e->ref;
-    } else {
-        *e->ref = e->next;
-        if (e->next) {
-            e->next->ref = e->ref;
+    return false;
+}
+
+static struct equeue_event *equeue_take(equeue_t *q) {
+    for (struct equeue_event **p = &q->ready; *p; p = &(*p)->next) {
+        struct equeue_event *e = *p;
+        if (e->key && equeue_running(q, e->key)) {
+            continue;
         }
+
+        *p = e->next;
+        e->next = 0;
+
+        if (e->key) {
+            e->sibling = q->running;
+            q->running = e;
+        }
+
+        // wake up another dispatcher to help with the remaining events
+        if (q->ready) {
+            equeue_sema_signal(&q->eventsema);
+        }
+
+        return e;
     }
 
-    equeue_incid(q, e);
-    equeue_mutex_unlock(&q->queuelock);
+    return 0;
+}
 
-    return e;
+static struct equeue_event *equeue_retake(equeue_t *q,
+        struct equeue_event *e) {
+    equeue_mutex_lock(&q->queuelock);
+
+    // release the event's key, which may unblock other ready events
+    if (e->key) {
+        for (struct equeue_event **p = &q->running; *p; p = &(*p)->sibling) {
+            if (*p == e) {
+                *p = e->sibling;
+                break;
+            }
+        }
+    }
+
+    struct equeue_event *next = equeue_take(q);
+
+    equeue_mutex_unlock(&q->queuelock);
+    return next;
 }
+#endif
 
 static struct equeue_event *equeue_dequeue(equeue_t *q, unsigned target) {
     equeue_mutex_lock(&q->queuelock);
 
+#ifdef EQUEUE_STAGED_POST
+    // move any staged events into the queue
+    equeue_unstage(q, target);
+#endif
+
     // find all expired events and mark a new generation
     q->generation += 1;
     if (equeue_tickdiff(q->tick, target) <= 0) {
         q->tick = target;
     }
 
-    struct equeue_event *head = q->queue;
-    struct equeue_event **p = &head;
-    while (*p && equeue_tickdiff((*p)->target, target) <= 0) {
-        p = &(*p)->next;
+    struct equeue_event *head = equeue_queue_pop(q, target);
+    if (head) {
+        q->wakeups += 1;
     }
 
-    q->queue = *p;
-    if (q->queue) {
-        q->queue->ref = &q->queue;
+#ifdef EQUEUE_PARALLEL_DISPATCH
+    // share expired events with other dispatchers
+    struct equeue_event **p = &q->ready;
+    while (*p) {
+        p = &(*p)->next;
     }
+    *p = head;
 
-    *p = 0;
+    head = equeue_take(q);
+#endif
 
     equeue_mutex_unlock(&q->queuelock);
 
-    // reverse and flatten each slot to match insertion order
-    struct equeue_event **tail = &head;
-    struct equeue_event *ess = head;
-    while (ess) {
-        struct equeue_event *es = ess;
-        ess = es->next;
-
-        struct equeue_event *prev = 0;
-        for (struct equeue_event *e = es; e; e = e->sibling) {
-            e->next = prev;
-            prev = e;
-        }
-
-        *tail = prev;
-        tail = &es->next;
-    }
-
     return head;
 }
 
@@ -346,7 +728,21 @@ int equeue_post(equeue_t *q, void (*cb)(void*), void *p) {
     struct equeue_event *e = (struct equeue_event*)p - 1;
     unsigned tick = equeue_tick();
     e->cb = cb;
+
+#ifdef EQUEUE_STAGED_POST
+    // events without a delay can skip the queue lock
+    if (!e->target && !e->slack && !q->background.update) {
+        int id = equeue_stage(q, e, tick);
+        equeue_sema_signal(&q->eventsema);
+        return id;
+    }
+#endif
+
     e->target = tick + e->target;
+    if (e->slack) {
+        e->nominal = e->target;
+        e->target = equeue_slacktarget(e->nominal, e->slack);
+    }
 
     int id = equeue_enqueue(q, e, tick);
     equeue_sema_signal(&q->eventsema);
@@ -391,10 +787,24 @@ void equeue_dispatch(equeue_t *q, int ms) {
                 cb(e + 1);
             }
 
+#ifdef EQUEUE_PARALLEL_DISPATCH
+            // take the next ready event one at a time
+            es = equeue_retake(q, e);
+#endif
+
             // reenqueue periodic events or deallocate
             if (e->period >= 0) {
-                e->target += e->period;
-                equeue_enqueue(q, e, equeue_tick());
+                unsigned now = equeue_tick();
+                if (e->slack) {
+                    // round from the unrounded schedule so batching holds
+                    // for every period, resyncing if we've fallen behind
+                    e->nominal = now + equeue_clampdiff(
+                            e->nominal + e->period, now);
+                    e->target = equeue_slacktarget(e->nominal, e->slack);
+                } else {
+                    e->target += e->period;
+                }
+                equeue_enqueue(q, e, now);
             } else {
                 equeue_incid(q, e);
                 equeue_dealloc(q, e+1);
@@ -468,6 +878,24 @@ void equeue_event_dtor(void *p, void (*dtor)(void *)) {
     e->dtor = dtor;
 }
 
+void equeue_event_slack(void *p, int ms) {
+    struct equeue_event *e = (struct equeue_event*)p - 1;
+    if (ms < 0) {
+        ms = 0;
+    } else if (ms > UINT16_MAX) {
+        ms = UINT16_MAX;
+    }
+
+    e->slack = ms;
+}
+
+#ifdef EQUEUE_PARALLEL_DISPATCH
+void equeue_event_key(void *p, uintptr_t key) {
+    struct equeue_event *e = (struct equeue_event*)p - 1;
+    e->key = key;
+}
+#endif
+
 
 // simple callbacks 
 struct ecallback {
@@ -532,6 +960,11 @@ void equeue_background(equeue_t *q,
         q->background.update(q->background.timer,
                 equeue_clampdiff(q->queue->target, equeue_tick()));
     }
+#ifdef EQUEUE_STAGED_POST
+    if (q->background.update && q->staged) {
+        q->background.update(q->background.timer, 0);
+    }
+#endif
     q->background.active = true;
     equeue_mutex_unlock(&q->queuelock);
 }
@@ -551,9 +984,27 @@ static void equeue_chain_update(void *p, int ms) {
     equeue_cancel(c->target, c->id);
 
     if (ms >= 0) {
+#ifdef EQUEUE_PARALLEL_DISPATCH
+        // dispatch each chained queue under its own key, so a chained
+        // queue is only dispatched by one of the target's dispatchers
+        // at a time
+        struct ecallback *e = equeue_alloc(c->target,
+                sizeof(struct ecallback));
+        if (!e) {
+            c->id = 0;
+            return;
+        }
+
+        equeue_event_delay(e, ms);
+        equeue_event_key(e, (uintptr_t)c->q);
+        e->cb = equeue_chain_dispatch;
+        e->data = c->q;
+        c->id = equeue_post(c->target, ecallback_dispatch, e);
+#else
         c->id = equeue_call_in(c->target, ms, equeue_chain_dispatch, c->q);
+#endif
     } else {
-        equeue_dealloc(c->target, c);
+        equeue_dealloc(c->q, c);
     }
 }
 
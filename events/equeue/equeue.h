@@ -32,6 +32,56 @@ extern "C" {
 #include <stdint.h>
 
 
+// Timer queue backend
+//
+// By default pending events are kept in a list of time slots sorted by
+// target tick, which makes posting and cancelling an event linear in the
+// number of distinct pending deadlines. Defining EQUEUE_HEAP_QUEUE keeps
+// pending events in a pairing heap instead, making post and cancel
+// O(log n) at the cost of an additional word per event.
+#if !defined(EQUEUE_HEAP_QUEUE) \
+ && defined(MBED_CONF_EVENTS_USE_HEAP_QUEUE) && MBED_CONF_EVENTS_USE_HEAP_QUEUE
+#define EQUEUE_HEAP_QUEUE
+#endif
+
+// Lock-free posting
+//
+// Defining EQUEUE_STAGED_POST lets equeue_post push events without a delay
+// onto a lock-free stack with a single compare-and-swap instead of taking
+// the queue lock. Staged events are moved into the queue by the next
+// equeue_dispatch, which keeps the time spent with interrupts disabled
+// constant for posts from interrupt contexts. Queues with a background
+// timer always take the queue lock.
+#if !defined(EQUEUE_STAGED_POST) \
+ && defined(MBED_CONF_EVENTS_USE_STAGED_POST) && MBED_CONF_EVENTS_USE_STAGED_POST
+#define EQUEUE_STAGED_POST
+#endif
+
+// Parallel dispatch
+//
+// Defining EQUEUE_PARALLEL_DISPATCH allows equeue_dispatch to be called
+// on the same queue from multiple threads at once. Expired events are
+// moved to a shared ready list and each dispatcher takes one event at a
+// time, so handlers can run concurrently. Events given the same nonzero
+// key with equeue_event_key never run concurrently and are dispatched in
+// order. Each chained queue is dispatched under its own key.
+#if !defined(EQUEUE_PARALLEL_DISPATCH) \
+ && defined(MBED_CONF_EVENTS_PARALLEL_DISPATCH) && MBED_CONF_EVENTS_PARALLEL_DISPATCH
+#define EQUEUE_PARALLEL_DISPATCH
+#endif
+
+// Event allocator size classes
+//
+// Free chunks are binned by power-of-two size class, starting at the size
+// of the event header. Allocation and free only touch the head of a bin,
+// so both take constant time unless the queue is about to run out of
+// memory. The last class holds all larger chunks. Chunks keep their
+// boundaries once carved out of the slab, so an event's header never moves
+// and cancelling an event that has already finished stays safe.
+#ifndef EQUEUE_MEM_BINS
+#define EQUEUE_MEM_BINS 8
+#endif
+
 // The minimum size of an event
 // This size is guaranteed to fit events created by event_call
 #define EQUEUE_EVENT_SIZE (sizeof(struct equeue_event) + 2*sizeof(void*))
@@ -41,36 +91,61 @@ struct equeue_event {
     unsigned size;
     uint8_t id;
     uint8_t generation;
+    uint16_t slack;
 
     struct equeue_event *next;
     struct equeue_event *sibling;
     struct equeue_event **ref;
 
     unsigned target;
+    unsigned nominal;
     int period;
     void (*dtor)(void *);
 
     void (*cb)(void *);
+#ifdef EQUEUE_HEAP_QUEUE
+    unsigned seq;
+#endif
+#ifdef EQUEUE_PARALLEL_DISPATCH
+    uintptr_t key;
+#endif
     // data follows
 };
 
 // Event queue structure
 typedef struct equeue {
     struct equeue_event *queue;
+#ifdef EQUEUE_STAGED_POST
+    struct equeue_event *staged;
+#endif
+#ifdef EQUEUE_PARALLEL_DISPATCH
+    struct equeue_event *ready;
+    struct equeue_event *running;
+#endif
     unsigned tick;
     unsigned breaks;
     uint8_t generation;
+#ifdef EQUEUE_HEAP_QUEUE
+    unsigned seq;
+#endif
+    unsigned wakeups;
 
     unsigned char *buffer;
     unsigned npw2;
     void *allocated;
 
-    struct equeue_event *chunks;
+    struct equeue_event *chunks[EQUEUE_MEM_BINS];
     struct equeue_slab {
         size_t size;
         unsigned char *data;
     } slab;
 
+    struct equeue_mem_usage {
+        size_t allocated;
+        size_t high_water;
+        unsigned failures;
+    } usage;
+
     struct equeue_background {
         bool active;
         void (*update)(void *timer, int ms);
@@ -104,12 +179,16 @@ void equeue_destroy(equeue_t *queue);
 // When called with a finite timeout, the equeue_dispatch function is
 // guaranteed to terminate. When called with a timeout of 0, the
 // equeue_dispatch does not wait and is irq safe.
+//
+// If EQUEUE_PARALLEL_DISPATCH is defined, equeue_dispatch may be called
+// from multiple threads to dispatch events concurrently.
 void equeue_dispatch(equeue_t *queue, int ms);
 
 // Break out of a running event loop
 //
 // Forces the specified event queue's dispatch loop to terminate. Pending
-// events may finish executing, but no new events will be executed.
+// events may finish executing, but no new events will be executed. Each
+// call to equeue_break terminates a single dispatch loop.
 void equeue_break(equeue_t *queue);
 
 // Simple event calls
@@ -142,8 +221,9 @@ int equeue_call_every(equeue_t *queue, int ms, void (*cb)(void *), void *data);
 //
 // The equeue allocator is designed to minimize jitter in interrupt contexts as
 // well as avoid memory fragmentation on small devices. The allocator achieves
-// both constant-runtime and zero-fragmentation for fixed-size events, however
-// grows linearly as the quantity of different sized allocations increases.
+// both constant-runtime and zero-fragmentation for fixed-size events. Free
+// chunks are kept in power-of-two size classes, so allocating and freeing
+// events of different sizes is also constant-runtime.
 //
 // The equeue_alloc function returns a pointer to the event's allocated memory
 // and acts as a handle to the underlying event. If there is not enough memory
@@ -151,14 +231,52 @@ int equeue_call_every(equeue_t *queue, int ms, void (*cb)(void *), void *data);
 void *equeue_alloc(equeue_t *queue, size_t size);
 void equeue_dealloc(equeue_t *queue, void *event);
 
+// Queue statistics
+//
+// The equeue_stats function fills in a snapshot of the event queue's
+// memory usage. Fragmentation shows up as free bytes held in chunks that
+// are not part of the unused slab.
+//
+// The wakeup count is incremented every time the dispatch loop finds
+// expired events, and approximates how often the queue keeps the device
+// out of sleep.
+//
+// The equeue_stats function is irq safe.
+struct equeue_stats {
+    size_t size;        // Size of the event queue's buffer
+    size_t allocated;   // Bytes currently allocated to events
+    size_t high_water;  // Largest number of bytes allocated at once
+    size_t slab;        // Bytes never allocated
+    size_t fragmented;  // Bytes held in free chunks
+    unsigned chunks;    // Number of free chunks
+    unsigned failures;  // Number of failed allocations
+    unsigned wakeups;   // Number of times expired events were dispatched
+};
+
+void equeue_stats(equeue_t *queue, struct equeue_stats *stats);
+
 // Configure an allocated event
 //
 // equeue_event_delay  - Millisecond delay before dispatching an event
 // equeue_event_period - Millisecond period for repeating dispatching an event
 // equeue_event_dtor   - Destructor to run when the event is deallocated
+// equeue_event_slack  - Millisecond tolerance for dispatching an event late,
+//                       allowing events to be batched into fewer wakeups
+// equeue_event_key    - Nonzero key serializing events with the same key,
+//                       only available with EQUEUE_PARALLEL_DISPATCH
+//
+// An event with slack is scheduled on the coarsest power-of-two tick
+// boundary within its slack, so events whose windows overlap share a
+// wakeup. Periodic events are rounded again every period from their
+// unrounded schedule, so they stay batched without drifting. Slack is
+// limited to 65535 milliseconds.
 void equeue_event_delay(void *event, int ms);
 void equeue_event_period(void *event, int ms);
 void equeue_event_dtor(void *event, void (*dtor)(void *));
+void equeue_event_slack(void *event, int ms);
+#ifdef EQUEUE_PARALLEL_DISPATCH
+void equeue_event_key(void *event, uintptr_t key);
+#endif
 
 // Post an event onto the event queue
 //
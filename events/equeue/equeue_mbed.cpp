@@ -91,6 +91,12 @@ void equeue_mutex_unlock(equeue_mutex_t *m) {
 }
 
 
+// Atomic operations
+bool equeue_atomic_cas(void **p, void **expected, void *desired) {
+    return core_util_atomic_cas_ptr(p, expected, desired);
+}
+
+
 // Semaphore operations
 #ifdef MBED_CONF_RTOS_PRESENT
 
@@ -97,6 +97,19 @@ void equeue_mutex_lock(equeue_mutex_t *mutex);
 void equeue_mutex_unlock(equeue_mutex_t *mutex);
 
 
+// Platform atomic operations
+//
+// The equeue_atomic_cas function atomically compares the pointer at ptr
+// with the value at expected and, only if they match, replaces it with
+// desired. On failure, the current value is written back to expected.
+// Returns true if the pointer was replaced.
+//
+// The equeue library uses this for lock-free posting of events and
+// requires it to be irq safe. It is only required if EQUEUE_STAGED_POST
+// is enabled.
+bool equeue_atomic_cas(void **ptr, void **expected, void *desired);
+
+
 // Platform semaphore type
 //
 // The equeue library requires a binary semaphore type that can be safely
@@ -50,6 +50,18 @@ void equeue_mutex_unlock(equeue_mutex_t *m) {
 }
 
 
+// Atomic operations
+bool equeue_atomic_cas(void **p, void **expected, void *desired) {
+    void *prev = __sync_val_compare_and_swap(p, *expected, desired);
+    if (prev != *expected) {
+        *expected = prev;
+        return false;
+    }
+
+    return true;
+}
+
+
 // Semaphore operations
 int equeue_sema_create(equeue_sema_t *s) {
     int err = pthread_mutex_init(&s->mutex, 0);
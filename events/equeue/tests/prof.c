@@ -23,6 +23,7 @@
 #include <stdlib.h>
 #include <inttypes.h>
 #include <sys/time.h>
+#include <pthread.h>
 
 
 // Performance measurement utils
@@ -116,6 +117,30 @@ static const char *prof_units;
 void no_func(void *eh) {
 }
 
+struct producer {
+    pthread_t thread;
+    equeue_t *q;
+    volatile bool *done;
+};
+
+static void *producer_thread(void *p) {
+    struct producer *producer = (struct producer *)p;
+    while (!*producer->done) {
+        equeue_call(producer->q, no_func, 0);
+    }
+
+    return 0;
+}
+
+static void *dispatch_thread(void *p) {
+    struct producer *producer = (struct producer *)p;
+    while (!*producer->done) {
+        equeue_dispatch(producer->q, 0);
+    }
+
+    return 0;
+}
+
 
 // Actual performance tests
 void baseline_prof(void) {
@@ -253,6 +278,62 @@ void equeue_post_future_many_prof(int count) {
     equeue_destroy(&q);
 }
 
+void equeue_post_spread_many_prof(int count) {
+    struct equeue q;
+    equeue_create(&q, count*EQUEUE_EVENT_SIZE);
+
+    for (int i = 0; i < count-1; i++) {
+        equeue_call_in(&q, 1000 + i, no_func, 0);
+    }
+
+    prof_loop() {
+        void *e = equeue_alloc(&q, 0);
+        equeue_event_delay(e, 1000 + count/2);
+
+        prof_start();
+        int id = equeue_post(&q, no_func, e);
+        prof_stop();
+
+        equeue_cancel(&q, id);
+    }
+
+    equeue_destroy(&q);
+}
+
+void equeue_post_contended_prof(int count) {
+    struct equeue q;
+    equeue_create(&q, 1000*EQUEUE_EVENT_SIZE);
+
+    // count-1 threads post as fast as they can while another drains
+    volatile bool done = false;
+    struct producer producers[count];
+    for (int i = 0; i < count; i++) {
+        producers[i].q = &q;
+        producers[i].done = &done;
+        pthread_create(&producers[i].thread, 0,
+                i == 0 ? dispatch_thread : producer_thread, &producers[i]);
+    }
+
+    prof_loop() {
+        void *e = equeue_alloc(&q, 0);
+        if (!e) {
+            prof_iterations--;
+            continue;
+        }
+
+        prof_start();
+        equeue_post(&q, no_func, e);
+        prof_stop();
+    }
+
+    done = true;
+    for (int i = 0; i < count; i++) {
+        pthread_join(producers[i].thread, 0);
+    }
+
+    equeue_destroy(&q);
+}
+
 void equeue_dispatch_prof(void) {
     struct equeue q;
     equeue_create(&q, EQUEUE_EVENT_SIZE);
@@ -319,6 +400,46 @@ void equeue_cancel_many_prof(int count) {
     equeue_destroy(&q);
 }
 
+void equeue_cancel_spread_many_prof(int count) {
+    struct equeue q;
+    equeue_create(&q, count*EQUEUE_EVENT_SIZE);
+
+    for (int i = 0; i < count-1; i++) {
+        equeue_call_in(&q, 1000 + i, no_func, 0);
+    }
+
+    prof_loop() {
+        int id = equeue_call_in(&q, 1000 + count/2, no_func, 0);
+
+        prof_start();
+        equeue_cancel(&q, id);
+        prof_stop();
+    }
+
+    equeue_destroy(&q);
+}
+
+void equeue_wakeups_prof(int slack) {
+    struct equeue q;
+    equeue_create(&q, 8*EQUEUE_EVENT_SIZE);
+
+    for (int i = 0; i < 8; i++) {
+        void *e = equeue_alloc(&q, 0);
+        equeue_event_delay(e, 10 + i);
+        equeue_event_period(e, 16);
+        equeue_event_slack(e, slack);
+        equeue_post(&q, no_func, e);
+    }
+
+    equeue_dispatch(&q, 160);
+
+    struct equeue_stats stats;
+    equeue_stats(&q, &stats);
+    prof_result(stats.wakeups, "wakeups");
+
+    equeue_destroy(&q);
+}
+
 void equeue_alloc_size_prof(void) {
     size_t size = 32*EQUEUE_EVENT_SIZE;
 
@@ -346,6 +467,31 @@ void equeue_alloc_many_size_prof(int count) {
     equeue_destroy(&q);
 }
 
+void equeue_alloc_sizes_prof(int count) {
+    struct equeue q;
+    equeue_create(&q, count*(EQUEUE_EVENT_SIZE+count*sizeof(int)));
+
+    void *es[count];
+
+    for (int i = 0; i < count; i++) {
+        es[i] = equeue_alloc(&q, i * sizeof(int));
+    }
+
+    for (int i = 0; i < count; i++) {
+        equeue_dealloc(&q, es[i]);
+    }
+
+    prof_loop() {
+        prof_start();
+        void *e = equeue_alloc(&q, (count/2) * sizeof(int));
+        prof_stop();
+
+        equeue_dealloc(&q, e);
+    }
+
+    equeue_destroy(&q);
+}
+
 void equeue_alloc_fragmented_size_prof(int count) {
     size_t size = count*EQUEUE_EVENT_SIZE;
 
@@ -394,11 +540,26 @@ int main() {
     prof_measure(equeue_cancel_prof);
 
     prof_measure(equeue_alloc_many_prof, 1000);
+    prof_measure(equeue_alloc_sizes_prof, 100);
     prof_measure(equeue_post_many_prof, 1000);
     prof_measure(equeue_post_future_many_prof, 1000);
     prof_measure(equeue_dispatch_many_prof, 100);
     prof_measure(equeue_cancel_many_prof, 100);
 
+    prof_measure(equeue_post_spread_many_prof, 10);
+    prof_measure(equeue_post_spread_many_prof, 100);
+    prof_measure(equeue_post_spread_many_prof, 1000);
+    prof_measure(equeue_cancel_spread_many_prof, 10);
+    prof_measure(equeue_cancel_spread_many_prof, 100);
+    prof_measure(equeue_cancel_spread_many_prof, 1000);
+
+    prof_measure(equeue_post_contended_prof, 1);
+    prof_measure(equeue_post_contended_prof, 2);
+    prof_measure(equeue_post_contended_prof, 4);
+
+    prof_measure(equeue_wakeups_prof, 0);
+    prof_measure(equeue_wakeups_prof, 16);
+
     prof_measure(equeue_alloc_size_prof);
     prof_measure(equeue_alloc_many_size_prof, 1000);
     prof_measure(equeue_alloc_fragmented_size_prof, 1000);
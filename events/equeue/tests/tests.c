@@ -21,6 +21,7 @@
 #include <setjmp.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 
 
@@ -125,6 +126,17 @@ struct nest {
     void *data;
 };
 
+struct order {
+    int *log;
+    int *count;
+    int i;
+};
+
+void order_func(void *p) {
+    struct order *order = (struct order *)p;
+    order->log[(*order->count)++] = order->i;
+}
+
 void nest_func(void *p) {
     struct nest *nest = (struct nest *)p;
     equeue_call(nest->q, nest->cb, nest->data);
@@ -269,6 +281,106 @@ void allocation_failure_test(void) {
     equeue_destroy(&q);
 }
 
+void stats_test(void) {
+    equeue_t q;
+    int err = equeue_create(&q, 2048);
+    test_assert(!err);
+
+    struct equeue_stats stats;
+    equeue_stats(&q, &stats);
+    test_assert(stats.size == 2048);
+    test_assert(stats.allocated == 0);
+    test_assert(stats.slab == 2048);
+    test_assert(stats.chunks == 0);
+
+    void *es[8];
+    for (int i = 0; i < 8; i++) {
+        es[i] = equeue_alloc(&q, i*sizeof(int));
+        test_assert(es[i]);
+    }
+
+    equeue_stats(&q, &stats);
+    test_assert(stats.allocated > 0);
+    test_assert(stats.high_water == stats.allocated);
+    test_assert(stats.allocated + stats.slab == 2048);
+    size_t high_water = stats.high_water;
+
+    test_assert(!equeue_alloc(&q, 4096));
+
+    for (int i = 0; i < 8; i++) {
+        equeue_dealloc(&q, es[i]);
+    }
+
+    equeue_stats(&q, &stats);
+    test_assert(stats.allocated == 0);
+    test_assert(stats.high_water == high_water);
+    test_assert(stats.fragmented + stats.slab == 2048);
+    test_assert(stats.failures == 1);
+
+    equeue_destroy(&q);
+}
+
+void slack_test(void) {
+    equeue_t q;
+    int err = equeue_create(&q, 2048);
+    test_assert(!err);
+
+    int touched = 0;
+    for (int i = 0; i < 10; i++) {
+        struct indirect *e = equeue_alloc(&q, sizeof(struct indirect));
+        test_assert(e);
+
+        e->touched = &touched;
+        equeue_event_delay(e, i+1);
+        equeue_event_slack(e, 32);
+        int id = equeue_post(&q, indirect_func, e);
+        test_assert(id);
+    }
+
+    equeue_dispatch(&q, 80);
+    test_assert(touched == 10);
+
+    // events straddling a 32ms boundary can take at most two wakeups
+    struct equeue_stats stats;
+    equeue_stats(&q, &stats);
+    test_assert(stats.wakeups <= 2);
+
+    equeue_destroy(&q);
+}
+
+void slack_period_test(void) {
+    equeue_t q;
+    int err = equeue_create(&q, 2048);
+    test_assert(!err);
+
+    int touched[2] = {0, 0};
+    int periods[2] = {70, 90};
+    for (int i = 0; i < 2; i++) {
+        struct indirect *e = equeue_alloc(&q, sizeof(struct indirect));
+        test_assert(e);
+
+        e->touched = &touched[i];
+        equeue_event_delay(e, periods[i]);
+        equeue_event_period(e, periods[i]);
+        equeue_event_slack(e, 64);
+        int id = equeue_post(&q, indirect_func, e);
+        test_assert(id);
+    }
+
+    equeue_dispatch(&q, 1280);
+    test_assert(touched[0] >= 1280/70 - 2);
+    test_assert(touched[1] >= 1280/90 - 2);
+
+    // every period stays on a 64ms boundary, so mismatched periods still
+    // share wakeups
+    struct equeue_stats stats;
+    equeue_stats(&q, &stats);
+    test_assert(stats.wakeups <= 1280/64 + 1);
+    test_assert(stats.wakeups < (unsigned)(touched[0] + touched[1]));
+
+    equeue_destroy(&q);
+}
+
 void cancel_test(int N) {
     equeue_t q;
     int err = equeue_create(&q, 2048);
@@ -356,6 +468,57 @@ void cancel_unnecessarily_test(void) {
     equeue_destroy(&q);
 }
 
+static int stale_touched = 0;
+
+void stale_func(void *p) {
+    stale_touched++;
+}
+
+void cancel_stale_sizes_test(void) {
+    equeue_t q;
+    int err = equeue_create(&q, 1024);
+    test_assert(!err);
+
+    // fill the queue with a burst of events of different sizes
+    int ids[32];
+    int count = 0;
+    while (count < 32) {
+        void *e = equeue_alloc(&q, (count % 5)*sizeof(int));
+        if (!e) {
+            break;
+        }
+
+        ids[count++] = equeue_post(&q, pass_func, e);
+    }
+    equeue_dispatch(&q, 0);
+
+    // reuse the memory with other sizes, filling every payload with
+    // bytes that look like the stale ids
+    stale_touched = 0;
+    int posted = 0;
+    for (int i = 0; i < 32; i++) {
+        size_t size = (3 + i % 3)*sizeof(int);
+        void *e = equeue_alloc(&q, size);
+        if (!e) {
+            break;
+        }
+
+        memset(e, ids[0] >> q.npw2, size);
+        equeue_post(&q, stale_func, e);
+        posted += 1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        equeue_cancel(&q, ids[i]);
+    }
+
+    equeue_dispatch(&q, 0);
+    test_assert(posted > 0);
+    test_assert(stale_touched == posted);
+
+    equeue_destroy(&q);
+}
+
 void loop_protect_test(void) {
     equeue_t q;
     int err = equeue_create(&q, 2048);
@@ -491,6 +654,149 @@ void multithread_test(void) {
     equeue_destroy(&q);
 }
 
+struct producer {
+    pthread_t thread;
+    equeue_t *q;
+    int *touched;
+    int count;
+};
+
+void *producer_thread(void *p) {
+    struct producer *producer = (struct producer *)p;
+    for (int i = 0; i < producer->count; i++) {
+        while (!equeue_call(producer->q, simple_func, producer->touched)) {
+            usleep(100);
+        }
+    }
+
+    return 0;
+}
+
+void multiproducer_test(int N) {
+    equeue_t q;
+    int err = equeue_create(&q, 2048);
+    test_assert(!err);
+
+    pthread_t thread;
+    err = pthread_create(&thread, 0, multithread_thread, &q);
+    test_assert(!err);
+
+    int touched = 0;
+    struct producer producers[4];
+    for (int i = 0; i < 4; i++) {
+        producers[i].q = &q;
+        producers[i].touched = &touched;
+        producers[i].count = N;
+        err = pthread_create(&producers[i].thread, 0,
+                producer_thread, &producers[i]);
+        test_assert(!err);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        err = pthread_join(producers[i].thread, 0);
+        test_assert(!err);
+    }
+
+    equeue_break(&q);
+    err = pthread_join(thread, 0);
+    test_assert(!err);
+
+    equeue_dispatch(&q, 0);
+
+    test_assert(touched == 4*N);
+
+    equeue_destroy(&q);
+}
+
+#ifdef EQUEUE_PARALLEL_DISPATCH
+void parallel_sloth_func(void *p) {
+    usleep(10000);
+    __sync_fetch_and_add((int *)p, 1);
+}
+
+struct serial {
+    volatile int active;
+    volatile int overlapped;
+    volatile int count;
+    int log[20];
+    int i;
+};
+
+struct serial_event {
+    struct serial *serial;
+    int i;
+};
+
+void serial_func(void *p) {
+    struct serial_event *e = (struct serial_event *)p;
+    if (e->serial->active) {
+        e->serial->overlapped = 1;
+    }
+    e->serial->active = 1;
+    usleep(1000);
+    e->serial->log[e->serial->count++] = e->i;
+    e->serial->active = 0;
+}
+
+void parallel_dispatch_test(void) {
+    equeue_t q;
+    int err = equeue_create(&q, 4096);
+    test_assert(!err);
+
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++) {
+        err = pthread_create(&threads[i], 0, multithread_thread, &q);
+        test_assert(!err);
+    }
+
+    // unkeyed events run concurrently
+    volatile int touched = 0;
+    unsigned tick = equeue_tick();
+    for (int i = 0; i < 8; i++) {
+        int id = equeue_call(&q, parallel_sloth_func, (void *)&touched);
+        test_assert(id);
+    }
+
+    while (touched < 8) {
+        usleep(1000);
+    }
+    test_assert(equeue_tick() - tick < 8*10);
+
+    // keyed events run one at a time in order
+    struct serial serial = {0};
+    for (int i = 0; i < 20; i++) {
+        struct serial_event *e = equeue_alloc(&q, sizeof(struct serial_event));
+        test_assert(e);
+
+        e->serial = &serial;
+        e->i = i;
+        equeue_event_key(e, 1);
+        int id = equeue_post(&q, serial_func, e);
+        test_assert(id);
+    }
+
+    while (serial.count < 20) {
+        usleep(1000);
+    }
+
+    test_assert(!serial.overlapped);
+    for (int i = 0; i < 20; i++) {
+        test_assert(serial.log[i] == i);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        equeue_break(&q);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        err = pthread_join(threads[i], 0);
+        test_assert(!err);
+    }
+
+    equeue_destroy(&q);
+}
+#endif
+
 void background_func(void *p, int ms) {
     *(unsigned *)p = ms;
 }
@@ -595,6 +901,45 @@ void unchain_test(void) {
     equeue_destroy(&q2);
 }
 
+void ordering_test(int N) {
+    equeue_t q;
+    int err = equeue_create(&q, N*(EQUEUE_EVENT_SIZE+sizeof(struct order)));
+    test_assert(!err);
+
+    int log[N];
+    int count = 0;
+    int ids[N];
+
+    for (int i = 0; i < N; i++) {
+        struct order *order = equeue_alloc(&q, sizeof(struct order));
+        test_assert(order);
+
+        order->log = log;
+        order->count = &count;
+        order->i = i;
+        equeue_event_delay(order, (i*7) % 10);
+
+        ids[i] = equeue_post(&q, order_func, order);
+        test_assert(ids[i]);
+    }
+
+    for (int i = 0; i < N; i += 3) {
+        equeue_cancel(&q, ids[i]);
+    }
+
+    equeue_dispatch(&q, 20);
+    test_assert(count == N - (N+2)/3);
+
+    for (int i = 1; i < count; i++) {
+        int a = (log[i-1]*7) % 10;
+        int b = (log[i]*7) % 10;
+        test_assert(log[i] % 3 != 0);
+        test_assert(a < b || (a == b && log[i-1] < log[i]));
+    }
+
+    equeue_destroy(&q);
+}
+
 // Barrage tests
 void simple_barrage_test(int N) {
     equeue_t q;
@@ -697,9 +1042,13 @@ int main() {
     test_run(simple_post_test);
     test_run(destructor_test);
     test_run(allocation_failure_test);
+    test_run(stats_test);
+    test_run(slack_test);
+    test_run(slack_period_test);
     test_run(cancel_test, 20);
     test_run(cancel_inflight_test);
     test_run(cancel_unnecessarily_test);
+    test_run(cancel_stale_sizes_test);
     test_run(loop_protect_test);
     test_run(break_test);
     test_run(period_test);
@@ -709,6 +1058,11 @@ int main() {
     test_run(chain_test);
     test_run(unchain_test);
     test_run(multithread_test);
+    test_run(multiproducer_test, 1000);
+#ifdef EQUEUE_PARALLEL_DISPATCH
+    test_run(parallel_dispatch_test);
+#endif
+    test_run(ordering_test, 200);
     test_run(simple_barrage_test, 20);
     test_run(fragmenting_barrage_test, 20);
     test_run(multithreaded_barrage_test, 20);
@@ -29,6 +29,7 @@
 #include "lwip/netif.h"
 #include "lwip/dhcp.h"
 #include "lwip/tcpip.h"
+#include "lwip/priv/tcpip_priv.h"
 #include "lwip/tcp.h"
 #include "lwip/ip.h"
 #include "lwip/mld6.h"
@@ -63,6 +64,10 @@ static struct lwip_socket {
     void (*cb)(void *);
     void *data;
 
+    // Packets waiting in the netconn's receive mailbox, only
+    // accessed under sys_arch_protect
+    int recv_pending;
+
     // Track multicast addresses subscribed to by this socket
     nsapi_ip_mreq_t *multicast_memberships;
     uint32_t         multicast_memberships_count;
@@ -141,9 +146,17 @@ static void mbed_lwip_socket_callback(struct netconn *nc, enum netconn_evt eh, u
 
     for (int i = 0; i < MEMP_NUM_NETCONN; i++) {
         if (lwip_arena[i].in_use
-            && lwip_arena[i].conn == nc
-            && lwip_arena[i].cb) {
-            lwip_arena[i].cb(lwip_arena[i].data);
+            && lwip_arena[i].conn == nc) {
+            // Count queued packets the way lwIP's sockets do for select
+            if (eh == NETCONN_EVT_RCVPLUS) {
+                lwip_arena[i].recv_pending += 1;
+            } else if (eh == NETCONN_EVT_RCVMINUS) {
+                lwip_arena[i].recv_pending -= 1;
+            }
+
+            if (lwip_arena[i].cb) {
+                lwip_arena[i].cb(lwip_arena[i].data);
+            }
         }
     }
 
@@ -1126,6 +1139,86 @@ static nsapi_size_or_error_t mbed_lwip_socket_recv(nsapi_stack_t *stack, nsapi_s
     return recv;
 }
 
+/* Lends the pbufs of s->buf from s->offset onwards. The loan holds its own
+ * reference on the chain, so it outlives both the netbuf and the socket */
+static nsapi_size_or_error_t mbed_lwip_socket_lend(struct lwip_socket *s, nsapi_loan_t *loan)
+{
+    struct pbuf *p = s->buf->p;
+    u16_t skip = s->offset;
+    while (p && skip >= p->len && p->len < p->tot_len) {
+        skip -= p->len;
+        p = p->next;
+    }
+
+    loan->count = 0;
+    loan->size = 0;
+    for (struct pbuf *q = p; q && loan->count < MBED_CONF_NSAPI_LOAN_SEGMENTS; q = q->next) {
+        if (q->len > skip) {
+            loan->segments[loan->count].iov_base = (u8_t *)q->payload + skip;
+            loan->segments[loan->count].iov_len = q->len - skip;
+            loan->size += q->len - skip;
+            loan->count += 1;
+        }
+        skip = 0;
+    }
+
+    pbuf_ref(p);
+    loan->handle = p;
+    return loan->size;
+}
+
+static nsapi_size_or_error_t mbed_lwip_socket_recv_loan(nsapi_stack_t *stack, nsapi_socket_t handle, nsapi_loan_t *loan)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+
+    if (!s->buf) {
+        err_t err = netconn_recv(s->conn, &s->buf);
+        s->offset = 0;
+
+        if (err != ERR_OK) {
+            return mbed_lwip_err_remap(err);
+        }
+    }
+
+    nsapi_size_or_error_t recv = mbed_lwip_socket_lend(s, loan);
+    s->offset += recv;
+
+    if (s->offset >= netbuf_len(s->buf)) {
+        netbuf_delete(s->buf);
+        s->buf = 0;
+    }
+
+    return recv;
+}
+
+static nsapi_size_or_error_t mbed_lwip_socket_recvfrom_loan(nsapi_stack_t *stack, nsapi_socket_t handle, nsapi_addr_t *addr, uint16_t *port, nsapi_loan_t *loan)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+
+    err_t err = netconn_recv(s->conn, &s->buf);
+    s->offset = 0;
+    if (err != ERR_OK) {
+        return mbed_lwip_err_remap(err);
+    }
+
+    convert_lwip_addr_to_mbed(addr, netbuf_fromaddr(s->buf));
+    *port = netbuf_fromport(s->buf);
+
+    nsapi_size_or_error_t recv = mbed_lwip_socket_lend(s, loan);
+    netbuf_delete(s->buf);
+    s->buf = 0;
+
+    return recv;
+}
+
+static void mbed_lwip_socket_release(nsapi_stack_t *stack, nsapi_loan_t *loan)
+{
+    if (loan->handle) {
+        pbuf_free((struct pbuf *)loan->handle);
+        loan->handle = 0;
+    }
+}
+
 static nsapi_size_or_error_t mbed_lwip_socket_sendto(nsapi_stack_t *stack, nsapi_socket_t handle, nsapi_addr_t addr, uint16_t port, const void *data, nsapi_size_t size)
 {
     struct lwip_socket *s = (struct lwip_socket *)handle;
@@ -1170,6 +1263,248 @@ static nsapi_size_or_error_t mbed_lwip_socket_recvfrom(nsapi_stack_t *stack, nsa
     return recv;
 }
 
+/* Batch of packets handed to the tcpip thread */
+struct mbed_lwip_batch {
+    struct tcpip_api_call_data call;
+    struct lwip_socket *s;
+    const nsapi_datagram_t *datagrams;
+    unsigned count;
+    unsigned sent;
+};
+
+/* Runs with the stack locked and sends the whole batch straight
+ * to the pcb, skipping the per-packet netconn api round trip */
+static err_t mbed_lwip_sendto_batch_call(struct tcpip_api_call_data *call)
+{
+    struct mbed_lwip_batch *batch = (struct mbed_lwip_batch *)call;
+    struct udp_pcb *pcb = batch->s->conn->pcb.udp;
+    if (!pcb) {
+        return ERR_CONN;
+    }
+
+    for (; batch->sent < batch->count; batch->sent++) {
+        const nsapi_datagram_t *datagram = &batch->datagrams[batch->sent];
+        ip_addr_t ip_addr;
+
+        if (!convert_mbed_addr_to_lwip(&ip_addr, &datagram->addr)) {
+            return ERR_VAL;
+        }
+
+        struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, (u16_t)datagram->size, PBUF_REF);
+        if (!p) {
+            return ERR_MEM;
+        }
+        p->payload = datagram->data;
+
+        err_t err = udp_sendto(pcb, p, &ip_addr, datagram->port);
+        pbuf_free(p);
+        if (err != ERR_OK) {
+            return err;
+        }
+    }
+
+    return ERR_OK;
+}
+
+static nsapi_size_or_error_t mbed_lwip_socket_sendto_batch(nsapi_stack_t *stack, nsapi_socket_t handle, const nsapi_datagram_t *datagrams, unsigned count)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+
+    if (NETCONNTYPE_GROUP(s->conn->type) != NETCONN_UDP) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+    /* pbufs are limited to 64KiB, check before anything is sent */
+    for (unsigned i = 0; i < count; i++) {
+        if (datagrams[i].size > 0xffff) {
+            return NSAPI_ERROR_PARAMETER;
+        }
+    }
+
+    struct mbed_lwip_batch batch = {
+        .s = s,
+        .datagrams = datagrams,
+        .count = count,
+        .sent = 0,
+    };
+
+    err_t err = tcpip_api_call(mbed_lwip_sendto_batch_call, &batch.call);
+    if (err != ERR_OK && !batch.sent) {
+        return mbed_lwip_err_remap(err);
+    }
+
+    return batch.sent;
+}
+
+static nsapi_size_or_error_t mbed_lwip_socket_recvfrom_batch(nsapi_stack_t *stack, nsapi_socket_t handle, nsapi_datagram_t *datagrams, unsigned count)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+
+    /* netbuf copies are limited to 64KiB, check before anything is received */
+    for (unsigned i = 0; i < count; i++) {
+        if (datagrams[i].size > 0xffff) {
+            return NSAPI_ERROR_PARAMETER;
+        }
+    }
+
+    for (unsigned i = 0; i < count; i++) {
+        /* Only the first packet may wait for the receive timeout,
+         * the rest of the batch is whatever is already queued */
+        if (i) {
+            sys_prot_t prot = sys_arch_protect();
+            int pending = s->recv_pending;
+            sys_arch_unprotect(prot);
+
+            if (pending <= 0) {
+                return i;
+            }
+        }
+
+        struct netbuf *buf;
+        err_t err = netconn_recv(s->conn, &buf);
+        if (err != ERR_OK) {
+            return i ? (nsapi_size_or_error_t)i : mbed_lwip_err_remap(err);
+        }
+
+        convert_lwip_addr_to_mbed(&datagrams[i].addr, netbuf_fromaddr(buf));
+        datagrams[i].port = netbuf_fromport(buf);
+        datagrams[i].length = netbuf_copy(buf, datagrams[i].data, (u16_t)datagrams[i].size);
+        netbuf_delete(buf);
+    }
+
+    return count;
+}
+
+static nsapi_size_or_error_t mbed_lwip_socket_sendmsg(nsapi_stack_t *stack, nsapi_socket_t handle, const nsapi_addr_t *addr, uint16_t port, const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+
+    if (!addr) {
+        /* Hint to tcp_write that more data follows, so the buffers
+         * are queued into the same segments */
+        size_t sent = 0;
+        for (unsigned i = 0; i < iovcnt; i++) {
+            if (!iov[i].iov_len) {
+                continue;
+            }
+
+            u8_t flags = NETCONN_COPY | (i+1 < iovcnt ? NETCONN_MORE : 0);
+            size_t bytes_written = 0;
+            err_t err = netconn_write_partly(s->conn, iov[i].iov_base, iov[i].iov_len, flags, &bytes_written);
+            if (err != ERR_OK) {
+                return sent ? (nsapi_size_or_error_t)sent : mbed_lwip_err_remap(err);
+            }
+
+            sent += bytes_written;
+            if (bytes_written < iov[i].iov_len) {
+                break;
+            }
+        }
+
+        return (nsapi_size_or_error_t)sent;
+    }
+
+    ip_addr_t ip_addr;
+    if (!convert_mbed_addr_to_lwip(&ip_addr, addr)) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    nsapi_size_t size = 0;
+    for (unsigned i = 0; i < iovcnt; i++) {
+        size += iov[i].iov_len;
+    }
+
+    if (size > 0xffff) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    /* Packets are sent as a chain of pbufs referencing each buffer */
+    struct netbuf *buf = netbuf_new();
+    if (!buf) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    for (unsigned i = 0; i < iovcnt || !buf->p; i++) {
+        struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, (i < iovcnt) ? (u16_t)iov[i].iov_len : 0, PBUF_REF);
+        if (!p) {
+            netbuf_delete(buf);
+            return NSAPI_ERROR_NO_MEMORY;
+        }
+
+        p->payload = (i < iovcnt) ? iov[i].iov_base : NULL;
+        if (buf->p) {
+            pbuf_cat(buf->p, p);
+        } else {
+            buf->p = p;
+            buf->ptr = p;
+        }
+    }
+
+    err_t err = netconn_sendto(s->conn, buf, &ip_addr, port);
+    netbuf_delete(buf);
+    if (err != ERR_OK) {
+        return mbed_lwip_err_remap(err);
+    }
+
+    return size;
+}
+
+/* Copies the netbuf from offset onwards into the buffers in order */
+static u16_t mbed_lwip_netbuf_scatter(struct netbuf *buf, u16_t offset, const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    u16_t copied = 0;
+    for (unsigned i = 0; i < iovcnt; i++) {
+        u16_t len = (iov[i].iov_len > 0xffff) ? 0xffff : (u16_t)iov[i].iov_len;
+        u16_t recv = netbuf_copy_partial(buf, iov[i].iov_base, len, offset + copied);
+        copied += recv;
+        if (recv < len) {
+            break;
+        }
+    }
+
+    return copied;
+}
+
+static nsapi_size_or_error_t mbed_lwip_socket_recvmsg(nsapi_stack_t *stack, nsapi_socket_t handle, nsapi_addr_t *addr, uint16_t *port, const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+
+    if (addr) {
+        struct netbuf *buf;
+        err_t err = netconn_recv(s->conn, &buf);
+        if (err != ERR_OK) {
+            return mbed_lwip_err_remap(err);
+        }
+
+        convert_lwip_addr_to_mbed(addr, netbuf_fromaddr(buf));
+        *port = netbuf_fromport(buf);
+
+        u16_t recv = mbed_lwip_netbuf_scatter(buf, 0, iov, iovcnt);
+        netbuf_delete(buf);
+
+        return recv;
+    }
+
+    if (!s->buf) {
+        err_t err = netconn_recv(s->conn, &s->buf);
+        s->offset = 0;
+
+        if (err != ERR_OK) {
+            return mbed_lwip_err_remap(err);
+        }
+    }
+
+    u16_t recv = mbed_lwip_netbuf_scatter(s->buf, s->offset, iov, iovcnt);
+    s->offset += recv;
+
+    if (s->offset >= netbuf_len(s->buf)) {
+        netbuf_delete(s->buf);
+        s->buf = 0;
+    }
+
+    return recv;
+}
+
 static int32_t find_multicast_member(const struct lwip_socket *s, const nsapi_ip_mreq_t *imr) {
     uint32_t count = 0;
     uint32_t index = 0;
@@ -1357,6 +1692,13 @@ const nsapi_stack_api_t lwip_stack_api = {
     .socket_recvfrom    = mbed_lwip_socket_recvfrom,
     .setsockopt         = mbed_lwip_setsockopt,
     .socket_attach      = mbed_lwip_socket_attach,
+    .socket_recv_loan   = mbed_lwip_socket_recv_loan,
+    .socket_recvfrom_loan = mbed_lwip_socket_recvfrom_loan,
+    .socket_release     = mbed_lwip_socket_release,
+    .socket_sendmsg     = mbed_lwip_socket_sendmsg,
+    .socket_recvmsg     = mbed_lwip_socket_recvmsg,
+    .socket_sendto_batch = mbed_lwip_socket_sendto_batch,
+    .socket_recvfrom_batch = mbed_lwip_socket_recvfrom_batch,
 };
 
 nsapi_stack_t lwip_stack = {
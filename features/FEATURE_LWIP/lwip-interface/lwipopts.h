@@ -225,6 +225,10 @@
 
 #define LWIP_BROADCAST_PING         1
 
+#if MBED_CONF_LWIP_LOOPBACK_ENABLED
+#define LWIP_NETIF_LOOPBACK         1
+#endif
+
 // Fragmentation on, as per IPv4 default
 #define LWIP_IPV6_FRAG              LWIP_IPV6
 
@@ -20,6 +20,8 @@
 
 #include "HeapBlockDevice.h"
 #include "FATFileSystem.h"
+#include "ProfilingBlockDevice.h"
+#include "BufferedBlockDevice.h"
 #include <stdlib.h>
 #include "mbed_retarget.h"
 
@@ -145,10 +147,404 @@ void test_read_dir() {
     TEST_ASSERT_EQUAL(0, err);
 }
 
+// Test that buffering reduces erases while appending to a file
+void test_buffered_append() {
+    ProfilingBlockDevice profiler(&bd);
+    BufferedBlockDevice buffered(&profiler, 4);
+    BlockDevice *bds[2] = {&profiler, &buffered};
+    bd_size_t erase_counts[2];
+    bd_size_t program_counts[2];
+
+    for (int i = 0; i < 2; i++) {
+        FATFileSystem fs("fat");
+        profiler.reset();
+
+        int err = fs.mount(bds[i]);
+        TEST_ASSERT_EQUAL(0, err);
+
+        // Append small chunks, FAT updates its table and directory in between
+        uint8_t buffer[64];
+        File file;
+        err = file.open(&fs, "test_buffered_append.dat", O_WRONLY | O_CREAT | O_TRUNC);
+        TEST_ASSERT_EQUAL(0, err);
+        for (int j = 0; j < 64; j++) {
+            memset(buffer, j, sizeof(buffer));
+            ssize_t size = file.write(buffer, sizeof(buffer));
+            TEST_ASSERT_EQUAL(sizeof(buffer), size);
+        }
+        err = file.close();
+        TEST_ASSERT_EQUAL(0, err);
+
+        err = fs.unmount();
+        TEST_ASSERT_EQUAL(0, err);
+        err = bds[i]->sync();
+        TEST_ASSERT_EQUAL(0, err);
+
+        erase_counts[i] = profiler.get_erase_count();
+        program_counts[i] = profiler.get_program_count();
+        printf("%s: erase count %llu, program count %llu\n",
+                i ? "buffered" : "direct", erase_counts[i], program_counts[i]);
+
+        // Check the data made it to the underlying block device
+        err = fs.mount(&bd);
+        TEST_ASSERT_EQUAL(0, err);
+        err = file.open(&fs, "test_buffered_append.dat", O_RDONLY);
+        TEST_ASSERT_EQUAL(0, err);
+        for (int j = 0; j < 64; j++) {
+            ssize_t size = file.read(buffer, sizeof(buffer));
+            TEST_ASSERT_EQUAL(sizeof(buffer), size);
+            TEST_ASSERT_EQUAL(j, buffer[0]);
+            TEST_ASSERT_EQUAL(j, buffer[sizeof(buffer)-1]);
+        }
+        err = file.close();
+        TEST_ASSERT_EQUAL(0, err);
+        err = fs.unmount();
+        TEST_ASSERT_EQUAL(0, err);
+    }
+
+    TEST_ASSERT(erase_counts[1] < erase_counts[0]);
+    TEST_ASSERT(program_counts[1] < program_counts[0]);
+}
+
+// Block device that sleeps on each program, so other threads can run
+class SlowBlockDevice : public HeapBlockDevice
+{
+public:
+    SlowBlockDevice(bd_size_t size, bd_size_t block)
+        : HeapBlockDevice(size, block) {}
+
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size)
+    {
+        Thread::wait(1);
+        return HeapBlockDevice::program(buffer, addr, size);
+    }
+};
+
+struct test_parallel_writer_t {
+    FATFileSystem *fs;
+    int err;
+};
+
+// Runs on its own thread, so errors are checked by the test thread
+static void test_parallel_writer(test_parallel_writer_t *writer)
+{
+    uint8_t buffer[BLOCK_SIZE];
+    memset(buffer, 0x5a, sizeof(buffer));
+
+    File file;
+    writer->err = file.open(writer->fs, "test_parallel.dat", O_WRONLY | O_CREAT | O_TRUNC);
+    for (int i = 0; i < 32 && !writer->err; i++) {
+        ssize_t size = file.write(buffer, sizeof(buffer));
+        if (size != sizeof(buffer)) {
+            writer->err = (size < 0) ? size : -EIO;
+        }
+    }
+
+    if (!writer->err) {
+        writer->err = file.close();
+    }
+}
+
+// Test that separate volumes do not serialize against each other
+void test_parallel_volumes() {
+    SlowBlockDevice bd1(128*BLOCK_SIZE, BLOCK_SIZE);
+    SlowBlockDevice bd2(128*BLOCK_SIZE, BLOCK_SIZE);
+
+    int err = FATFileSystem::format(&bd1);
+    TEST_ASSERT_EQUAL(0, err);
+    err = FATFileSystem::format(&bd2);
+    TEST_ASSERT_EQUAL(0, err);
+
+    FATFileSystem fs1("fat1");
+    FATFileSystem fs2("fat2");
+    err = fs1.mount(&bd1);
+    TEST_ASSERT_EQUAL(0, err);
+    err = fs2.mount(&bd2);
+    TEST_ASSERT_EQUAL(0, err);
+
+    // Time one writer alone, then one writer per volume
+    test_parallel_writer_t writer1 = {&fs1, 0};
+    test_parallel_writer_t writer2 = {&fs2, 0};
+
+    Timer timer;
+    timer.start();
+    test_parallel_writer(&writer1);
+    int single = timer.read_ms();
+    TEST_ASSERT_EQUAL(0, writer1.err);
+
+    timer.reset();
+    Thread thread1(osPriorityNormal, 4096);
+    Thread thread2(osPriorityNormal, 4096);
+    thread1.start(callback(test_parallel_writer, &writer1));
+    thread2.start(callback(test_parallel_writer, &writer2));
+    thread1.join();
+    thread2.join();
+    int parallel = timer.read_ms();
+    TEST_ASSERT_EQUAL(0, writer1.err);
+    TEST_ASSERT_EQUAL(0, writer2.err);
+
+    printf("single: %dms, parallel: %dms\n", single, parallel);
+    TEST_ASSERT(parallel < 3*single/2);
+
+    err = fs1.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+    err = fs2.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+
+// Test random seeks and preallocated sequential writes on a multi-cluster file
+void test_seek_preallocate() {
+    ProfilingBlockDevice profiler(&bd);
+    FATFileSystem fs("fat");
+    int err = FATFileSystem::format(&bd);
+    TEST_ASSERT_EQUAL(0, err);
+    err = fs.mount(&profiler);
+    TEST_ASSERT_EQUAL(0, err);
+
+    uint8_t buffer[BLOCK_SIZE];
+    const int count = 64;
+    int times[2];
+
+    // Sequential write, first growing cluster by cluster, then into a
+    // contiguous preallocation
+    for (int i = 0; i < 2; i++) {
+        File file;
+        err = file.open(&fs, "test_seek_preallocate.dat", O_WRONLY | O_CREAT | O_TRUNC);
+        TEST_ASSERT_EQUAL(0, err);
+
+        Timer timer;
+        timer.start();
+        if (i) {
+            err = file.preallocate(count*sizeof(buffer));
+            TEST_ASSERT_EQUAL(0, err);
+            TEST_ASSERT_EQUAL(count*sizeof(buffer), file.size());
+        }
+        for (int j = 0; j < count; j++) {
+            memset(buffer, j, sizeof(buffer));
+            ssize_t size = file.write(buffer, sizeof(buffer));
+            TEST_ASSERT_EQUAL(sizeof(buffer), size);
+        }
+        err = file.close();
+        TEST_ASSERT_EQUAL(0, err);
+        times[i] = timer.read_us();
+    }
+    printf("write: %dus, preallocated write: %dus\n", times[0], times[1]);
+
+    // Preallocation needs an empty file
+    File file;
+    err = file.open(&fs, "test_seek_preallocate.dat", O_RDWR);
+    TEST_ASSERT_EQUAL(0, err);
+    err = file.preallocate(2*count*sizeof(buffer));
+    TEST_ASSERT_EQUAL(-EACCES, err);
+
+    // Random seeks, the first builds the cluster map
+    srand(1);
+    profiler.reset();
+    Timer timer;
+    timer.start();
+    for (int j = 0; j < 4*count; j++) {
+        int k = rand() % count;
+        off_t res = file.seek(k*sizeof(buffer) + sizeof(buffer)/2, SEEK_SET);
+        TEST_ASSERT_EQUAL(k*sizeof(buffer) + sizeof(buffer)/2, res);
+        ssize_t size = file.read(buffer, 1);
+        TEST_ASSERT_EQUAL(1, size);
+        TEST_ASSERT_EQUAL(k, buffer[0]);
+    }
+    printf("random seek: %dus, read count %llu\n",
+            timer.read_us(), profiler.get_read_count());
+
+    // Growing the file drops the map, seeks must still land correctly
+    off_t res = file.seek(0, SEEK_END);
+    TEST_ASSERT_EQUAL(count*sizeof(buffer), res);
+    memset(buffer, count, sizeof(buffer));
+    ssize_t size = file.write(buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL(sizeof(buffer), size);
+    for (int k = count; k >= 0; k--) {
+        res = file.seek(k*sizeof(buffer), SEEK_SET);
+        TEST_ASSERT_EQUAL(k*sizeof(buffer), res);
+        size = file.read(buffer, sizeof(buffer));
+        TEST_ASSERT_EQUAL(sizeof(buffer), size);
+        TEST_ASSERT_EQUAL(k, buffer[0]);
+        TEST_ASSERT_EQUAL(k, buffer[sizeof(buffer)-1]);
+    }
+
+    err = file.close();
+    TEST_ASSERT_EQUAL(0, err);
+    err = fs.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+
+// Test bulk transfers against the raw block device, and readahead for small reads
+void test_streaming() {
+    ProfilingBlockDevice profiler(&bd);
+    FATFileSystem fs("fat");
+    int err = FATFileSystem::format(&bd, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    err = fs.mount(&profiler);
+    TEST_ASSERT_EQUAL(0, err);
+
+    const size_t size = 32*BLOCK_SIZE;
+    uint8_t *buffer = new uint8_t[size];
+
+    Timer timer;
+    timer.start();
+    err = bd.read(buffer, 0, size);
+    TEST_ASSERT_EQUAL(0, err);
+    int raw = timer.read_us();
+
+    // Bulk transfers span clusters in a single block device operation
+    File file;
+    err = file.open(&fs, "test_streaming.dat", O_RDWR | O_CREAT | O_TRUNC);
+    TEST_ASSERT_EQUAL(0, err);
+    for (size_t i = 0; i < size; i++) {
+        buffer[i] = i / BLOCK_SIZE;
+    }
+    profiler.reset();
+    ssize_t res = file.write(buffer, size);
+    TEST_ASSERT_EQUAL(size, res);
+    // One program for the data, the rest update the FAT and directory
+    TEST_ASSERT(profiler.get_op_count(ProfilingBlockDevice::OP_PROGRAM) <= 4);
+
+    memset(buffer, 0, size);
+    file.rewind();
+    profiler.reset();
+    timer.reset();
+    res = file.read(buffer, size);
+    TEST_ASSERT_EQUAL(size, res);
+    int bulk = timer.read_us();
+    TEST_ASSERT_EQUAL(1, profiler.get_op_count(ProfilingBlockDevice::OP_READ));
+    for (size_t i = 0; i < size; i++) {
+        TEST_ASSERT_EQUAL(i / BLOCK_SIZE, buffer[i]);
+    }
+
+    // Small sequential reads, with and without readahead
+    int small[2];
+    for (int i = 0; i < 2; i++) {
+        err = file.set_readahead(i ? 4*BLOCK_SIZE : 0);
+        TEST_ASSERT_EQUAL(0, err);
+        file.rewind();
+        profiler.reset();
+        timer.reset();
+        for (size_t j = 0; j < size; j += 64) {
+            uint8_t chunk[64];
+            res = file.read(chunk, sizeof(chunk));
+            TEST_ASSERT_EQUAL(sizeof(chunk), res);
+            TEST_ASSERT_EQUAL(j / BLOCK_SIZE, chunk[0]);
+            TEST_ASSERT_EQUAL(j / BLOCK_SIZE, chunk[sizeof(chunk)-1]);
+        }
+        small[i] = timer.read_us();
+        TEST_ASSERT_EQUAL(size, file.tell());
+
+        // Every sector without readahead, one read per buffer with it
+        TEST_ASSERT_EQUAL(size / (i ? 4*BLOCK_SIZE : BLOCK_SIZE),
+                profiler.get_op_count(ProfilingBlockDevice::OP_READ));
+    }
+
+    // Writes after readahead land at the reader's position
+    file.rewind();
+    uint8_t chunk[64];
+    res = file.read(chunk, sizeof(chunk));
+    TEST_ASSERT_EQUAL(sizeof(chunk), res);
+    memset(chunk, 0xff, sizeof(chunk));
+    res = file.write(chunk, sizeof(chunk));
+    TEST_ASSERT_EQUAL(sizeof(chunk), res);
+    off_t pos = file.seek(-(off_t)sizeof(chunk), SEEK_CUR);
+    TEST_ASSERT_EQUAL(sizeof(chunk), pos);
+    res = file.read(chunk, sizeof(chunk));
+    TEST_ASSERT_EQUAL(sizeof(chunk), res);
+    TEST_ASSERT_EQUAL(0xff, chunk[0]);
+    TEST_ASSERT_EQUAL(0xff, chunk[sizeof(chunk)-1]);
+    res = file.read(chunk, sizeof(chunk));
+    TEST_ASSERT_EQUAL(sizeof(chunk), res);
+    TEST_ASSERT_EQUAL(0, chunk[0]);
+
+    printf("raw: %dus, bulk: %dus, small: %dus, small with readahead: %dus\n",
+            raw, bulk, small[0], small[1]);
+
+    delete[] buffer;
+    err = file.close();
+    TEST_ASSERT_EQUAL(0, err);
+    err = fs.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+// Block device that can be made to fail reads
+class FailingBlockDevice : public BlockDevice {
+public:
+    FailingBlockDevice(BlockDevice *bd) : fail_reads(false), _bd(bd) {}
+
+    virtual int init() { return _bd->init(); }
+    virtual int deinit() { return _bd->deinit(); }
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size) {
+        return fail_reads ? BD_ERROR_DEVICE_ERROR : _bd->read(buffer, addr, size);
+    }
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size) {
+        return _bd->program(buffer, addr, size);
+    }
+    virtual int erase(bd_addr_t addr, bd_size_t size) { return _bd->erase(addr, size); }
+    virtual bd_size_t get_read_size() const { return _bd->get_read_size(); }
+    virtual bd_size_t get_program_size() const { return _bd->get_program_size(); }
+    virtual bd_size_t get_erase_size() const { return _bd->get_erase_size(); }
+    virtual bd_size_t size() const { return _bd->size(); }
+
+    bool fail_reads;
+
+private:
+    BlockDevice *_bd;
+};
+
+// Test that read errors are reported rather than looking like end of file
+void test_read_error() {
+    FailingBlockDevice failing(&bd);
+    FATFileSystem fs("fat");
+    int err = FATFileSystem::format(&bd, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    err = fs.mount(&failing);
+    TEST_ASSERT_EQUAL(0, err);
+
+    const size_t size = 32*BLOCK_SIZE;
+    uint8_t *buffer = new uint8_t[size];
+    memset(buffer, 0x5a, size);
+
+    File file;
+    err = file.open(&fs, "test_read_error.dat", O_RDWR | O_CREAT | O_TRUNC);
+    TEST_ASSERT_EQUAL(0, err);
+    ssize_t res = file.write(buffer, size);
+    TEST_ASSERT_EQUAL(size, res);
+    err = file.sync();
+    TEST_ASSERT_EQUAL(0, err);
+
+    // Plain reads and readahead fills fail
+    for (int i = 0; i < 2; i++) {
+        err = file.set_readahead(i ? 4*BLOCK_SIZE : 0);
+        TEST_ASSERT_EQUAL(0, err);
+        file.rewind();
+        failing.fail_reads = true;
+        res = file.read(buffer, i ? 64 : size);
+        failing.fail_reads = false;
+        TEST_ASSERT(res < 0);
+    }
+
+    // Readahead with a large read goes directly to the filesystem
+    file.rewind();
+    failing.fail_reads = true;
+    res = file.read(buffer, size);
+    failing.fail_reads = false;
+    TEST_ASSERT(res < 0);
+
+    delete[] buffer;
+    err = file.close();
+    TEST_ASSERT_EQUAL(0, err);
+    err = fs.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
 
 // Test setup
 utest::v1::status_t test_setup(const size_t number_of_cases) {
-    GREENTEA_SETUP(10, "default_auto");
+    GREENTEA_SETUP(20, "default_auto");
     return verbose_test_setup_handler(number_of_cases);
 }
 
@@ -157,6 +553,11 @@ Case cases[] = {
     Case("Testing read write < block", test_read_write<BLOCK_SIZE/2>),
     Case("Testing read write > block", test_read_write<2*BLOCK_SIZE>),
     Case("Testing dir iteration", test_read_dir),
+    Case("Testing buffered append", test_buffered_append),
+    Case("Testing parallel volumes", test_parallel_volumes),
+    Case("Testing seek and preallocate", test_seek_preallocate),
+    Case("Testing streaming", test_streaming),
+    Case("Testing read errors", test_read_error),
 };
 
 Specification specification(test_setup, cases);
@@ -0,0 +1,238 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+
+#include "FATFileSystem.h"
+#include "LittleFileSystem.h"
+#include "ProfilingBlockDevice.h"
+#include <stdlib.h>
+#include <errno.h>
+
+using namespace utest::v1;
+
+// Runs identical workloads against FAT and littlefs and reports throughput
+// and flash operations. Host builds can point this at a large image with a
+// latency model with something like:
+//   -DMBED_TEST_BLOCKDEVICE=FileBlockDevice
+//   -DMBED_TEST_BLOCKDEVICE_DECL='FileBlockDevice bd("bench.img", MBED_TEST_SIZE)'
+//   -DMBED_TEST_SIZE='(64*1024*1024)'
+//   -DMBED_TEST_BLOCKDEVICE_SETUP='bd.set_latency((FileBlockDevice::latency){50, 25, 200, 2000})'
+//   -DMBED_TEST_CLOCK='callback(&bd, &FileBlockDevice::get_time)'
+
+// test configuration
+#ifndef MBED_TEST_SIZE
+#define MBED_TEST_SIZE (128*512)
+#endif
+
+#ifndef MBED_TEST_BLOCKDEVICE
+#define MBED_TEST_BLOCKDEVICE HeapBlockDevice
+#define MBED_TEST_BLOCKDEVICE_DECL MBED_TEST_BLOCKDEVICE bd(MBED_TEST_SIZE, 512)
+#endif
+
+#ifndef MBED_TEST_BLOCKDEVICE_DECL
+#define MBED_TEST_BLOCKDEVICE_DECL MBED_TEST_BLOCKDEVICE bd
+#endif
+
+#ifndef MBED_TEST_TIMEOUT
+#define MBED_TEST_TIMEOUT 480
+#endif
+
+// Workloads scale with the device, the defaults fit a 64KiB device
+#define BENCH_SCALE ((MBED_TEST_SIZE) / (128*512))
+#define BENCH_LOG_SIZE (16*1024*BENCH_SCALE)
+#define BENCH_LOG_RECORD 64
+#define BENCH_LOG_SYNC 8
+#define BENCH_UPDATE_SIZE (8*1024*BENCH_SCALE)
+#define BENCH_UPDATE_CHUNK 256
+#define BENCH_UPDATE_COUNT (64*BENCH_SCALE)
+#define BENCH_CHURN_COUNT (32*BENCH_SCALE)
+#define BENCH_CHURN_LIVE 8
+#define BENCH_CHURN_SIZE 256
+
+
+// declarations
+#define STRINGIZE(x) STRINGIZE2(x)
+#define STRINGIZE2(x) #x
+#define INCLUDE(x) STRINGIZE(x.h)
+
+#include INCLUDE(MBED_TEST_BLOCKDEVICE)
+
+MBED_TEST_BLOCKDEVICE_DECL;
+ProfilingBlockDevice profiler(&bd);
+
+FATFileSystem fat("fat");
+LittleFileSystem lfs("lfs");
+
+enum bench_fs {
+    BENCH_FAT,
+    BENCH_LFS,
+};
+
+static FileSystem *const filesystems[] = {&fat, &lfs};
+static const char *const filesystem_names[] = {"fat", "littlefs"};
+
+static uint8_t buffer[BENCH_UPDATE_CHUNK];
+
+
+// Append small records to a log, syncing periodically
+static size_t bench_append(FileSystem *fs) {
+    File file;
+    int err = file.open(fs, "log", O_WRONLY | O_CREAT | O_APPEND);
+    TEST_ASSERT_EQUAL(0, err);
+
+    memset(buffer, 'l', BENCH_LOG_RECORD);
+    for (int i = 0; i < BENCH_LOG_SIZE / BENCH_LOG_RECORD; i++) {
+        ssize_t res = file.write(buffer, BENCH_LOG_RECORD);
+        TEST_ASSERT_EQUAL(BENCH_LOG_RECORD, res);
+
+        if (i % BENCH_LOG_SYNC == BENCH_LOG_SYNC-1) {
+            err = file.sync();
+            TEST_ASSERT_EQUAL(0, err);
+        }
+    }
+
+    err = file.close();
+    TEST_ASSERT_EQUAL(0, err);
+    return BENCH_LOG_SIZE;
+}
+
+// Rewrite random chunks of an existing file, syncing after each
+static size_t bench_update(FileSystem *fs) {
+    File file;
+    int err = file.open(fs, "data", O_RDWR | O_CREAT);
+    TEST_ASSERT_EQUAL(0, err);
+
+    memset(buffer, 'd', BENCH_UPDATE_CHUNK);
+    for (int i = 0; i < BENCH_UPDATE_SIZE / BENCH_UPDATE_CHUNK; i++) {
+        ssize_t res = file.write(buffer, BENCH_UPDATE_CHUNK);
+        TEST_ASSERT_EQUAL(BENCH_UPDATE_CHUNK, res);
+    }
+
+    err = file.sync();
+    TEST_ASSERT_EQUAL(0, err);
+
+    srand(1);
+    for (int i = 0; i < BENCH_UPDATE_COUNT; i++) {
+        off_t off = (rand() % (BENCH_UPDATE_SIZE / BENCH_UPDATE_CHUNK)) * BENCH_UPDATE_CHUNK;
+        off_t pos = file.seek(off, SEEK_SET);
+        TEST_ASSERT_EQUAL(off, pos);
+
+        memset(buffer, 'a' + i % 26, BENCH_UPDATE_CHUNK);
+        ssize_t res = file.write(buffer, BENCH_UPDATE_CHUNK);
+        TEST_ASSERT_EQUAL(BENCH_UPDATE_CHUNK, res);
+
+        err = file.sync();
+        TEST_ASSERT_EQUAL(0, err);
+    }
+
+    err = file.close();
+    TEST_ASSERT_EQUAL(0, err);
+    return BENCH_UPDATE_SIZE + BENCH_UPDATE_COUNT*BENCH_UPDATE_CHUNK;
+}
+
+// Create and remove small files in a directory, keeping a few alive
+static size_t bench_churn(FileSystem *fs) {
+    char path[32];
+    int err = fs->mkdir("churn", 0777);
+    TEST_ASSERT_EQUAL(0, err);
+
+    memset(buffer, 'c', BENCH_CHURN_SIZE);
+    for (int i = 0; i < BENCH_CHURN_COUNT; i++) {
+        File file;
+        sprintf(path, "churn/file%d", i);
+        err = file.open(fs, path, O_WRONLY | O_CREAT | O_TRUNC);
+        TEST_ASSERT_EQUAL(0, err);
+
+        ssize_t res = file.write(buffer, BENCH_CHURN_SIZE);
+        TEST_ASSERT_EQUAL(BENCH_CHURN_SIZE, res);
+
+        err = file.close();
+        TEST_ASSERT_EQUAL(0, err);
+
+        if (i >= BENCH_CHURN_LIVE) {
+            sprintf(path, "churn/file%d", i - BENCH_CHURN_LIVE);
+            err = fs->remove(path);
+            TEST_ASSERT_EQUAL(0, err);
+        }
+    }
+
+    return BENCH_CHURN_COUNT*BENCH_CHURN_SIZE;
+}
+
+template <bench_fs index, size_t (*workload)(FileSystem *)>
+void test_bench() {
+    FileSystem *fs = filesystems[index];
+    int err = fs->reformat(&profiler);
+    TEST_ASSERT_EQUAL(0, err);
+    profiler.reset();
+
+    Timer timer;
+    timer.start();
+    size_t size = workload(fs);
+    err = fs->unmount();
+    TEST_ASSERT_EQUAL(0, err);
+    timer.stop();
+
+    uint64_t device_us = 0;
+    for (int op = 0; op < ProfilingBlockDevice::OP_COUNT; op++) {
+        device_us += profiler.get_total_latency((ProfilingBlockDevice::operation)op);
+    }
+
+    int us = timer.read_us();
+    printf("%s: %lu bytes in %d us, %lu KiB/s, device %llu us\n",
+            filesystem_names[index], (unsigned long)size, us,
+            (unsigned long)(us ? (uint64_t)size*1000000/1024/us : 0),
+            (unsigned long long)device_us);
+    printf("  read %llu bytes in %lu ops, program %llu bytes in %lu ops, "
+            "erase %llu bytes in %lu ops\n",
+            (unsigned long long)profiler.get_read_count(),
+            (unsigned long)profiler.get_op_count(ProfilingBlockDevice::OP_READ),
+            (unsigned long long)profiler.get_program_count(),
+            (unsigned long)profiler.get_op_count(ProfilingBlockDevice::OP_PROGRAM),
+            (unsigned long long)profiler.get_erase_count(),
+            (unsigned long)profiler.get_op_count(ProfilingBlockDevice::OP_ERASE));
+}
+
+
+// test setup
+utest::v1::status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(MBED_TEST_TIMEOUT, "default_auto");
+#ifdef MBED_TEST_BLOCKDEVICE_SETUP
+    MBED_TEST_BLOCKDEVICE_SETUP;
+#endif
+#ifdef MBED_TEST_CLOCK
+    profiler.set_clock(MBED_TEST_CLOCK);
+#endif
+    return verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("Append log on FAT", test_bench<BENCH_FAT, bench_append>),
+    Case("Append log on littlefs", test_bench<BENCH_LFS, bench_append>),
+    Case("Random update on FAT", test_bench<BENCH_FAT, bench_update>),
+    Case("Random update on littlefs", test_bench<BENCH_LFS, bench_update>),
+    Case("Directory churn on FAT", test_bench<BENCH_FAT, bench_churn>),
+    Case("Directory churn on littlefs", test_bench<BENCH_LFS, bench_churn>),
+};
+
+Specification specification(test_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
@@ -22,6 +22,12 @@
 #include "SlicingBlockDevice.h"
 #include "ChainingBlockDevice.h"
 #include "ProfilingBlockDevice.h"
+#include "BufferedBlockDevice.h"
+#include "AsyncBlockDevice.h"
+#include "ExhaustibleBlockDevice.h"
+#include "WearLevelingBlockDevice.h"
+#include "StripingBlockDevice.h"
+#include "MirroringBlockDevice.h"
 #include <stdlib.h>
 
 using namespace utest::v1;
@@ -238,6 +244,672 @@ void test_profiling() {
     TEST_ASSERT_EQUAL(BLOCK_SIZE, erase_count);
 }
 
+// Fake clock for deterministic latencies, advanced by the slow device below
+static uint32_t profiling_now = 0;
+
+static uint32_t profiling_clock() {
+    return profiling_now;
+}
+
+class SlowHeapBlockDevice : public HeapBlockDevice {
+public:
+    SlowHeapBlockDevice() : HeapBlockDevice(BLOCK_COUNT*BLOCK_SIZE, BLOCK_SIZE) {}
+
+    virtual int read(void *b, bd_addr_t addr, bd_size_t size) {
+        profiling_now += 10;
+        return HeapBlockDevice::read(b, addr, size);
+    }
+
+    virtual int program(const void *b, bd_addr_t addr, bd_size_t size) {
+        profiling_now += 100;
+        return HeapBlockDevice::program(b, addr, size);
+    }
+
+    virtual int erase(bd_addr_t addr, bd_size_t size) {
+        profiling_now += 3000;
+        return HeapBlockDevice::erase(addr, size);
+    }
+};
+
+// Test latency histograms and heat maps against a fake clock
+void test_profiling_latency() {
+    SlowHeapBlockDevice bd;
+    uint8_t *block = new uint8_t[2*BLOCK_SIZE];
+    memset(block, 0, 2*BLOCK_SIZE);
+
+    ProfilingBlockDevice profiler(&bd, 4);
+    profiler.set_clock(profiling_clock);
+
+    int err = profiler.init();
+    TEST_ASSERT_EQUAL(0, err);
+
+    for (int i = 0; i < BLOCK_COUNT; i++) {
+        err = profiler.erase(i*BLOCK_SIZE, BLOCK_SIZE);
+        TEST_ASSERT_EQUAL(0, err);
+    }
+
+    // Second program straddles the first two heat map regions
+    err = profiler.program(block, 0, 2*BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    err = profiler.program(block, 3*BLOCK_SIZE, 2*BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+
+    for (int i = 0; i < 10; i++) {
+        err = profiler.read(block, 0, BLOCK_SIZE);
+        TEST_ASSERT_EQUAL(0, err);
+    }
+
+    err = profiler.sync();
+    TEST_ASSERT_EQUAL(0, err);
+
+    // 3000us falls in [2048, 4096), 100us in [64, 128), 10us in [8, 16)
+    TEST_ASSERT_EQUAL(BLOCK_COUNT, profiler.get_op_count(ProfilingBlockDevice::OP_ERASE));
+    TEST_ASSERT_EQUAL(BLOCK_COUNT, profiler.get_latency_histogram(ProfilingBlockDevice::OP_ERASE, 12));
+    TEST_ASSERT_EQUAL(3000, profiler.get_max_latency(ProfilingBlockDevice::OP_ERASE));
+    TEST_ASSERT_EQUAL(2, profiler.get_latency_histogram(ProfilingBlockDevice::OP_PROGRAM, 7));
+    TEST_ASSERT_EQUAL(200, profiler.get_total_latency(ProfilingBlockDevice::OP_PROGRAM));
+    TEST_ASSERT_EQUAL(10, profiler.get_latency_histogram(ProfilingBlockDevice::OP_READ, 4));
+    TEST_ASSERT_EQUAL(10, profiler.get_latency_percentile(ProfilingBlockDevice::OP_READ, 99));
+    TEST_ASSERT_EQUAL(1, profiler.get_op_count(ProfilingBlockDevice::OP_SYNC));
+
+    // Each region covers a quarter of the device
+    bd_size_t region = BLOCK_COUNT*BLOCK_SIZE / 4;
+    TEST_ASSERT_EQUAL(3*BLOCK_SIZE, profiler.get_heat(ProfilingBlockDevice::OP_PROGRAM, 0));
+    TEST_ASSERT_EQUAL(BLOCK_SIZE, profiler.get_heat(ProfilingBlockDevice::OP_PROGRAM, 1));
+    TEST_ASSERT_EQUAL(10*BLOCK_SIZE, profiler.get_heat(ProfilingBlockDevice::OP_READ, 0));
+    TEST_ASSERT_EQUAL(region, profiler.get_heat(ProfilingBlockDevice::OP_ERASE, 3));
+
+    TEST_ASSERT_EQUAL(1, profiler.get_max_depth());
+    TEST_ASSERT_EQUAL(BLOCK_COUNT+2+10+1, profiler.get_depth_histogram(1));
+
+    err = profiler.export_csv(stdout);
+    TEST_ASSERT_EQUAL(0, err);
+    err = profiler.export_json(stdout);
+    TEST_ASSERT_EQUAL(0, err);
+
+    profiler.reset();
+    TEST_ASSERT_EQUAL(0, profiler.get_op_count(ProfilingBlockDevice::OP_ERASE));
+    TEST_ASSERT_EQUAL(0, profiler.get_heat(ProfilingBlockDevice::OP_READ, 0));
+
+    delete[] block;
+    err = profiler.deinit();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+// Simple test which merges small writes on a buffered block device
+void test_buffering() {
+    HeapBlockDevice bd(BLOCK_COUNT*BLOCK_SIZE, BLOCK_SIZE/8, BLOCK_SIZE/8, BLOCK_SIZE);
+    uint8_t *write_block = new uint8_t[BLOCK_SIZE/8];
+    uint8_t *read_block = new uint8_t[BLOCK_SIZE/8];
+
+    // Test under profiling with buffering on top
+    ProfilingBlockDevice profiler(&bd);
+    BufferedBlockDevice buffered(&profiler, 2);
+
+    int err = buffered.init();
+    TEST_ASSERT_EQUAL(0, err);
+
+    TEST_ASSERT_EQUAL(BLOCK_SIZE/8, buffered.get_erase_size());
+    TEST_ASSERT_EQUAL(BLOCK_COUNT*BLOCK_SIZE, buffered.size());
+
+    // Append records, updating a header in the first block after each
+    const int count = (BLOCK_COUNT-1)*8;
+    srand(1);
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < BLOCK_SIZE/8; j++) {
+            write_block[j] = 0xff & rand();
+        }
+
+        bd_addr_t addr = BLOCK_SIZE + i*(BLOCK_SIZE/8);
+        err = buffered.erase(addr, BLOCK_SIZE/8);
+        TEST_ASSERT_EQUAL(0, err);
+        err = buffered.program(write_block, addr, BLOCK_SIZE/8);
+        TEST_ASSERT_EQUAL(0, err);
+
+        memset(write_block, i, BLOCK_SIZE/8);
+        err = buffered.erase(0, BLOCK_SIZE/8);
+        TEST_ASSERT_EQUAL(0, err);
+        err = buffered.program(write_block, 0, BLOCK_SIZE/8);
+        TEST_ASSERT_EQUAL(0, err);
+
+        // Check that buffered data can be read back
+        err = buffered.read(read_block, 0, BLOCK_SIZE/8);
+        TEST_ASSERT_EQUAL(0, err);
+        TEST_ASSERT_EQUAL(0xff & i, read_block[0]);
+    }
+
+    err = buffered.deinit();
+    TEST_ASSERT_EQUAL(0, err);
+
+    // Without an initialized cache operations fail instead of
+    // touching the released lines
+    err = buffered.read(read_block, 0, BLOCK_SIZE/8);
+    TEST_ASSERT_EQUAL(BD_ERROR_DEVICE_ERROR, err);
+    err = buffered.program(write_block, 0, BLOCK_SIZE/8);
+    TEST_ASSERT_EQUAL(BD_ERROR_DEVICE_ERROR, err);
+    err = buffered.erase(0, BLOCK_SIZE/8);
+    TEST_ASSERT_EQUAL(BD_ERROR_DEVICE_ERROR, err);
+    err = buffered.trim(0, BLOCK_SIZE/8);
+    TEST_ASSERT_EQUAL(BD_ERROR_DEVICE_ERROR, err);
+    err = buffered.sync();
+    TEST_ASSERT_EQUAL(0, err);
+
+    // Check with original block device
+    srand(1);
+    for (int i = 0; i < count; i++) {
+        err = bd.read(read_block, BLOCK_SIZE + i*(BLOCK_SIZE/8), BLOCK_SIZE/8);
+        TEST_ASSERT_EQUAL(0, err);
+
+        for (int j = 0; j < BLOCK_SIZE/8; j++) {
+            TEST_ASSERT_EQUAL(0xff & rand(), read_block[j]);
+        }
+    }
+
+    err = bd.read(read_block, 0, BLOCK_SIZE/8);
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(0xff & (count-1), read_block[0]);
+
+    delete[] write_block;
+    delete[] read_block;
+
+    // Each block should be erased and programmed only once, unbuffered
+    // every record and header update would erase a whole block
+    bd_size_t erase_count = profiler.get_erase_count();
+    TEST_ASSERT_EQUAL(BLOCK_COUNT*BLOCK_SIZE, erase_count);
+    bd_size_t program_count = profiler.get_program_count();
+    TEST_ASSERT_EQUAL(BLOCK_COUNT*BLOCK_SIZE, program_count);
+}
+
+
+// Completion state shared by asynchronous operations
+struct test_async_t {
+    Semaphore sem;
+    int err;
+
+    void complete(int err) {
+        if (err) {
+            this->err = err;
+        }
+        sem.release();
+    }
+};
+
+static void test_async_erased(test_async_t *async, int err) {
+    async->complete(err);
+}
+
+// Test asynchronous operations through a chain of background block devices
+void test_async() {
+    HeapBlockDevice bd1((BLOCK_COUNT/2)*BLOCK_SIZE, BLOCK_SIZE);
+    HeapBlockDevice bd2((BLOCK_COUNT/2)*BLOCK_SIZE, BLOCK_SIZE);
+    uint8_t *write_block = new uint8_t[BLOCK_COUNT*BLOCK_SIZE];
+    uint8_t *read_block = new uint8_t[BLOCK_COUNT*BLOCK_SIZE];
+
+    AsyncBlockDevice async1(&bd1);
+    AsyncBlockDevice async2(&bd2);
+    BlockDevice *bds[] = {&async1, &async2};
+    ChainingBlockDevice chain(bds);
+    SlicingBlockDevice slice(&chain, BLOCK_SIZE, -BLOCK_SIZE);
+
+    int err = slice.init();
+    TEST_ASSERT_EQUAL(0, err);
+
+    // Fill with random sequence
+    srand(1);
+    for (int i = 0; i < BLOCK_COUNT*BLOCK_SIZE; i++) {
+        write_block[i] = 0xff & rand();
+    }
+
+    // Program block by block across both devices, adjacent blocks merge
+    test_async_t async;
+    async.err = 0;
+    const int count = BLOCK_COUNT-2;
+    for (int i = 0; i < count; i++) {
+        err = slice.program_async(&write_block[i*BLOCK_SIZE], i*BLOCK_SIZE, BLOCK_SIZE,
+                callback(&async, &test_async_t::complete));
+        TEST_ASSERT_EQUAL(0, err);
+    }
+
+    for (int i = 0; i < count; i++) {
+        async.sem.wait();
+    }
+    TEST_ASSERT_EQUAL(0, async.err);
+
+    bd_size_t ops = async1.get_op_count() + async2.get_op_count();
+    printf("programs: %d, operations: %llu\n", count, ops);
+    TEST_ASSERT(ops < (bd_size_t)count);
+
+    // Read everything back with one request spanning both devices
+    err = slice.read_async(read_block, 0, count*BLOCK_SIZE,
+            callback(&async, &test_async_t::complete));
+    TEST_ASSERT_EQUAL(0, err);
+    async.sem.wait();
+    TEST_ASSERT_EQUAL(0, async.err);
+    TEST_ASSERT_EQUAL(0, memcmp(write_block, read_block, count*BLOCK_SIZE));
+
+    // Blocking operations are ordered after queued ones
+    memset(write_block, 0x5a, BLOCK_SIZE);
+    err = chain.program_async(write_block, 0, BLOCK_SIZE,
+            callback(&async, &test_async_t::complete));
+    TEST_ASSERT_EQUAL(0, err);
+    err = chain.read(read_block, 0, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(0x5a, read_block[0]);
+    async.sem.wait();
+
+    // Complete on an event queue
+    EventQueue queue;
+    err = chain.erase_async(0, BLOCK_COUNT*BLOCK_SIZE,
+            queue.event(test_async_erased, &async));
+    TEST_ASSERT_EQUAL(0, err);
+    err = chain.sync();
+    TEST_ASSERT_EQUAL(0, err);
+    queue.dispatch(0);
+    int32_t tokens = async.sem.wait(0);
+    TEST_ASSERT_EQUAL(1, tokens);
+    TEST_ASSERT_EQUAL(0, async.err);
+
+    delete[] write_block;
+    delete[] read_block;
+    err = slice.deinit();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+
+// Block device that corrupts a program or loses power part way through
+// one, counting programs from when the fault is armed
+class FaultyBlockDevice : public BlockDevice {
+public:
+    FaultyBlockDevice(BlockDevice *bd)
+        : _bd(bd), _programs(0), _corrupt(-1), _cut(-1) {}
+
+    // Corrupt the given program silently, and fail the given program part
+    // way through and everything after it, -1 for neither
+    void arm(int corrupt, int cut) {
+        _programs = 0;
+        _corrupt = corrupt;
+        _cut = cut;
+    }
+
+    virtual int init() { return _bd->init(); }
+    virtual int deinit() { return _bd->deinit(); }
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size) {
+        return _bd->read(buffer, addr, size);
+    }
+
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size) {
+        int n = _programs++;
+        if (_cut >= 0 && n > _cut) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+
+        if (n == _cut) {
+            // Only the first half makes it
+            bd_size_t half = (size/2 / get_program_size()) * get_program_size();
+            if (half > 0) {
+                _bd->program(buffer, addr, half);
+            }
+            return BD_ERROR_DEVICE_ERROR;
+        }
+
+        if (n == _corrupt) {
+            uint8_t *copy = new uint8_t[size];
+            memcpy(copy, buffer, size);
+            copy[0] ^= 0x01;
+            int err = _bd->program(copy, addr, size);
+            delete[] copy;
+            return err;
+        }
+
+        return _bd->program(buffer, addr, size);
+    }
+
+    virtual int erase(bd_addr_t addr, bd_size_t size) {
+        if (_cut >= 0 && _programs > _cut) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+        return _bd->erase(addr, size);
+    }
+
+    virtual bd_size_t get_read_size() const { return _bd->get_read_size(); }
+    virtual bd_size_t get_program_size() const { return _bd->get_program_size(); }
+    virtual bd_size_t get_erase_size() const { return _bd->get_erase_size(); }
+    virtual bd_size_t size() const { return _bd->size(); }
+
+private:
+    BlockDevice *_bd;
+    int _programs;
+    int _corrupt;
+    int _cut;
+};
+
+// Test that a failed or interrupted write keeps the previous copy of a sector
+void test_wear_leveling_faults() {
+    const int erase_size = 8*BLOCK_SIZE/4;
+    const int erase_count = 2*BLOCK_COUNT;
+    const int sector_size = BLOCK_SIZE/4;
+    uint8_t *block = new uint8_t[sector_size];
+
+    // A write to an open block programs the data and then the header,
+    // a retry opens a new block with a program of its header first
+    const struct {
+        int corrupt;
+        int cut;
+        uint8_t expected;
+    } faults[] = {
+        {-1, 0, 0x11},  // power lost during the data
+        {-1, 1, 0x11},  // power lost during the header
+        { 0, 2, 0x11},  // bad data, power lost during the retry
+        { 1, 2, 0x11},  // bad header, power lost during the retry
+        { 0, -1, 0x22}, // bad data, the retry succeeds
+    };
+
+    for (size_t i = 0; i < sizeof(faults)/sizeof(faults[0]); i++) {
+        HeapBlockDevice bd(erase_count*erase_size, 16, 16, erase_size);
+        FaultyBlockDevice faulty(&bd);
+        WearLevelingBlockDevice ftl(&faulty, sector_size, 4, 8);
+
+        int err = ftl.init();
+        TEST_ASSERT_EQUAL(0, err);
+        memset(block, 0x11, sector_size);
+        err = ftl.program(block, sector_size, sector_size);
+        TEST_ASSERT_EQUAL(0, err);
+
+        faulty.arm(faults[i].corrupt, faults[i].cut);
+        memset(block, 0x22, sector_size);
+        ftl.program(block, sector_size, sector_size);
+        err = ftl.deinit();
+        TEST_ASSERT_EQUAL(0, err);
+
+        // Remount after power is back
+        WearLevelingBlockDevice remount(&bd, sector_size, 4, 8);
+        err = remount.init();
+        TEST_ASSERT_EQUAL(0, err);
+        err = remount.read(block, sector_size, sector_size);
+        TEST_ASSERT_EQUAL(0, err);
+        for (int j = 0; j < sector_size; j++) {
+            TEST_ASSERT_EQUAL(faults[i].expected, block[j]);
+        }
+        err = remount.deinit();
+        TEST_ASSERT_EQUAL(0, err);
+    }
+
+    delete[] block;
+}
+
+// Test that hammering a few sectors spreads wear over all erase blocks
+void test_wear_leveling() {
+    const int erase_size = 8*BLOCK_SIZE/4;
+    const int erase_count = 2*BLOCK_COUNT;
+    const int sector_size = BLOCK_SIZE/4;
+    HeapBlockDevice bd(erase_count*erase_size, 16, 16, erase_size);
+    ExhaustibleBlockDevice exhaustible(&bd, 100000);
+    ProfilingBlockDevice profiler(&exhaustible);
+    WearLevelingBlockDevice ftl(&profiler, sector_size, 4, 8);
+    uint8_t *block = new uint8_t[sector_size];
+
+    int err = ftl.init();
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(sector_size, ftl.get_erase_size());
+    const int count = ftl.size() / sector_size;
+
+    // Fill with static data, then rewrite the first few sectors over and over
+    for (int i = 0; i < count; i++) {
+        memset(block, i, sector_size);
+        err = ftl.program(block, i*sector_size, sector_size);
+        TEST_ASSERT_EQUAL(0, err);
+    }
+
+    profiler.reset();
+    const int writes = 2000;
+    for (int i = 0; i < writes; i++) {
+        memset(block, 0x80 | (i % 8), sector_size);
+        block[0] = i;
+        err = ftl.program(block, (i % 8)*sector_size, sector_size);
+        TEST_ASSERT_EQUAL(0, err);
+    }
+
+    // The mapping is rebuilt from storage
+    err = ftl.deinit();
+    TEST_ASSERT_EQUAL(0, err);
+    err = ftl.init();
+    TEST_ASSERT_EQUAL(0, err);
+
+    for (int i = 0; i < count; i++) {
+        err = ftl.read(block, i*sector_size, sector_size);
+        TEST_ASSERT_EQUAL(0, err);
+        if (i < 8) {
+            TEST_ASSERT_EQUAL(0xff & (writes - 8 + i), block[0]);
+            TEST_ASSERT_EQUAL(0x80 | i, block[sector_size-1]);
+        } else {
+            TEST_ASSERT_EQUAL(0xff & i, block[0]);
+            TEST_ASSERT_EQUAL(0xff & i, block[sector_size-1]);
+        }
+    }
+
+    uint32_t min = 100000;
+    uint32_t max = 0;
+    for (int i = 0; i < erase_count; i++) {
+        uint32_t erases = 100000 - exhaustible.get_erase_cycles(i*erase_size);
+        min = (erases < min) ? erases : min;
+        max = (erases > max) ? erases : max;
+    }
+
+    printf("write amplification: %d%%, erases: %lu-%lu\n",
+            (int)(100*profiler.get_program_count() / (writes*sector_size)),
+            (unsigned long)min, (unsigned long)max);
+    TEST_ASSERT(min > 0);
+    TEST_ASSERT(max - min <= 2*8);
+
+    delete[] block;
+    err = ftl.deinit();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+
+// Test copy-on-write forks of a large sparse heap block device
+void test_heap_fork() {
+    // Far larger than the heap, only written blocks are allocated
+    bd_size_t size = (bd_size_t)4*1024*1024*1024;
+    HeapBlockDevice bd(size, BLOCK_SIZE);
+    uint8_t *write_block = new uint8_t[BLOCK_SIZE];
+    uint8_t *read_block = new uint8_t[BLOCK_SIZE];
+
+    int err = bd.init();
+    TEST_ASSERT_EQUAL(0, err);
+
+    srand(1);
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        write_block[i] = 0xff & rand();
+    }
+
+    err = bd.program(write_block, 0, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    err = bd.program(write_block, size - BLOCK_SIZE, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+
+    HeapBlockDevice *snapshot = bd.fork();
+    TEST_ASSERT(snapshot);
+
+    // Writes after the fork must not leak into the snapshot
+    memset(write_block, 0xaa, BLOCK_SIZE);
+    err = bd.program(write_block, 0, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+
+    err = snapshot->read(read_block, 0, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    srand(1);
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        TEST_ASSERT_EQUAL(0xff & rand(), read_block[i]);
+    }
+
+    // Rewind to the snapshot
+    err = bd.restore(*snapshot);
+    TEST_ASSERT_EQUAL(0, err);
+
+    err = bd.read(read_block, size - BLOCK_SIZE, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    srand(1);
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        TEST_ASSERT_EQUAL(0xff & rand(), read_block[i]);
+    }
+
+    // Trimmed blocks read back as zeros without touching the snapshot
+    err = bd.trim(0, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+
+    err = bd.read(read_block, 0, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        TEST_ASSERT_EQUAL(0, read_block[i]);
+    }
+
+    err = snapshot->read(read_block, 0, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    srand(1);
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        TEST_ASSERT_EQUAL(0xff & rand(), read_block[i]);
+    }
+
+    delete snapshot;
+    delete[] write_block;
+    delete[] read_block;
+    err = bd.deinit();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+// Heap block device that sleeps 1ms per block, like slow flash
+class SleepyHeapBlockDevice : public HeapBlockDevice {
+public:
+    SleepyHeapBlockDevice() : HeapBlockDevice(BLOCK_COUNT*BLOCK_SIZE, BLOCK_SIZE) {}
+
+    virtual int read(void *b, bd_addr_t addr, bd_size_t size) {
+        Thread::wait(size / BLOCK_SIZE);
+        return HeapBlockDevice::read(b, addr, size);
+    }
+
+    virtual int program(const void *b, bd_addr_t addr, bd_size_t size) {
+        Thread::wait(size / BLOCK_SIZE);
+        return HeapBlockDevice::program(b, addr, size);
+    }
+};
+
+// Program and read back the whole device, returning the time taken
+static int sequential_us(BlockDevice *bd, bd_size_t size) {
+    uint8_t *write_block = new uint8_t[size];
+    uint8_t *read_block = new uint8_t[size];
+
+    srand(1);
+    for (bd_size_t i = 0; i < size; i++) {
+        write_block[i] = 0xff & rand();
+    }
+
+    Timer timer;
+    timer.start();
+
+    int err = bd->erase(0, size);
+    TEST_ASSERT_EQUAL(0, err);
+    err = bd->program(write_block, 0, size);
+    TEST_ASSERT_EQUAL(0, err);
+    err = bd->read(read_block, 0, size);
+    TEST_ASSERT_EQUAL(0, err);
+
+    timer.stop();
+    TEST_ASSERT_EQUAL(0, memcmp(write_block, read_block, size));
+
+    delete[] write_block;
+    delete[] read_block;
+    return timer.read_us();
+}
+
+// Read back the whole device, returning the time taken
+static int read_us(BlockDevice *bd, bd_size_t size) {
+    uint8_t *read_block = new uint8_t[size];
+
+    Timer timer;
+    timer.start();
+
+    int err = bd->read(read_block, 0, size);
+    TEST_ASSERT_EQUAL(0, err);
+
+    timer.stop();
+
+    delete[] read_block;
+    return timer.read_us();
+}
+
+// Test striping across block devices that run in parallel
+void test_striping() {
+    SleepyHeapBlockDevice bd1, bd2;
+    AsyncBlockDevice async1(&bd1), async2(&bd2);
+    BlockDevice *bds[] = {&async1, &async2};
+    StripingBlockDevice stripe(bds);
+
+    int err = stripe.init();
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(2*BLOCK_COUNT*BLOCK_SIZE, stripe.size());
+
+    int single_us = sequential_us(&async1, BLOCK_COUNT*BLOCK_SIZE);
+    int stripe_us = sequential_us(&stripe, 2*BLOCK_COUNT*BLOCK_SIZE);
+    printf("single: %d us, striped: %d us for twice the data\n", single_us, stripe_us);
+    TEST_ASSERT(stripe_us < 2*single_us);
+
+    // Odd blocks live on the second block device
+    uint8_t *read_block = new uint8_t[BLOCK_SIZE];
+    uint8_t *stripe_block = new uint8_t[BLOCK_SIZE];
+    err = stripe.read(stripe_block, 3*BLOCK_SIZE, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    err = async2.read(read_block, 1*BLOCK_SIZE, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(0, memcmp(stripe_block, read_block, BLOCK_SIZE));
+
+    delete[] read_block;
+    delete[] stripe_block;
+    err = stripe.deinit();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+// Test mirroring with reads balanced across the mirrors
+void test_mirroring() {
+    SleepyHeapBlockDevice bd1, bd2;
+    ProfilingBlockDevice profiler1(&bd1), profiler2(&bd2);
+    AsyncBlockDevice async1(&profiler1), async2(&profiler2);
+    BlockDevice *bds[] = {&async1, &async2};
+    MirroringBlockDevice mirror(bds);
+
+    int err = mirror.init();
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(BLOCK_COUNT*BLOCK_SIZE, mirror.size());
+
+    sequential_us(&mirror, BLOCK_COUNT*BLOCK_SIZE);
+
+    // Large reads are split across the mirrors, a half each
+    profiler1.reset();
+    profiler2.reset();
+    int mirror_us = read_us(&mirror, BLOCK_COUNT*BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(1, profiler1.get_op_count(ProfilingBlockDevice::OP_READ));
+    TEST_ASSERT_EQUAL(1, profiler2.get_op_count(ProfilingBlockDevice::OP_READ));
+    TEST_ASSERT_EQUAL(BLOCK_COUNT*BLOCK_SIZE/2, profiler1.get_read_count());
+    TEST_ASSERT_EQUAL(BLOCK_COUNT*BLOCK_SIZE/2, profiler2.get_read_count());
+
+    // Timing depends on the scheduler, so is only reported
+    int single_us = read_us(&async1, BLOCK_COUNT*BLOCK_SIZE);
+    printf("single: %d us, mirrored: %d us to read\n", single_us, mirror_us);
+
+    // Both mirrors hold the data
+    uint8_t *read_block = new uint8_t[BLOCK_COUNT*BLOCK_SIZE];
+    uint8_t *mirror_block = new uint8_t[BLOCK_COUNT*BLOCK_SIZE];
+    err = async1.read(read_block, 0, BLOCK_COUNT*BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    err = async2.read(mirror_block, 0, BLOCK_COUNT*BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(0, memcmp(mirror_block, read_block, BLOCK_COUNT*BLOCK_SIZE));
+
+    delete[] read_block;
+    delete[] mirror_block;
+    err = mirror.deinit();
+    TEST_ASSERT_EQUAL(0, err);
+}
 
 // Test setup
 utest::v1::status_t test_setup(const size_t number_of_cases) {
@@ -249,6 +921,14 @@ Case cases[] = {
     Case("Testing slicing of a block device", test_slicing),
     Case("Testing chaining of block devices", test_chaining),
     Case("Testing profiling of block devices", test_profiling),
+    Case("Testing profiling latency of block devices", test_profiling_latency),
+    Case("Testing buffering of block devices", test_buffering),
+    Case("Testing asynchronous block devices", test_async),
+    Case("Testing wear leveling of block devices", test_wear_leveling),
+    Case("Testing wear leveling with failed writes", test_wear_leveling_faults),
+    Case("Testing forking of heap block devices", test_heap_fork),
+    Case("Testing striping of block devices", test_striping),
+    Case("Testing mirroring of block devices", test_mirroring),
 };
 
 Specification specification(test_setup, cases);
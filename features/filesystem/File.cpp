@@ -20,12 +20,12 @@
 
 
 File::File()
-    : _fs(0), _file(0)
+    : _fs(0), _file(0), _ra_buffer(0), _ra_size(0), _ra_pos(0), _ra_len(0)
 {
 }
 
 File::File(FileSystem *fs, const char *path, int flags)
-    : _fs(0), _file(0)
+    : _fs(0), _file(0), _ra_buffer(0), _ra_size(0), _ra_pos(0), _ra_len(0)
 {
     open(fs, path, flags);
 }
@@ -35,6 +35,8 @@ File::~File()
     if (_fs) {
         close();
     }
+
+    delete[] _ra_buffer;
 }
 
 int File::open(FileSystem *fs, const char *path, int flags)
@@ -59,18 +61,68 @@ int File::close()
 
     int err = _fs->file_close(_file);
     _fs = 0;
+    _ra_pos = 0;
+    _ra_len = 0;
     return err;
 }
 
 ssize_t File::read(void *buffer, size_t len)
 {
     MBED_ASSERT(_fs);
-    return _fs->file_read(_file, buffer, len);
+    if (!_ra_buffer) {
+        return _fs->file_read(_file, buffer, len);
+    }
+
+    uint8_t *data = static_cast<uint8_t*>(buffer);
+    size_t count = 0;
+    while (count < len) {
+        if (_ra_pos < _ra_len) {
+            size_t diff = _ra_len - _ra_pos;
+            if (diff > len - count) {
+                diff = len - count;
+            }
+
+            memcpy(&data[count], &_ra_buffer[_ra_pos], diff);
+            _ra_pos += diff;
+            count += diff;
+            continue;
+        }
+
+        // Large reads go directly to the filesystem
+        _ra_pos = 0;
+        _ra_len = 0;
+        ssize_t res;
+        if (len - count >= _ra_size) {
+            res = _fs->file_read(_file, &data[count], len - count);
+            if (res < 0 && count == 0) {
+                return res;
+            } else if (res > 0) {
+                count += res;
+            }
+            break;
+        }
+
+        res = _fs->file_read(_file, _ra_buffer, _ra_size);
+        if (res <= 0) {
+            if (res < 0 && count == 0) {
+                return res;
+            }
+            break;
+        }
+        _ra_len = res;
+    }
+
+    return count;
 }
 
 ssize_t File::write(const void *buffer, size_t len)
 {
     MBED_ASSERT(_fs);
+    int err = _ra_drop();
+    if (err) {
+        return err;
+    }
+
     return _fs->file_write(_file, buffer, len);
 }
 
@@ -89,18 +141,38 @@ int File::isatty()
 off_t File::seek(off_t offset, int whence)
 {
     MBED_ASSERT(_fs);
+    if (_ra_len) {
+        // Seeks within the readahead buffer keep it
+        off_t end = _fs->file_tell(_file);
+        off_t start = end - _ra_len;
+        if (whence == SEEK_CUR) {
+            offset += start + _ra_pos;
+            whence = SEEK_SET;
+        }
+
+        if (whence == SEEK_SET && offset >= start && offset <= end) {
+            _ra_pos = offset - start;
+            return offset;
+        }
+
+        _ra_pos = 0;
+        _ra_len = 0;
+    }
+
     return _fs->file_seek(_file, offset, whence);
 }
 
 off_t File::tell()
 {
     MBED_ASSERT(_fs);
-    return _fs->file_tell(_file);
+    return _fs->file_tell(_file) - (off_t)(_ra_len - _ra_pos);
 }
 
 void File::rewind()
 {
     MBED_ASSERT(_fs);
+    _ra_pos = 0;
+    _ra_len = 0;
     return _fs->file_rewind(_file);
 }
 
@@ -110,3 +182,39 @@ off_t File::size()
     return _fs->file_size(_file);
 }
 
+int File::preallocate(off_t size)
+{
+    MBED_ASSERT(_fs);
+    return _fs->file_preallocate(_file, size);
+}
+
+int File::set_readahead(size_t size)
+{
+    if (_fs) {
+        int err = _ra_drop();
+        if (err) {
+            return err;
+        }
+    }
+
+    delete[] _ra_buffer;
+    _ra_buffer = size ? new uint8_t[size] : 0;
+    _ra_size = size;
+    return 0;
+}
+
+int File::_ra_drop()
+{
+    // Move the filesystem's position back to where the reader is
+    if (_ra_pos < _ra_len) {
+        off_t res = _fs->file_seek(_file, -(off_t)(_ra_len - _ra_pos), SEEK_CUR);
+        if (res < 0) {
+            return res;
+        }
+    }
+
+    _ra_pos = 0;
+    _ra_len = 0;
+    return 0;
+}
+
@@ -126,9 +126,42 @@ public:
      */
     virtual off_t size();
 
+    /** Allocate contiguous storage for the file ahead of writing
+     *
+     *  Reserving the space up front lets streaming writes proceed without
+     *  allocating as they go, and keeps the file contiguous on storage.
+     *  The file must be empty and open for writing. The size of the file
+     *  becomes the requested size, and its contents are undefined until
+     *  written.
+     *
+     *  @param size     Size to allocate in bytes
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int preallocate(off_t size);
+
+    /** Set the size of the readahead buffer
+     *
+     *  Small sequential reads are served from a buffer that is refilled
+     *  with a single large read from the filesystem, reads of at least
+     *  the buffer size go directly to the filesystem. Writes and seeks
+     *  outside the buffer discard it. Data buffered ahead is not updated
+     *  by writes through other handles to the same file.
+     *
+     *  @param size     Size of the readahead buffer in bytes, 0 disables readahead
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int set_readahead(size_t size);
+
 private:
+    int _ra_drop();
+
     FileSystem *_fs;
     fs_file_t _file;
+
+    uint8_t *_ra_buffer;
+    size_t _ra_size;
+    size_t _ra_pos;
+    size_t _ra_len;
 };
 
 
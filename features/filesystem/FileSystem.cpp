@@ -79,6 +79,11 @@ off_t FileSystem::file_size(fs_file_t file)
     return size;
 }
 
+int FileSystem::file_preallocate(fs_file_t file, off_t size)
+{
+    return -ENOSYS;
+}
+
 int FileSystem::dir_open(fs_dir_t *dir, const char *path)
 {
     return -ENOSYS;
@@ -196,6 +196,14 @@ protected:
      */
     virtual off_t file_size(fs_file_t file);
 
+    /** Allocate contiguous storage for an empty file
+     *
+     *  @param file     File handle
+     *  @param size     Size to allocate in bytes
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int file_preallocate(fs_file_t file, off_t size);
+
     /** Open a directory on the filesystem
      *
      *  @param dir      Destination for the handle to the directory
@@ -0,0 +1,286 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AsyncBlockDevice.h"
+
+
+enum async_op {
+    ASYNC_READ,
+    ASYNC_PROGRAM,
+    ASYNC_ERASE,
+    ASYNC_TRIM,
+    ASYNC_SYNC,
+};
+
+AsyncBlockDevice::AsyncBlockDevice(BlockDevice *bd, size_t depth, uint32_t stack_size)
+    : _bd(bd), _depth(depth), _stack_size(stack_size)
+    , _requests(0), _head(0), _count(0), _stopping(false), _ops(0)
+    , _cond(_mutex), _thread(0), _thread_id(0)
+{
+    MBED_ASSERT(_depth > 0);
+}
+
+AsyncBlockDevice::~AsyncBlockDevice()
+{
+    _stop();
+    delete[] _requests;
+}
+
+int AsyncBlockDevice::init()
+{
+    int err = _bd->init();
+    if (err) {
+        return err;
+    }
+
+    if (_thread) {
+        return 0;
+    }
+
+    if (!_requests) {
+        _requests = new request[_depth];
+    }
+
+    _head = 0;
+    _count = 0;
+    _stopping = false;
+    _thread = new rtos::Thread(osPriorityNormal, _stack_size);
+    osStatus status = _thread->start(callback(this, &AsyncBlockDevice::_work));
+    if (status != osOK) {
+        delete _thread;
+        _thread = 0;
+        return BD_ERROR_DEVICE_ERROR;
+    }
+
+    return 0;
+}
+
+int AsyncBlockDevice::deinit()
+{
+    _stop();
+    return _bd->deinit();
+}
+
+int AsyncBlockDevice::sync()
+{
+    return _wait(ASYNC_SYNC, 0, 0, 0);
+}
+
+int AsyncBlockDevice::read(void *b, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_read(addr, size));
+    return _wait(ASYNC_READ, static_cast<uint8_t*>(b), addr, size);
+}
+
+int AsyncBlockDevice::program(const void *b, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_program(addr, size));
+    return _wait(ASYNC_PROGRAM, const_cast<uint8_t*>(static_cast<const uint8_t*>(b)), addr, size);
+}
+
+int AsyncBlockDevice::erase(bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_erase(addr, size));
+    return _wait(ASYNC_ERASE, 0, addr, size);
+}
+
+int AsyncBlockDevice::trim(bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_erase(addr, size));
+    return _wait(ASYNC_TRIM, 0, addr, size);
+}
+
+int AsyncBlockDevice::read_async(void *b, bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    MBED_ASSERT(is_valid_read(addr, size));
+    return _submit(ASYNC_READ, static_cast<uint8_t*>(b), addr, size, cb);
+}
+
+int AsyncBlockDevice::program_async(const void *b, bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    MBED_ASSERT(is_valid_program(addr, size));
+    return _submit(ASYNC_PROGRAM, const_cast<uint8_t*>(static_cast<const uint8_t*>(b)), addr, size, cb);
+}
+
+int AsyncBlockDevice::erase_async(bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    MBED_ASSERT(is_valid_erase(addr, size));
+    return _submit(ASYNC_ERASE, 0, addr, size, cb);
+}
+
+bd_size_t AsyncBlockDevice::get_read_size() const
+{
+    return _bd->get_read_size();
+}
+
+bd_size_t AsyncBlockDevice::get_program_size() const
+{
+    return _bd->get_program_size();
+}
+
+bd_size_t AsyncBlockDevice::get_erase_size() const
+{
+    return _bd->get_erase_size();
+}
+
+bd_size_t AsyncBlockDevice::size() const
+{
+    return _bd->size();
+}
+
+bd_size_t AsyncBlockDevice::get_op_count() const
+{
+    return _ops;
+}
+
+void AsyncBlockDevice::waiter::complete(int err)
+{
+    this->err = err;
+    sem.release();
+}
+
+int AsyncBlockDevice::_run(int op, uint8_t *buffer, bd_addr_t addr, bd_size_t size)
+{
+    _ops += 1;
+    switch (op) {
+        case ASYNC_READ:
+            return _bd->read(buffer, addr, size);
+        case ASYNC_PROGRAM:
+            return _bd->program(buffer, addr, size);
+        case ASYNC_ERASE:
+            return _bd->erase(addr, size);
+        case ASYNC_TRIM:
+            return _bd->trim(addr, size);
+        default:
+            return _bd->sync();
+    }
+}
+
+int AsyncBlockDevice::_submit(int op, uint8_t *buffer, bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    if (!_thread) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+
+    // Waiting on the queue from a callback would never finish
+    if (_in_worker()) {
+        cb(_run(op, buffer, addr, size));
+        return 0;
+    }
+
+    _mutex.lock();
+    while (_count == _depth) {
+        _cond.wait();
+    }
+
+    request *r = &_requests[(_head + _count) % _depth];
+    r->op = op;
+    r->buffer = buffer;
+    r->addr = addr;
+    r->size = size;
+    r->cb = cb;
+    _count += 1;
+    _cond.notify_all();
+    _mutex.unlock();
+    return 0;
+}
+
+int AsyncBlockDevice::_wait(int op, uint8_t *buffer, bd_addr_t addr, bd_size_t size)
+{
+    if (!_thread || _in_worker()) {
+        return _run(op, buffer, addr, size);
+    }
+
+    waiter w;
+    int err = _submit(op, buffer, addr, size, callback(&w, &waiter::complete));
+    if (err) {
+        return err;
+    }
+
+    w.sem.wait();
+    return w.err;
+}
+
+bool AsyncBlockDevice::_in_worker()
+{
+    _mutex.lock();
+    bool in_worker = rtos::Thread::gettid() == _thread_id;
+    _mutex.unlock();
+    return in_worker;
+}
+
+void AsyncBlockDevice::_stop()
+{
+    if (!_thread) {
+        return;
+    }
+
+    // The worker finishes the queue before stopping
+    _mutex.lock();
+    _stopping = true;
+    _cond.notify_all();
+    _mutex.unlock();
+
+    _thread->join();
+    delete _thread;
+    _thread = 0;
+    _mutex.lock();
+    _thread_id = 0;
+    _mutex.unlock();
+}
+
+void AsyncBlockDevice::_work()
+{
+    _mutex.lock();
+    _thread_id = rtos::Thread::gettid();
+    while (true) {
+        while (_count == 0 && !_stopping) {
+            _cond.wait();
+        }
+
+        if (_count == 0) {
+            break;
+        }
+
+        // Merge queued operations on adjacent blocks, the requests stay
+        // in the queue until their callbacks are called
+        request *r = &_requests[_head];
+        bd_size_t size = r->size;
+        size_t n = 1;
+        while (n < _count && r->op != ASYNC_SYNC) {
+            request *next = &_requests[(_head + n) % _depth];
+            if (next->op != r->op || next->addr != r->addr + size ||
+                    (r->buffer && next->buffer != r->buffer + size)) {
+                break;
+            }
+
+            size += next->size;
+            n += 1;
+        }
+        _mutex.unlock();
+
+        int err = _run(r->op, r->buffer, r->addr, size);
+        for (size_t i = 0; i < n; i++) {
+            _requests[(_head + i) % _depth].cb(err);
+        }
+
+        _mutex.lock();
+        _head = (_head + n) % _depth;
+        _count -= n;
+        _cond.notify_all();
+    }
+    _mutex.unlock();
+}
@@ -0,0 +1,244 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MBED_ASYNC_BLOCK_DEVICE_H
+#define MBED_ASYNC_BLOCK_DEVICE_H
+
+#include "BlockDevice.h"
+#include "mbed.h"
+
+
+/** Block device for running the operations of another block device in the background
+ *
+ *  Operations are queued and run in order on a worker thread, so the
+ *  caller can keep working during long erases and programs. Queued reads,
+ *  programs, erases and trims of adjacent blocks are merged into a single
+ *  operation on the underlying block device, reads and programs only if
+ *  their buffers are adjacent too. Completion callbacks run on the worker
+ *  thread, operations started from a callback run immediately.
+ *
+ *  The blocking operations wait for their turn in the queue, so they are
+ *  ordered with the asynchronous operations before them.
+ *
+ *  @code
+ *  #include "mbed.h"
+ *  #include "HeapBlockDevice.h"
+ *  #include "AsyncBlockDevice.h"
+ *
+ *  // Create a block device with 64 blocks of size 512
+ *  HeapBlockDevice mem(64*512, 512);
+ *
+ *  // Queue up to 8 operations, completing them on an event queue
+ *  AsyncBlockDevice async(&mem, 8);
+ *  EventQueue queue;
+ *
+ *  void erased(int err) {
+ *      printf("erase done: %d\n", err);
+ *  }
+ *
+ *  int main() {
+ *      async.init();
+ *      async.erase_async(0, 32*512, queue.event(erased));
+ *      queue.dispatch_forever();
+ *  }
+ *  @endcode
+ */
+class AsyncBlockDevice : public BlockDevice
+{
+public:
+    /** Lifetime of the async block device
+     *
+     *  @param bd           Block device to back the AsyncBlockDevice
+     *  @param depth        Number of operations that can be queued, starting
+     *                      an operation on a full queue waits for space
+     *  @param stack_size   Stack size of the worker thread, which also runs
+     *                      the completion callbacks
+     */
+    AsyncBlockDevice(BlockDevice *bd, size_t depth = 8, uint32_t stack_size = OS_STACK_SIZE);
+
+    /** Lifetime of a block device
+     */
+    virtual ~AsyncBlockDevice();
+
+    /** Initialize a block device
+     *
+     *  Starts the worker thread
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int init();
+
+    /** Deinitialize a block device
+     *
+     *  Waits for all queued operations to complete and stops the worker thread
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int deinit();
+
+    /** Ensure data on storage is in sync with the driver
+     *
+     *  Waits for all queued operations to complete
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int sync();
+
+    /** Read blocks from a block device
+     *
+     *  @param buffer   Buffer to read blocks into
+     *  @param addr     Address of block to begin reading from
+     *  @param size     Size to read in bytes, must be a multiple of read block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Program blocks to a block device
+     *
+     *  The blocks must have been erased prior to being programmed
+     *
+     *  @param buffer   Buffer of data to write to blocks
+     *  @param addr     Address of block to begin writing to
+     *  @param size     Size to write in bytes, must be a multiple of program block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Erase blocks on a block device
+     *
+     *  The state of an erased block is undefined until it has been programmed
+     *
+     *  @param addr     Address of block to begin erasing
+     *  @param size     Size to erase in bytes, must be a multiple of erase block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int erase(bd_addr_t addr, bd_size_t size);
+
+    /** Mark blocks as no longer in use
+     *
+     *  @param addr     Address of block to mark as unused
+     *  @param size     Size to mark as unused in bytes, must be a multiple of erase block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int trim(bd_addr_t addr, bd_size_t size);
+
+    /** Start reading blocks from a block device
+     *
+     *  @param buffer   Buffer to write blocks to
+     *  @param addr     Address of block to begin reading from
+     *  @param size     Size to read in bytes, must be a multiple of read block size
+     *  @param cb       Callback called with the result of the read
+     *  @return         0 if the read was queued, negative error code on failure
+     */
+    virtual int read_async(void *buffer, bd_addr_t addr, bd_size_t size, bd_callback_t cb);
+
+    /** Start programming blocks to a block device
+     *
+     *  @param buffer   Buffer of data to write to blocks
+     *  @param addr     Address of block to begin writing to
+     *  @param size     Size to write in bytes, must be a multiple of program block size
+     *  @param cb       Callback called with the result of the program
+     *  @return         0 if the program was queued, negative error code on failure
+     */
+    virtual int program_async(const void *buffer, bd_addr_t addr, bd_size_t size, bd_callback_t cb);
+
+    /** Start erasing blocks on a block device
+     *
+     *  @param addr     Address of block to begin erasing
+     *  @param size     Size to erase in bytes, must be a multiple of erase block size
+     *  @param cb       Callback called with the result of the erase
+     *  @return         0 if the erase was queued, negative error code on failure
+     */
+    virtual int erase_async(bd_addr_t addr, bd_size_t size, bd_callback_t cb);
+
+    /** Get the size of a readable block
+     *
+     *  @return         Size of a readable block in bytes
+     */
+    virtual bd_size_t get_read_size() const;
+
+    /** Get the size of a programable block
+     *
+     *  @return         Size of a programable block in bytes
+     *  @note Must be a multiple of the read size
+     */
+    virtual bd_size_t get_program_size() const;
+
+    /** Get the size of a eraseable block
+     *
+     *  @return         Size of a eraseable block in bytes
+     *  @note Must be a multiple of the program size
+     */
+    virtual bd_size_t get_erase_size() const;
+
+    /** Get the total size of the underlying device
+     *
+     *  @return         Size of the underlying device in bytes
+     */
+    virtual bd_size_t size() const;
+
+    /** Get the number of operations run on the underlying block device
+     *
+     *  Merged operations count once
+     *
+     *  @return         Number of operations run since the worker was started
+     */
+    bd_size_t get_op_count() const;
+
+protected:
+    struct request {
+        int op;
+        uint8_t *buffer;
+        bd_addr_t addr;
+        bd_size_t size;
+        bd_callback_t cb;
+    };
+
+    struct waiter {
+        rtos::Semaphore sem;
+        int err;
+
+        void complete(int err);
+    };
+
+    int _run(int op, uint8_t *buffer, bd_addr_t addr, bd_size_t size);
+    int _submit(int op, uint8_t *buffer, bd_addr_t addr, bd_size_t size, bd_callback_t cb);
+    int _wait(int op, uint8_t *buffer, bd_addr_t addr, bd_size_t size);
+    bool _in_worker();
+    void _stop();
+    void _work();
+
+    BlockDevice *_bd;
+    size_t _depth;
+    uint32_t _stack_size;
+    request *_requests;
+    size_t _head;
+    size_t _count;
+    bool _stopping;
+    bd_size_t _ops;
+    rtos::Mutex _mutex;
+    rtos::ConditionVariable _cond;
+    rtos::Thread *_thread;
+    osThreadId _thread_id;
+};
+
+
+#endif
@@ -18,6 +18,7 @@
 #define MBED_BLOCK_DEVICE_H
 
 #include <stdint.h>
+#include "Callback.h"
 
 
 /** Enum of standard error codes
@@ -38,6 +39,15 @@ typedef uint64_t bd_addr_t;
 typedef uint64_t bd_size_t;
 
 
+/** Type of the completion callback for asynchronous operations
+ *
+ *  Called once with 0 on success or a negative error code on failure.
+ *  An Event from EventQueue::event can be passed to complete an
+ *  operation on an event queue.
+ */
+typedef mbed::Callback<void(int)> bd_callback_t;
+
+
 /** A hardware device capable of writing and reading blocks
  */
 class BlockDevice
@@ -59,6 +69,18 @@ public:
      */
     virtual int deinit() = 0;
 
+    /** Ensure data on storage is in sync with the driver
+     *
+     *  Block devices that buffer writes must write out any pending data
+     *  before returning. Other block devices have nothing to do.
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int sync()
+    {
+        return 0;
+    }
+
     /** Read blocks from a block device
      *
      *  If a failure occurs, it is not possible to determine how many bytes succeeded
@@ -112,6 +134,61 @@ public:
         return 0;
     }
 
+    /** Start reading blocks from a block device
+     *
+     *  The callback is called when the read completes, possibly before
+     *  this function returns. The buffer must remain valid until then.
+     *  Block devices that can't run operations in the background
+     *  complete the read before returning.
+     *
+     *  @param buffer   Buffer to write blocks to
+     *  @param addr     Address of block to begin reading from
+     *  @param size     Size to read in bytes, must be a multiple of read block size
+     *  @param cb       Callback called with the result of the read
+     *  @return         0 if the read was started, negative error code if it
+     *                  couldn't be, in which case the callback is not called
+     */
+    virtual int read_async(void *buffer, bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+    {
+        cb(read(buffer, addr, size));
+        return 0;
+    }
+
+    /** Start programming blocks to a block device
+     *
+     *  The callback is called when the program completes, possibly before
+     *  this function returns. The buffer must remain valid until then.
+     *
+     *  @param buffer   Buffer of data to write to blocks
+     *  @param addr     Address of block to begin writing to
+     *  @param size     Size to write in bytes, must be a multiple of program block size
+     *  @param cb       Callback called with the result of the program
+     *  @return         0 if the program was started, negative error code if it
+     *                  couldn't be, in which case the callback is not called
+     */
+    virtual int program_async(const void *buffer, bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+    {
+        cb(program(buffer, addr, size));
+        return 0;
+    }
+
+    /** Start erasing blocks on a block device
+     *
+     *  The callback is called when the erase completes, possibly before
+     *  this function returns.
+     *
+     *  @param addr     Address of block to begin erasing
+     *  @param size     Size to erase in bytes, must be a multiple of erase block size
+     *  @param cb       Callback called with the result of the erase
+     *  @return         0 if the erase was started, negative error code if it
+     *                  couldn't be, in which case the callback is not called
+     */
+    virtual int erase_async(bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+    {
+        cb(erase(addr, size));
+        return 0;
+    }
+
     /** Get the size of a readable block
      *
      *  @return         Size of a readable block in bytes
@@ -0,0 +1,296 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BufferedBlockDevice.h"
+
+
+BufferedBlockDevice::BufferedBlockDevice(BlockDevice *bd, size_t count)
+    : _bd(bd), _count(count), _unit(0), _lines(0), _buffer(0)
+{
+    MBED_ASSERT(_count > 0);
+}
+
+BufferedBlockDevice::~BufferedBlockDevice()
+{
+    delete[] _lines;
+    delete[] _buffer;
+}
+
+int BufferedBlockDevice::init()
+{
+    int err = _bd->init();
+    if (err) {
+        return err;
+    }
+
+    // Already initialized, keep any buffered writes
+    if (_lines) {
+        return 0;
+    }
+
+    _unit = _bd->get_erase_size();
+    _lines = new line[_count];
+    _buffer = new uint8_t[_count*_unit];
+    for (size_t i = 0; i < _count; i++) {
+        _lines[i].valid = false;
+        _lines[i].dirty = false;
+        _lines[i].buffer = &_buffer[i*_unit];
+    }
+
+    return 0;
+}
+
+int BufferedBlockDevice::deinit()
+{
+    int err = sync();
+    if (err) {
+        return err;
+    }
+
+    delete[] _lines;
+    delete[] _buffer;
+    _lines = 0;
+    _buffer = 0;
+
+    return _bd->deinit();
+}
+
+int BufferedBlockDevice::sync()
+{
+    if (!_lines) {
+        return _bd->sync();
+    }
+
+    for (size_t i = 0; i < _count; i++) {
+        if (_lines[i].valid && _lines[i].dirty) {
+            int err = _flush(&_lines[i]);
+            if (err) {
+                return err;
+            }
+        }
+    }
+
+    return _bd->sync();
+}
+
+BufferedBlockDevice::line *BufferedBlockDevice::_find(bd_addr_t addr)
+{
+    for (size_t i = 0; i < _count; i++) {
+        if (_lines[i].valid && _lines[i].addr == addr) {
+            // Keep lines in most recently used order
+            line found = _lines[i];
+            memmove(&_lines[1], &_lines[0], i*sizeof(line));
+            _lines[0] = found;
+            return &_lines[0];
+        }
+    }
+
+    return 0;
+}
+
+int BufferedBlockDevice::_fetch(bd_addr_t addr, bool load, line **l)
+{
+    *l = _find(addr);
+    if (*l) {
+        return 0;
+    }
+
+    // Reuse the least recently used line, writing it out if needed
+    line victim = _lines[_count-1];
+    if (victim.valid && victim.dirty) {
+        int err = _flush(&victim);
+        if (err) {
+            return err;
+        }
+    }
+
+    // Only read the erase unit if it will be partially overwritten
+    if (load) {
+        int err = _bd->read(victim.buffer, addr, _unit);
+        if (err) {
+            victim.valid = false;
+            _lines[_count-1] = victim;
+            return err;
+        }
+    }
+
+    victim.addr = addr;
+    victim.valid = true;
+    victim.dirty = false;
+    memmove(&_lines[1], &_lines[0], (_count-1)*sizeof(line));
+    _lines[0] = victim;
+    *l = &_lines[0];
+    return 0;
+}
+
+int BufferedBlockDevice::_flush(line *l)
+{
+    int err = _bd->erase(l->addr, _unit);
+    if (err) {
+        return err;
+    }
+
+    err = _bd->program(l->buffer, l->addr, _unit);
+    if (err) {
+        return err;
+    }
+
+    l->dirty = false;
+    return 0;
+}
+
+int BufferedBlockDevice::read(void *b, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_read(addr, size));
+    if (!_lines) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+
+    uint8_t *buffer = static_cast<uint8_t*>(b);
+
+    while (size > 0) {
+        bd_addr_t unit = addr - (addr % _unit);
+        bd_size_t read = unit + _unit - addr;
+        if (read > size) {
+            read = size;
+        }
+
+        // Buffered units are newer than the underlying block device
+        line *l = _find(unit);
+        if (l) {
+            memcpy(buffer, &l->buffer[addr - unit], read);
+        } else {
+            int err = _bd->read(buffer, addr, read);
+            if (err) {
+                return err;
+            }
+        }
+
+        buffer += read;
+        addr += read;
+        size -= read;
+    }
+
+    return 0;
+}
+
+int BufferedBlockDevice::program(const void *b, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_program(addr, size));
+    if (!_lines) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+
+    const uint8_t *buffer = static_cast<const uint8_t*>(b);
+
+    while (size > 0) {
+        bd_addr_t unit = addr - (addr % _unit);
+        bd_size_t program = unit + _unit - addr;
+        if (program > size) {
+            program = size;
+        }
+
+        line *l;
+        int err = _fetch(unit, program != _unit, &l);
+        if (err) {
+            return err;
+        }
+
+        memcpy(&l->buffer[addr - unit], buffer, program);
+        l->dirty = true;
+
+        buffer += program;
+        addr += program;
+        size -= program;
+    }
+
+    return 0;
+}
+
+int BufferedBlockDevice::erase(bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_erase(addr, size));
+    if (!_lines) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+
+    // Erases are deferred until the unit is written out, erased data
+    // is undefined so we don't need to touch the buffer
+    while (size > 0) {
+        bd_addr_t unit = addr - (addr % _unit);
+        bd_size_t erase = unit + _unit - addr;
+        if (erase > size) {
+            erase = size;
+        }
+
+        line *l;
+        int err = _fetch(unit, erase != _unit, &l);
+        if (err) {
+            return err;
+        }
+
+        l->dirty = true;
+
+        addr += erase;
+        size -= erase;
+    }
+
+    return 0;
+}
+
+int BufferedBlockDevice::trim(bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_erase(addr, size));
+    if (!_lines) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+
+    // Only whole erase units can be dropped and trimmed
+    bd_addr_t start = addr + (_unit - addr % _unit) % _unit;
+    bd_addr_t end = addr + size - (addr + size) % _unit;
+    if (start >= end) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < _count; i++) {
+        if (_lines[i].valid &&
+                _lines[i].addr >= start && _lines[i].addr < end) {
+            _lines[i].valid = false;
+        }
+    }
+
+    return _bd->trim(start, end - start);
+}
+
+bd_size_t BufferedBlockDevice::get_read_size() const
+{
+    return _bd->get_read_size();
+}
+
+bd_size_t BufferedBlockDevice::get_program_size() const
+{
+    return _bd->get_program_size();
+}
+
+bd_size_t BufferedBlockDevice::get_erase_size() const
+{
+    return _bd->get_program_size();
+}
+
+bd_size_t BufferedBlockDevice::size() const
+{
+    return _bd->size();
+}
@@ -0,0 +1,176 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MBED_BUFFERED_BLOCK_DEVICE_H
+#define MBED_BUFFERED_BLOCK_DEVICE_H
+
+#include "BlockDevice.h"
+#include "mbed.h"
+
+
+/** Block device for buffering writes to another block device in RAM
+ *
+ *  Whole erase units of the underlying block device are kept in RAM, and
+ *  writes are merged into them until the unit is evicted or the block
+ *  device is synced. Each unit is then erased and programmed once, no
+ *  matter how many times it was written in between. The buffered block
+ *  device reports an erase size equal to the program size, so smaller
+ *  writes can be made without erasing the surrounding unit.
+ *
+ *  Data written is not guaranteed to be on the underlying block device
+ *  until sync or deinit returns.
+ *
+ *  @code
+ *  #include "mbed.h"
+ *  #include "HeapBlockDevice.h"
+ *  #include "BufferedBlockDevice.h"
+ *
+ *  // Create a block device with 64 blocks of size 512 and erase units of 4096
+ *  HeapBlockDevice mem(64*512, 512, 512, 4096);
+ *
+ *  // Buffer up to 2 erase units of writes in RAM
+ *  BufferedBlockDevice buffered(&mem, 2);
+ *  @endcode
+ */
+class BufferedBlockDevice : public BlockDevice
+{
+public:
+    /** Lifetime of the buffered block device
+     *
+     *  @param bd       Block device to back the BufferedBlockDevice
+     *  @param count    Number of erase units to buffer in RAM, the least
+     *                  recently used unit is written out when more are needed
+     */
+    BufferedBlockDevice(BlockDevice *bd, size_t count = 1);
+
+    /** Lifetime of a block device
+     */
+    virtual ~BufferedBlockDevice();
+
+    /** Initialize a block device
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int init();
+
+    /** Deinitialize a block device
+     *
+     *  Any buffered writes are written out before deinitializing
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int deinit();
+
+    /** Ensure data on storage is in sync with the driver
+     *
+     *  Any buffered writes are written out to the underlying block device
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int sync();
+
+    /** Read blocks from a block device
+     *
+     *  @param buffer   Buffer to read blocks into
+     *  @param addr     Address of block to begin reading from
+     *  @param size     Size to read in bytes, must be a multiple of read block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Program blocks to a block device
+     *
+     *  The blocks must have been erased prior to being programmed
+     *
+     *  @param buffer   Buffer of data to write to blocks
+     *  @param addr     Address of block to begin writing to
+     *  @param size     Size to write in bytes, must be a multiple of program block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Erase blocks on a block device
+     *
+     *  The state of an erased block is undefined until it has been programmed
+     *
+     *  @param addr     Address of block to begin erasing
+     *  @param size     Size to erase in bytes, must be a multiple of erase block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int erase(bd_addr_t addr, bd_size_t size);
+
+    /** Mark blocks as no longer in use
+     *
+     *  Buffered writes to erase units that are entirely trimmed are dropped
+     *
+     *  @param addr     Address of block to mark as unused
+     *  @param size     Size to mark as unused in bytes, must be a multiple of erase block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int trim(bd_addr_t addr, bd_size_t size);
+
+    /** Get the size of a readable block
+     *
+     *  @return         Size of a readable block in bytes
+     */
+    virtual bd_size_t get_read_size() const;
+
+    /** Get the size of a programable block
+     *
+     *  @return         Size of a programable block in bytes
+     *  @note Must be a multiple of the read size
+     */
+    virtual bd_size_t get_program_size() const;
+
+    /** Get the size of a eraseable block
+     *
+     *  @return         Size of a eraseable block in bytes
+     *  @note Equal to the program size of the underlying block device
+     */
+    virtual bd_size_t get_erase_size() const;
+
+    /** Get the total size of the underlying device
+     *
+     *  @return         Size of the underlying device in bytes
+     */
+    virtual bd_size_t size() const;
+
+protected:
+    struct line {
+        bd_addr_t addr;
+        bool valid;
+        bool dirty;
+        uint8_t *buffer;
+    };
+
+    int _flush(line *l);
+    int _fetch(bd_addr_t addr, bool load, line **l);
+    line *_find(bd_addr_t addr);
+
+    BlockDevice *_bd;
+    size_t _count;
+    bd_size_t _unit;
+    line *_lines;
+    uint8_t *_buffer;
+};
+
+
+#endif
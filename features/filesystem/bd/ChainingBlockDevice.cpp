@@ -15,6 +15,7 @@
  */
 
 #include "ChainingBlockDevice.h"
+#include "mbed_critical.h"
 
 
 ChainingBlockDevice::ChainingBlockDevice(BlockDevice **bds, size_t bd_count)
@@ -84,6 +85,18 @@ int ChainingBlockDevice::deinit()
     return 0;
 }
 
+int ChainingBlockDevice::sync()
+{
+    for (size_t i = 0; i < _bd_count; i++) {
+        int err = _bds[i]->sync();
+        if (err) {
+            return err;
+        }
+    }
+
+    return 0;
+}
+
 int ChainingBlockDevice::read(void *b, bd_addr_t addr, bd_size_t size)
 {
     MBED_ASSERT(is_valid_read(addr, size));
@@ -175,6 +188,154 @@ int ChainingBlockDevice::erase(bd_addr_t addr, bd_size_t size)
     return 0;
 }
 
+// Remainder of an asynchronous operation spanning multiple block devices,
+// submitted once the part before it completes
+struct ChainingBlockDevice::async_request {
+    ChainingBlockDevice *chain;
+    int op;
+    uint8_t *buffer;
+    bd_addr_t addr;
+    bd_size_t size;
+    bd_callback_t cb;
+
+    void complete(int err)
+    {
+        ChainingBlockDevice *chain = this->chain;
+        int op = this->op;
+        uint8_t *buffer = this->buffer;
+        bd_addr_t addr = this->addr;
+        bd_size_t size = this->size;
+        bd_callback_t cb = this->cb;
+        delete this;
+
+        if (!err) {
+            err = chain->_async(op, buffer, addr, size, cb);
+        }
+
+        if (err) {
+            cb(err);
+        }
+    }
+};
+
+int ChainingBlockDevice::_async(int op, uint8_t *buffer, bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    if (size == 0) {
+        cb(0);
+        return 0;
+    }
+
+    // Find block device containing the first block
+    bd_addr_t next = addr;
+    size_t i = 0;
+    while (addr >= _bds[i]->size()) {
+        addr -= _bds[i]->size();
+        i++;
+    }
+
+    bd_size_t count = size;
+    if (addr + count > _bds[i]->size()) {
+        count = _bds[i]->size() - addr;
+    }
+
+    // The rest continues on the following block devices when this part completes
+    async_request *req = 0;
+    bd_callback_t done = cb;
+    if (count < size) {
+        req = new async_request;
+        req->chain = this;
+        req->op = op;
+        req->buffer = buffer ? buffer + count : 0;
+        req->addr = next + count;
+        req->size = size - count;
+        req->cb = cb;
+        done = callback(req, &async_request::complete);
+    }
+
+    int err;
+    switch (op) {
+        case CHAINING_READ:
+            err = _bds[i]->read_async(buffer, addr, count, done);
+            break;
+        case CHAINING_PROGRAM:
+            err = _bds[i]->program_async(buffer, addr, count, done);
+            break;
+        default:
+            err = _bds[i]->erase_async(addr, count, done);
+            break;
+    }
+
+    if (err) {
+        delete req;
+    }
+
+    return err;
+}
+
+void ChainingBlockDevice::async_group::complete(int err)
+{
+    if (err) {
+        core_util_critical_section_enter();
+        if (!this->err) {
+            this->err = err;
+        }
+        core_util_critical_section_exit();
+    }
+
+    sem.release();
+}
+
+int ChainingBlockDevice::async_group::wait()
+{
+    for (; pending > 0; pending--) {
+        sem.wait();
+    }
+
+    return err;
+}
+
+void ChainingBlockDevice::_issue(async_group *group, size_t i, int op, uint8_t *buffer, bd_addr_t addr, bd_size_t size)
+{
+    bd_callback_t done = callback(group, &async_group::complete);
+
+    int err;
+    switch (op) {
+        case CHAINING_READ:
+            err = _bds[i]->read_async(buffer, addr, size, done);
+            break;
+        case CHAINING_PROGRAM:
+            err = _bds[i]->program_async(buffer, addr, size, done);
+            break;
+        default:
+            err = _bds[i]->erase_async(addr, size, done);
+            break;
+    }
+
+    // The callback is only called for operations that were started
+    if (err) {
+        group->complete(err);
+    }
+    group->pending += 1;
+}
+
+int ChainingBlockDevice::read_async(void *b, bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    MBED_ASSERT(is_valid_read(addr, size));
+    return _async(CHAINING_READ, static_cast<uint8_t*>(b), addr, size, cb);
+}
+
+int ChainingBlockDevice::program_async(const void *b, bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    MBED_ASSERT(is_valid_program(addr, size));
+    return _async(CHAINING_PROGRAM, const_cast<uint8_t*>(static_cast<const uint8_t*>(b)), addr, size, cb);
+}
+
+int ChainingBlockDevice::erase_async(bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    MBED_ASSERT(is_valid_erase(addr, size));
+    return _async(CHAINING_ERASE, 0, addr, size, cb);
+}
+
 bd_size_t ChainingBlockDevice::get_read_size() const
 {
     return _read_size;
@@ -85,6 +85,12 @@ public:
      */
     virtual int deinit();
 
+    /** Ensure data on storage is in sync with the driver
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int sync();
+
     /** Read blocks from a block device
      *
      *  @param buffer   Buffer to write blocks to
@@ -115,6 +121,35 @@ public:
      */
     virtual int erase(bd_addr_t addr, bd_size_t size);
 
+    /** Start reading blocks from a block device
+     *
+     *  @param buffer   Buffer to write blocks to
+     *  @param addr     Address of block to begin reading from
+     *  @param size     Size to read in bytes, must be a multiple of read block size
+     *  @param cb       Callback called with the result of the read
+     *  @return         0 if the read was started, negative error code on failure
+     */
+    virtual int read_async(void *buffer, bd_addr_t addr, bd_size_t size, bd_callback_t cb);
+
+    /** Start programming blocks to a block device
+     *
+     *  @param buffer   Buffer of data to write to blocks
+     *  @param addr     Address of block to begin writing to
+     *  @param size     Size to write in bytes, must be a multiple of program block size
+     *  @param cb       Callback called with the result of the program
+     *  @return         0 if the program was started, negative error code on failure
+     */
+    virtual int program_async(const void *buffer, bd_addr_t addr, bd_size_t size, bd_callback_t cb);
+
+    /** Start erasing blocks on a block device
+     *
+     *  @param addr     Address of block to begin erasing
+     *  @param size     Size to erase in bytes, must be a multiple of erase block size
+     *  @param cb       Callback called with the result of the erase
+     *  @return         0 if the erase was started, negative error code on failure
+     */
+    virtual int erase_async(bd_addr_t addr, bd_size_t size, bd_callback_t cb);
+
     /** Get the size of a readable block
      *
      *  @return         Size of a readable block in bytes
@@ -142,6 +177,28 @@ public:
     virtual bd_size_t size() const;
 
 protected:
+    enum chaining_op {
+        CHAINING_READ,
+        CHAINING_PROGRAM,
+        CHAINING_ERASE,
+    };
+
+    struct async_request;
+    int _async(int op, uint8_t *buffer, bd_addr_t addr, bd_size_t size, bd_callback_t cb);
+
+    // Operations issued to several block devices at once, devices with
+    // asynchronous support run them concurrently
+    struct async_group {
+        rtos::Semaphore sem;
+        int pending;
+        int err;
+
+        async_group() : pending(0), err(0) {}
+        void complete(int err);
+        int wait();
+    };
+    void _issue(async_group *group, size_t i, int op, uint8_t *buffer, bd_addr_t addr, bd_size_t size);
+
     BlockDevice **_bds;
     size_t _bd_count;
     bd_size_t _read_size;
@@ -46,6 +46,11 @@ int ExhaustibleBlockDevice::init()
     return 0;
 }
 
+uint32_t ExhaustibleBlockDevice::get_erase_cycles(bd_addr_t addr) const
+{
+    return _erase_array[addr / get_erase_size()];
+}
+
 int ExhaustibleBlockDevice::deinit()
 {
     // _erase_array is lazily cleaned up in destructor to allow
@@ -53,6 +58,11 @@ int ExhaustibleBlockDevice::deinit()
     return _bd->deinit();
 }
 
+int ExhaustibleBlockDevice::sync()
+{
+    return _bd->sync();
+}
+
 int ExhaustibleBlockDevice::read(void *buffer, bd_addr_t addr, bd_size_t size)
 {
     return _bd->read(buffer, addr, size);
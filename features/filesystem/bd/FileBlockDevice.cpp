@@ -0,0 +1,191 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FileBlockDevice.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+
+FileBlockDevice::FileBlockDevice(const char *path, bd_size_t size,
+        bd_size_t read, bd_size_t program, bd_size_t erase)
+    : _path(path), _read_size(read), _program_size(program), _erase_size(erase)
+    , _size(size), _fd(-1), _delay(false), _time(0)
+{
+    MBED_ASSERT(_size % _erase_size == 0);
+    memset(&_latency, 0, sizeof(_latency));
+}
+
+FileBlockDevice::~FileBlockDevice()
+{
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+int FileBlockDevice::_open()
+{
+    if (_fd >= 0) {
+        return BD_ERROR_OK;
+    }
+
+    int fd = open(_path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+
+    // Grow the image, leaving a hole on filesystems that support it
+    struct stat st;
+    if (fstat(fd, &st) || ((bd_size_t)st.st_size < _size && ftruncate(fd, _size))) {
+        close(fd);
+        return BD_ERROR_DEVICE_ERROR;
+    }
+
+    _fd = fd;
+    return BD_ERROR_OK;
+}
+
+int FileBlockDevice::init()
+{
+    return _open();
+}
+
+int FileBlockDevice::deinit()
+{
+    if (_fd < 0) {
+        return BD_ERROR_OK;
+    }
+
+    int err = fsync(_fd);
+    close(_fd);
+    _fd = -1;
+    return err ? BD_ERROR_DEVICE_ERROR : BD_ERROR_OK;
+}
+
+int FileBlockDevice::sync()
+{
+    MBED_ASSERT(_fd >= 0);
+    return fsync(_fd) ? BD_ERROR_DEVICE_ERROR : BD_ERROR_OK;
+}
+
+void FileBlockDevice::_charge(uint32_t cost, bd_size_t size, bd_size_t block)
+{
+    uint32_t t = _latency.op_us + cost*(uint32_t)(size / block);
+    if (!t) {
+        return;
+    }
+
+    _time += t;
+    if (_delay) {
+        struct timespec ts;
+        ts.tv_sec = t / 1000000;
+        ts.tv_nsec = (t % 1000000) * 1000;
+        while (nanosleep(&ts, &ts) && errno == EINTR);
+    }
+}
+
+int FileBlockDevice::read(void *b, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(_fd >= 0);
+    MBED_ASSERT(is_valid_read(addr, size));
+    uint8_t *buffer = static_cast<uint8_t*>(b);
+    _charge(_latency.read_us, size, _read_size);
+
+    while (size > 0) {
+        ssize_t res = pread(_fd, buffer, size, addr);
+        if (res < 0 && errno == EINTR) {
+            continue;
+        } else if (res <= 0) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+
+        buffer += res;
+        addr += res;
+        size -= res;
+    }
+
+    return 0;
+}
+
+int FileBlockDevice::program(const void *b, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(_fd >= 0);
+    MBED_ASSERT(is_valid_program(addr, size));
+    const uint8_t *buffer = static_cast<const uint8_t*>(b);
+    _charge(_latency.program_us, size, _program_size);
+
+    while (size > 0) {
+        ssize_t res = pwrite(_fd, buffer, size, addr);
+        if (res < 0 && errno == EINTR) {
+            continue;
+        } else if (res <= 0) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+
+        buffer += res;
+        addr += res;
+        size -= res;
+    }
+
+    return 0;
+}
+
+int FileBlockDevice::erase(bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(_fd >= 0);
+    MBED_ASSERT(is_valid_erase(addr, size));
+    _charge(_latency.erase_us, size, _erase_size);
+
+    // Erased blocks are left as is, like HeapBlockDevice
+    return 0;
+}
+
+bd_size_t FileBlockDevice::get_read_size() const
+{
+    return _read_size;
+}
+
+bd_size_t FileBlockDevice::get_program_size() const
+{
+    return _program_size;
+}
+
+bd_size_t FileBlockDevice::get_erase_size() const
+{
+    return _erase_size;
+}
+
+bd_size_t FileBlockDevice::size() const
+{
+    return _size;
+}
+
+void FileBlockDevice::set_latency(const latency &model, bool delay)
+{
+    _latency = model;
+    _delay = delay;
+}
+
+uint32_t FileBlockDevice::get_time() const
+{
+    return _time;
+}
+
+#endif
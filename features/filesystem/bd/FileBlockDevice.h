@@ -0,0 +1,196 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MBED_FILE_BLOCK_DEVICE_H
+#define MBED_FILE_BLOCK_DEVICE_H
+
+#include "BlockDevice.h"
+#include "platform/mbed_assert.h"
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+
+
+/** Block device backed by a file on a POSIX host
+ *
+ *  Useful for driving filesystems with realistic image sizes in host
+ *  builds. The file is created if needed and grown to the device size,
+ *  sparsely where the host filesystem supports it.
+ *
+ *  An optional latency model charges each operation a fixed command cost
+ *  plus a cost per read, program or erase block. The modelled time is
+ *  accumulated in a simulated clock that can drive a ProfilingBlockDevice,
+ *  so results don't depend on the speed of the host disk.
+ *
+ *  @code
+ *  #include "mbed.h"
+ *  #include "FileBlockDevice.h"
+ *  #include "ProfilingBlockDevice.h"
+ *
+ *  // 1 GiB image with 2 KiB pages and 128 KiB erase blocks
+ *  FileBlockDevice bd("nand.img", 1024*1024*1024, 2048, 2048, 128*1024);
+ *  ProfilingBlockDevice profiler(&bd);
+ *
+ *  int main() {
+ *      FileBlockDevice::latency model = {50, 25, 200, 2000};
+ *      bd.set_latency(model);
+ *      profiler.set_clock(callback(&bd, &FileBlockDevice::get_time));
+ *      // ...
+ *  }
+ *  @endcode
+ */
+class FileBlockDevice : public BlockDevice
+{
+public:
+    /** Artificial cost of operations in microseconds
+     */
+    struct latency {
+        uint32_t op_us;         /*!< fixed cost of every operation */
+        uint32_t read_us;       /*!< cost per read block */
+        uint32_t program_us;    /*!< cost per program block */
+        uint32_t erase_us;      /*!< cost per erase block */
+    };
+
+    /** Lifetime of the file block device
+     *
+     *  @param path     Path of the backing file on the host
+     *  @param size     Size of the block device in bytes
+     *  @param read     Minimum read size required in bytes
+     *  @param program  Minimum program size required in bytes
+     *  @param erase    Minimum erase size required in bytes
+     */
+    FileBlockDevice(const char *path, bd_size_t size,
+            bd_size_t read = 512, bd_size_t program = 512, bd_size_t erase = 512);
+    virtual ~FileBlockDevice();
+
+    /** Initialize a block device
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int init();
+
+    /** Deinitialize a block device
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int deinit();
+
+    /** Ensure data on storage is in sync with the driver
+     *
+     *  Flushes the backing file to the host's disk
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int sync();
+
+    /** Read blocks from a block device
+     *
+     *  @param buffer   Buffer to read blocks into
+     *  @param addr     Address of block to begin reading from
+     *  @param size     Size to read in bytes, must be a multiple of read block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Program blocks to a block device
+     *
+     *  The blocks must have been erased prior to being programmed
+     *
+     *  @param buffer   Buffer of data to write to blocks
+     *  @param addr     Address of block to begin writing to
+     *  @param size     Size to write in bytes, must be a multiple of program block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Erase blocks on a block device
+     *
+     *  The state of an erased block is undefined until it has been programmed
+     *
+     *  @param addr     Address of block to begin erasing
+     *  @param size     Size to erase in bytes, must be a multiple of erase block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int erase(bd_addr_t addr, bd_size_t size);
+
+    /** Get the size of a readable block
+     *
+     *  @return         Size of a readable block in bytes
+     */
+    virtual bd_size_t get_read_size() const;
+
+    /** Get the size of a programable block
+     *
+     *  @return         Size of a programable block in bytes
+     */
+    virtual bd_size_t get_program_size() const;
+
+    /** Get the size of a eraseable block
+     *
+     *  @return         Size of a eraseable block in bytes
+     */
+    virtual bd_size_t get_erase_size() const;
+
+    /** Get the total size of the underlying device
+     *
+     *  @return         Size of the underlying device in bytes
+     */
+    virtual bd_size_t size() const;
+
+    /** Set the latency model
+     *
+     *  @param model    Cost of each operation, all zeros disables the model
+     *  @param delay    Also sleep for the modelled time, otherwise the time
+     *                  is only added to the simulated clock
+     */
+    void set_latency(const latency &model, bool delay = false);
+
+    /** Get the simulated clock
+     *
+     *  Suitable for ProfilingBlockDevice::set_clock
+     *
+     *  @return         Modelled time spent in operations in microseconds,
+     *                  wrapping at 2^32
+     */
+    uint32_t get_time() const;
+
+protected:
+    // Open the backing file and grow it to the device size
+    int _open();
+    // Charge an operation to the latency model
+    void _charge(uint32_t cost, bd_size_t size, bd_size_t block);
+
+    const char *_path;
+    bd_size_t _read_size;
+    bd_size_t _program_size;
+    bd_size_t _erase_size;
+    bd_size_t _size;
+    int _fd;
+
+    latency _latency;
+    bool _delay;
+    uint32_t _time;
+};
+
+
+#endif
+
+#endif
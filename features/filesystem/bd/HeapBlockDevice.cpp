@@ -17,39 +17,106 @@
 #include "HeapBlockDevice.h"
 
 
+// Number of index bits resolved by each level of the radix tree
+#define HEAP_RADIX_BITS 6
+#define HEAP_RADIX (1 << HEAP_RADIX_BITS)
+
+// Inner node of the radix tree, leaves at level 0 are blocks
+struct heap_node {
+    uint32_t refs;
+    void *slots[HEAP_RADIX];
+};
+
+// Block header, followed by the block's data
+struct heap_block {
+    uint32_t refs;
+    uint32_t reserved;
+};
+
+static uint8_t *heap_data(void *b)
+{
+    return reinterpret_cast<uint8_t*>(static_cast<heap_block*>(b) + 1);
+}
+
+static void heap_share(void *p, unsigned level)
+{
+    if (!p) {
+        return;
+    }
+
+    if (level) {
+        static_cast<heap_node*>(p)->refs += 1;
+    } else {
+        static_cast<heap_block*>(p)->refs += 1;
+    }
+}
+
+static void heap_release(void *p, unsigned level)
+{
+    if (!p) {
+        return;
+    }
+
+    if (!level) {
+        heap_block *b = static_cast<heap_block*>(p);
+        b->refs -= 1;
+        if (!b->refs) {
+            free(b);
+        }
+        return;
+    }
+
+    heap_node *n = static_cast<heap_node*>(p);
+    n->refs -= 1;
+    if (!n->refs) {
+        for (int i = 0; i < HEAP_RADIX; i++) {
+            heap_release(n->slots[i], level-1);
+        }
+        free(n);
+    }
+}
+
+static unsigned heap_levels(bd_size_t count)
+{
+    unsigned levels = 1;
+    while (levels*HEAP_RADIX_BITS < 64 && (count-1) >> (levels*HEAP_RADIX_BITS)) {
+        levels += 1;
+    }
+    return levels;
+}
+
+
 HeapBlockDevice::HeapBlockDevice(bd_size_t size, bd_size_t block)
     : _read_size(block), _program_size(block), _erase_size(block)
-    , _count(size / block), _blocks(0)
+    , _count(size / block), _levels(heap_levels(_count)), _root(0)
 {
     MBED_ASSERT(_count * _erase_size == size);
 }
 
 HeapBlockDevice::HeapBlockDevice(bd_size_t size, bd_size_t read, bd_size_t program, bd_size_t erase)
     : _read_size(read), _program_size(program), _erase_size(erase)
-    , _count(size / erase), _blocks(0)
+    , _count(size / erase), _levels(heap_levels(_count)), _root(0)
 {
     MBED_ASSERT(_count * _erase_size == size);
 }
 
 HeapBlockDevice::~HeapBlockDevice()
 {
-    if (_blocks) {
-        for (size_t i = 0; i < _count; i++) {
-            free(_blocks[i]);
-        }
-
-        delete[] _blocks;
-        _blocks = 0;
-    }
+    heap_release(_root, _levels);
+    _root = 0;
 }
 
 int HeapBlockDevice::init()
 {
-    if (!_blocks) {
-        _blocks = new uint8_t*[_count];
-        for (size_t i = 0; i < _count; i++) {
-            _blocks[i] = 0;
+    if (!_root) {
+        heap_node *root = static_cast<heap_node*>(malloc(sizeof(heap_node)));
+        if (!root) {
+            return BD_ERROR_DEVICE_ERROR;
         }
+
+        root->refs = 1;
+        memset(root->slots, 0, sizeof(root->slots));
+        _root = root;
     }
 
     return BD_ERROR_OK;
@@ -57,7 +124,7 @@ int HeapBlockDevice::init()
 
 int HeapBlockDevice::deinit()
 {
-    MBED_ASSERT(_blocks != NULL);
+    MBED_ASSERT(_root != NULL);
     // Memory is lazily cleaned up in destructor to allow
     // data to live across de/reinitialization
     return BD_ERROR_OK;
@@ -65,47 +132,95 @@ int HeapBlockDevice::deinit()
 
 bd_size_t HeapBlockDevice::get_read_size() const
 {
-    MBED_ASSERT(_blocks != NULL);
+    MBED_ASSERT(_root != NULL);
     return _read_size;
 }
 
 bd_size_t HeapBlockDevice::get_program_size() const
 {
-    MBED_ASSERT(_blocks != NULL);
+    MBED_ASSERT(_root != NULL);
     return _program_size;
 }
 
 bd_size_t HeapBlockDevice::get_erase_size() const
 {
-    MBED_ASSERT(_blocks != NULL);
+    MBED_ASSERT(_root != NULL);
     return _erase_size;
 }
 
 bd_size_t HeapBlockDevice::size() const
 {
-    MBED_ASSERT(_blocks != NULL);
+    MBED_ASSERT(_root != NULL);
     return _count * _erase_size;
 }
 
+void **HeapBlockDevice::_slot(bd_addr_t block, bool create)
+{
+    void **slot = &_root;
+    for (unsigned level = _levels; level > 0; level--) {
+        heap_node *n = static_cast<heap_node*>(*slot);
+        if (!n && !create) {
+            return NULL;
+        }
+
+        // Nodes shared with a fork are copied before we modify them
+        if (!n || n->refs > 1) {
+            heap_node *copy = static_cast<heap_node*>(malloc(sizeof(heap_node)));
+            if (!copy) {
+                return NULL;
+            }
+
+            copy->refs = 1;
+            if (n) {
+                for (int i = 0; i < HEAP_RADIX; i++) {
+                    copy->slots[i] = n->slots[i];
+                    heap_share(copy->slots[i], level-1);
+                }
+                n->refs -= 1;
+            } else {
+                memset(copy->slots, 0, sizeof(copy->slots));
+            }
+
+            *slot = copy;
+            n = copy;
+        }
+
+        slot = &n->slots[(block >> ((level-1)*HEAP_RADIX_BITS)) & (HEAP_RADIX-1)];
+    }
+
+    return slot;
+}
+
 int HeapBlockDevice::read(void *b, bd_addr_t addr, bd_size_t size)
 {
-    MBED_ASSERT(_blocks != NULL);
+    MBED_ASSERT(_root != NULL);
     MBED_ASSERT(is_valid_read(addr, size));
     uint8_t *buffer = static_cast<uint8_t*>(b);
 
     while (size > 0) {
         bd_addr_t hi = addr / _erase_size;
         bd_addr_t lo = addr % _erase_size;
+        bd_size_t chunk = _erase_size - lo;
+        if (chunk > size) {
+            chunk = size;
+        }
+
+        // Walk the tree without unsharing anything
+        void *p = _root;
+        for (unsigned level = _levels; p && level > 0; level--) {
+            p = static_cast<heap_node*>(p)->slots[
+                    (hi >> ((level-1)*HEAP_RADIX_BITS)) & (HEAP_RADIX-1)];
+        }
 
-        if (_blocks[hi]) {
-            memcpy(buffer, &_blocks[hi][lo], _read_size);
+        if (p) {
+            memcpy(buffer, &heap_data(p)[lo], chunk);
         } else {
-            memset(buffer, 0, _read_size);
+            memset(buffer, 0, chunk);
         }
 
-        buffer += _read_size;
-        addr += _read_size;
-        size -= _read_size;
+        buffer += chunk;
+        addr += chunk;
+        size -= chunk;
     }
 
     return 0;
@@ -113,26 +228,49 @@ int HeapBlockDevice::read(void *b, bd_addr_t addr, bd_size_t size)
 
 int HeapBlockDevice::program(const void *b, bd_addr_t addr, bd_size_t size)
 {
-    MBED_ASSERT(_blocks != NULL);
+    MBED_ASSERT(_root != NULL);
     MBED_ASSERT(is_valid_program(addr, size));
     const uint8_t *buffer = static_cast<const uint8_t*>(b);
 
     while (size > 0) {
         bd_addr_t hi = addr / _erase_size;
         bd_addr_t lo = addr % _erase_size;
+        bd_size_t chunk = _erase_size - lo;
+        if (chunk > size) {
+            chunk = size;
+        }
 
-        if (!_blocks[hi]) {
-            _blocks[hi] = (uint8_t*)malloc(_erase_size);
-            if (!_blocks[hi]) {
+        void **slot = _slot(hi, true);
+        if (!slot) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+
+        // Copy blocks shared with a fork, unwritten blocks read as zeros
+        heap_block *block = static_cast<heap_block*>(*slot);
+        if (!block || block->refs > 1) {
+            heap_block *copy = static_cast<heap_block*>(
+                    malloc(sizeof(heap_block) + _erase_size));
+            if (!copy) {
                 return BD_ERROR_DEVICE_ERROR;
             }
+
+            copy->refs = 1;
+            if (block) {
+                memcpy(heap_data(copy), heap_data(block), _erase_size);
+                block->refs -= 1;
+            } else {
+                memset(heap_data(copy), 0, _erase_size);
+            }
+
+            *slot = copy;
+            block = copy;
         }
 
-        memcpy(&_blocks[hi][lo], buffer, _program_size);
+        memcpy(&heap_data(block)[lo], buffer, chunk);
 
-        buffer += _program_size;
-        addr += _program_size;
-        size -= _program_size;
+        buffer += chunk;
+        addr += chunk;
+        size -= chunk;
     }
 
     return 0;
@@ -140,10 +278,54 @@ int HeapBlockDevice::program(const void *b, bd_addr_t addr, bd_size_t size)
 
 int HeapBlockDevice::erase(bd_addr_t addr, bd_size_t size)
 {
-    MBED_ASSERT(_blocks != NULL);
+    MBED_ASSERT(_root != NULL);
     MBED_ASSERT(is_valid_erase(addr, size));
     // TODO assert on programming unerased blocks
 
     return 0;
 }
 
+int HeapBlockDevice::trim(bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(_root != NULL);
+    MBED_ASSERT(is_valid_erase(addr, size));
+
+    for (bd_addr_t hi = addr / _erase_size; size > 0; hi++) {
+        void **slot = _slot(hi, false);
+        if (slot) {
+            heap_release(*slot, 0);
+            *slot = 0;
+        }
+
+        size -= _erase_size;
+    }
+
+    return 0;
+}
+
+HeapBlockDevice *HeapBlockDevice::fork() const
+{
+    if (!_root) {
+        return NULL;
+    }
+
+    HeapBlockDevice *bd = new HeapBlockDevice(_count*_erase_size,
+            _read_size, _program_size, _erase_size);
+    bd->_root = _root;
+    heap_share(_root, _levels);
+    return bd;
+}
+
+int HeapBlockDevice::restore(const HeapBlockDevice &snapshot)
+{
+    MBED_ASSERT(snapshot._root != NULL);
+    if (snapshot._count != _count || snapshot._erase_size != _erase_size) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+
+    // Share first in case the snapshot already is this device's state
+    heap_share(snapshot._root, _levels);
+    heap_release(_root, _levels);
+    _root = snapshot._root;
+    return 0;
+}
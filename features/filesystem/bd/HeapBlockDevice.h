@@ -30,6 +30,12 @@
  *
  * Useful for simulating a block device and tests
  *
+ * Blocks are allocated on first program and indexed by a sparse radix
+ * tree, so simulating a large device only costs memory for the blocks that
+ * are actually used. The tree and blocks are reference counted, which lets
+ * fork and restore share state copy-on-write, for example to branch a
+ * device image between power-loss test cases instead of reformatting.
+ *
  * @code
  * #include "mbed.h"
  * #include "HeapBlockDevice.h"
@@ -48,6 +54,13 @@
  *     bd.deinit();
  * }
  * @endcode
+ *
+ * @code
+ * // Snapshot a formatted device and rewind to it after each test case
+ * HeapBlockDevice *snapshot = bd.fork();
+ * // ... run a test case ...
+ * bd.restore(*snapshot);
+ * @endcode
  */
 class HeapBlockDevice : public BlockDevice
 {
@@ -112,6 +125,16 @@ public:
      */
     virtual int erase(bd_addr_t addr, bd_size_t size);
 
+    /** Mark blocks as no longer in use
+     *
+     *  Trimmed blocks are freed and read back as zeros
+     *
+     *  @param addr     Address of block to mark as unused
+     *  @param size     Size to mark as unused in bytes, must be a multiple of erase block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int trim(bd_addr_t addr, bd_size_t size);
+
     /** Get the size of a readable block
      *
      *  @return         Size of a readable block in bytes
@@ -136,12 +159,36 @@ public:
      */
     virtual bd_size_t size() const;
 
+    /** Create a copy of the block device
+     *
+     *  The copy shares its blocks with this device until either side
+     *  programs them, so forking is cheap regardless of the device size.
+     *  The copy is already initialized.
+     *
+     *  @return         New block device owned by the caller, or NULL if
+     *                  this device has not been initialized
+     */
+    HeapBlockDevice *fork() const;
+
+    /** Replace the contents of the block device with another's
+     *
+     *  The contents are shared copy-on-write in the same way as fork.
+     *
+     *  @param snapshot Block device with the same geometry to copy
+     *  @return         0 on success, negative error code on failure
+     */
+    int restore(const HeapBlockDevice &snapshot);
+
 private:
     bd_size_t _read_size;
     bd_size_t _program_size;
     bd_size_t _erase_size;
     bd_size_t _count;
-    uint8_t **_blocks;
+    unsigned _levels;
+    void *_root;
+
+    // Find the tree slot holding a block, unsharing the path to it
+    void **_slot(bd_addr_t block, bool create);
 };
 
 
@@ -234,6 +234,11 @@ int MBRBlockDevice::deinit()
     return _bd->deinit();
 }
 
+int MBRBlockDevice::sync()
+{
+    return _bd->sync();
+}
+
 int MBRBlockDevice::read(void *b, bd_addr_t addr, bd_size_t size)
 {
     MBED_ASSERT(is_valid_read(addr, size));
@@ -252,6 +257,24 @@ int MBRBlockDevice::erase(bd_addr_t addr, bd_size_t size)
     return _bd->erase(addr + _offset, size);
 }
 
+int MBRBlockDevice::read_async(void *b, bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    MBED_ASSERT(is_valid_read(addr, size));
+    return _bd->read_async(b, addr + _offset, size, cb);
+}
+
+int MBRBlockDevice::program_async(const void *b, bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    MBED_ASSERT(is_valid_program(addr, size));
+    return _bd->program_async(b, addr + _offset, size, cb);
+}
+
+int MBRBlockDevice::erase_async(bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    MBED_ASSERT(is_valid_erase(addr, size));
+    return _bd->erase_async(addr + _offset, size, cb);
+}
+
 bd_size_t MBRBlockDevice::get_read_size() const
 {
     return _bd->get_read_size();
@@ -0,0 +1,125 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MirroringBlockDevice.h"
+
+
+MirroringBlockDevice::MirroringBlockDevice(BlockDevice **bds, size_t bd_count)
+    : ChainingBlockDevice(bds, bd_count), _next(0)
+{
+}
+
+int MirroringBlockDevice::init()
+{
+    int err = ChainingBlockDevice::init();
+    if (err) {
+        return err;
+    }
+
+    for (size_t i = 0; i < _bd_count; i++) {
+        bd_size_t size = _bds[i]->size() / _erase_size * _erase_size;
+        if (i == 0 || size < _size) {
+            _size = size;
+        }
+    }
+
+    return 0;
+}
+
+int MirroringBlockDevice::_mirror(int op, uint8_t *buffer, bd_addr_t addr, bd_size_t size)
+{
+    async_group group;
+    for (size_t i = 0; i < _bd_count; i++) {
+        _issue(&group, i, op, buffer, addr, size);
+    }
+
+    return group.wait();
+}
+
+int MirroringBlockDevice::read(void *b, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_read(addr, size));
+    uint8_t *buffer = static_cast<uint8_t*>(b);
+
+    // Split the read into a part per mirror, small reads just rotate
+    // through the mirrors
+    size_t first = _next++ % _bd_count;
+    bd_size_t part = (size / _bd_count + _read_size-1) / _read_size * _read_size;
+    if (part < _read_size) {
+        part = _read_size;
+    }
+
+    async_group group;
+    for (size_t i = 0; i*part < size; i++) {
+        bd_size_t count = size - i*part;
+        if (count > part) {
+            count = part;
+        }
+
+        _issue(&group, (first + i) % _bd_count, CHAINING_READ,
+                buffer + i*part, addr + i*part, count);
+    }
+
+    int err = group.wait();
+
+    // Fall back to reading everything from each mirror in turn
+    for (size_t i = 0; err && i < _bd_count; i++) {
+        err = _bds[(first + i) % _bd_count]->read(buffer, addr, size);
+    }
+
+    return err;
+}
+
+int MirroringBlockDevice::program(const void *b, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_program(addr, size));
+    return _mirror(CHAINING_PROGRAM, const_cast<uint8_t*>(static_cast<const uint8_t*>(b)), addr, size);
+}
+
+int MirroringBlockDevice::erase(bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_erase(addr, size));
+    return _mirror(CHAINING_ERASE, 0, addr, size);
+}
+
+int MirroringBlockDevice::trim(bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_erase(addr, size));
+
+    for (size_t i = 0; i < _bd_count; i++) {
+        int err = _bds[i]->trim(addr, size);
+        if (err) {
+            return err;
+        }
+    }
+
+    return 0;
+}
+
+int MirroringBlockDevice::read_async(void *b, bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    return BlockDevice::read_async(b, addr, size, cb);
+}
+
+int MirroringBlockDevice::program_async(const void *b, bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    return BlockDevice::program_async(b, addr, size, cb);
+}
+
+int MirroringBlockDevice::erase_async(bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    return BlockDevice::erase_async(addr, size, cb);
+}
@@ -0,0 +1,100 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MmapBlockDevice.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <sys/mman.h>
+
+
+MmapBlockDevice::MmapBlockDevice(const char *path, bd_size_t size,
+        bd_size_t read, bd_size_t program, bd_size_t erase)
+    : FileBlockDevice(path, size, read, program, erase)
+    , _map(NULL)
+{
+}
+
+MmapBlockDevice::~MmapBlockDevice()
+{
+    if (_map) {
+        munmap(_map, _size);
+    }
+}
+
+int MmapBlockDevice::init()
+{
+    if (_map) {
+        return BD_ERROR_OK;
+    }
+
+    int err = _open();
+    if (err) {
+        return err;
+    }
+
+    void *map = mmap(NULL, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (map == MAP_FAILED) {
+        FileBlockDevice::deinit();
+        return BD_ERROR_DEVICE_ERROR;
+    }
+
+    _map = static_cast<uint8_t*>(map);
+    return BD_ERROR_OK;
+}
+
+int MmapBlockDevice::deinit()
+{
+    int err = BD_ERROR_OK;
+    if (_map) {
+        if (msync(_map, _size, MS_SYNC)) {
+            err = BD_ERROR_DEVICE_ERROR;
+        }
+        munmap(_map, _size);
+        _map = NULL;
+    }
+
+    int derr = FileBlockDevice::deinit();
+    return err ? err : derr;
+}
+
+int MmapBlockDevice::sync()
+{
+    MBED_ASSERT(_map != NULL);
+    return msync(_map, _size, MS_SYNC) ? BD_ERROR_DEVICE_ERROR : BD_ERROR_OK;
+}
+
+int MmapBlockDevice::read(void *b, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(_map != NULL);
+    MBED_ASSERT(is_valid_read(addr, size));
+    _charge(_latency.read_us, size, _read_size);
+
+    memcpy(b, &_map[addr], size);
+    return 0;
+}
+
+int MmapBlockDevice::program(const void *b, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(_map != NULL);
+    MBED_ASSERT(is_valid_program(addr, size));
+    _charge(_latency.program_us, size, _program_size);
+
+    memcpy(&_map[addr], b, size);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,105 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MBED_MMAP_BLOCK_DEVICE_H
+#define MBED_MMAP_BLOCK_DEVICE_H
+
+#include "FileBlockDevice.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+
+/** Block device backed by a memory mapped file on a POSIX host
+ *
+ *  Behaves like FileBlockDevice, but maps the whole image into memory so
+ *  reads and programs are plain copies instead of system calls. The image
+ *  must fit in the host's address space.
+ *
+ *  @code
+ *  #include "mbed.h"
+ *  #include "MmapBlockDevice.h"
+ *
+ *  MmapBlockDevice bd("sd.img", 2ULL*1024*1024*1024);
+ *  @endcode
+ */
+class MmapBlockDevice : public FileBlockDevice
+{
+public:
+    /** Lifetime of the mmap block device
+     *
+     *  @param path     Path of the backing file on the host
+     *  @param size     Size of the block device in bytes
+     *  @param read     Minimum read size required in bytes
+     *  @param program  Minimum program size required in bytes
+     *  @param erase    Minimum erase size required in bytes
+     */
+    MmapBlockDevice(const char *path, bd_size_t size,
+            bd_size_t read = 512, bd_size_t program = 512, bd_size_t erase = 512);
+    virtual ~MmapBlockDevice();
+
+    /** Initialize a block device
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int init();
+
+    /** Deinitialize a block device
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int deinit();
+
+    /** Ensure data on storage is in sync with the driver
+     *
+     *  Writes dirty pages of the mapping back to the host's disk
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int sync();
+
+    /** Read blocks from a block device
+     *
+     *  @param buffer   Buffer to read blocks into
+     *  @param addr     Address of block to begin reading from
+     *  @param size     Size to read in bytes, must be a multiple of read block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Program blocks to a block device
+     *
+     *  The blocks must have been erased prior to being programmed
+     *
+     *  @param buffer   Buffer of data to write to blocks
+     *  @param addr     Address of block to begin writing to
+     *  @param size     Size to write in bytes, must be a multiple of program block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size);
+
+private:
+    uint8_t *_map;
+};
+
+
+#endif
+
+#endif
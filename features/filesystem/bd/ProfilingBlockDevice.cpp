@@ -15,14 +15,55 @@
  */
 
 #include "ProfilingBlockDevice.h"
+#include "mbed_critical.h"
+#include <string.h>
 
 
-ProfilingBlockDevice::ProfilingBlockDevice(BlockDevice *bd)
+static const char *const op_names[ProfilingBlockDevice::OP_COUNT] = {
+    "read", "program", "erase", "trim", "sync",
+};
+
+// Operations that touch an address range, sync is excluded from the heat map
+#define HEAT_OPS ProfilingBlockDevice::OP_SYNC
+
+static uint32_t latency_bucket(uint32_t latency)
+{
+    int bucket = 0;
+    while (latency) {
+        bucket += 1;
+        latency >>= 1;
+    }
+
+    if (bucket >= ProfilingBlockDevice::LATENCY_BUCKETS) {
+        bucket = ProfilingBlockDevice::LATENCY_BUCKETS-1;
+    }
+    return bucket;
+}
+
+static uint32_t latency_floor(int bucket)
+{
+    return bucket ? (uint32_t)1 << (bucket-1) : 0;
+}
+
+ProfilingBlockDevice::ProfilingBlockDevice(BlockDevice *bd, size_t regions)
     : _bd(bd)
     , _read_count(0)
     , _program_count(0)
     , _erase_count(0)
+    , _clock(us_ticker_read)
+    , _depth(0)
+    , _regions(regions)
+    , _heat(NULL)
+{
+    if (_regions) {
+        _heat = new bd_size_t[HEAT_OPS*_regions];
+    }
+    reset();
+}
+
+ProfilingBlockDevice::~ProfilingBlockDevice()
 {
+    delete[] _heat;
 }
 
 int ProfilingBlockDevice::init()
@@ -35,31 +76,102 @@ int ProfilingBlockDevice::deinit()
     return _bd->deinit();
 }
 
+int ProfilingBlockDevice::sync()
+{
+    uint32_t depth = core_util_atomic_incr_u32(&_depth, 1);
+    uint32_t start = _clock();
+    int err = _bd->sync();
+    _finish(OP_SYNC, 0, 0, start, depth);
+    return err;
+}
+
 int ProfilingBlockDevice::read(void *b, bd_addr_t addr, bd_size_t size)
 {
+    uint32_t depth = core_util_atomic_incr_u32(&_depth, 1);
+    uint32_t start = _clock();
     int err = _bd->read(b, addr, size);
-    if (!err) {
-        _read_count += size;
-    }
+    _finish(OP_READ, addr, err ? 0 : size, start, depth);
     return err;
 }
 
 int ProfilingBlockDevice::program(const void *b, bd_addr_t addr, bd_size_t size)
 {
+    uint32_t depth = core_util_atomic_incr_u32(&_depth, 1);
+    uint32_t start = _clock();
     int err = _bd->program(b, addr, size);
-    if (!err) {
-        _program_count += size;
-    }
+    _finish(OP_PROGRAM, addr, err ? 0 : size, start, depth);
     return err;
 }
 
 int ProfilingBlockDevice::erase(bd_addr_t addr, bd_size_t size)
 {
+    uint32_t depth = core_util_atomic_incr_u32(&_depth, 1);
+    uint32_t start = _clock();
     int err = _bd->erase(addr, size);
-    if (!err) {
+    _finish(OP_ERASE, addr, err ? 0 : size, start, depth);
+    return err;
+}
+
+int ProfilingBlockDevice::trim(bd_addr_t addr, bd_size_t size)
+{
+    uint32_t depth = core_util_atomic_incr_u32(&_depth, 1);
+    uint32_t start = _clock();
+    int err = _bd->trim(addr, size);
+    _finish(OP_TRIM, addr, err ? 0 : size, start, depth);
+    return err;
+}
+
+void ProfilingBlockDevice::_finish(operation op, bd_addr_t addr, bd_size_t size,
+        uint32_t start, uint32_t depth)
+{
+    uint32_t latency = _clock() - start;
+    bd_size_t region_size = _heat ? _region_size() : 0;
+
+    core_util_critical_section_enter();
+    op_stats *stats = &_stats[op];
+    stats->count += 1;
+    stats->total += latency;
+    if (latency > stats->max) {
+        stats->max = latency;
+    }
+    stats->histogram[latency_bucket(latency)] += 1;
+
+    if (op == OP_READ) {
+        _read_count += size;
+    } else if (op == OP_PROGRAM) {
+        _program_count += size;
+    } else if (op == OP_ERASE) {
         _erase_count += size;
     }
-    return err;
+
+    if (depth > _max_depth) {
+        _max_depth = depth;
+    }
+    _depths[(depth < DEPTH_BUCKETS ? depth : DEPTH_BUCKETS) - 1] += 1;
+
+    // Split the bytes across every address range the operation touched
+    if (region_size && op < HEAT_OPS) {
+        bd_addr_t end = addr + size;
+        while (addr < end) {
+            size_t region = addr / region_size;
+            if (region >= _regions) {
+                break;
+            }
+
+            bd_addr_t next = (region+1)*region_size;
+            bd_size_t diff = (next < end ? next : end) - addr;
+            _heat[op*_regions + region] += diff;
+            addr += diff;
+        }
+    }
+    core_util_critical_section_exit();
+
+    core_util_atomic_decr_u32(&_depth, 1);
+}
+
+bd_size_t ProfilingBlockDevice::_region_size() const
+{
+    return (_bd->size() + _regions-1) / _regions;
 }
 
 bd_size_t ProfilingBlockDevice::get_read_size() const
@@ -82,11 +194,25 @@ bd_size_t ProfilingBlockDevice::size() const
     return _bd->size();
 }
 
+void ProfilingBlockDevice::set_clock(mbed::Callback<uint32_t()> clock)
+{
+    _clock = clock;
+}
+
 void ProfilingBlockDevice::reset()
 {
+    core_util_critical_section_enter();
     _read_count = 0;
     _program_count = 0;
     _erase_count = 0;
+
+    memset(_stats, 0, sizeof(_stats));
+    _max_depth = 0;
+    memset(_depths, 0, sizeof(_depths));
+    if (_heat) {
+        memset(_heat, 0, HEAT_OPS*_regions*sizeof(bd_size_t));
+    }
+    core_util_critical_section_exit();
 }
 
 bd_size_t ProfilingBlockDevice::get_read_count() const
@@ -103,3 +229,152 @@ bd_size_t ProfilingBlockDevice::get_erase_count() const
 {
     return _erase_count;
 }
+
+uint32_t ProfilingBlockDevice::get_op_count(operation op) const
+{
+    return _stats[op].count;
+}
+
+uint64_t ProfilingBlockDevice::get_total_latency(operation op) const
+{
+    return _stats[op].total;
+}
+
+uint32_t ProfilingBlockDevice::get_max_latency(operation op) const
+{
+    return _stats[op].max;
+}
+
+uint32_t ProfilingBlockDevice::get_latency_histogram(operation op, int bucket) const
+{
+    MBED_ASSERT(bucket >= 0 && bucket < LATENCY_BUCKETS);
+    return _stats[op].histogram[bucket];
+}
+
+uint32_t ProfilingBlockDevice::get_latency_percentile(operation op, float percent) const
+{
+    const op_stats *stats = &_stats[op];
+    if (!stats->count) {
+        return 0;
+    }
+
+    // Walk the buckets until we cover the requested fraction of operations
+    uint64_t target = (uint64_t)(stats->count * (percent / 100.0f) + 0.5f);
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS-1; i++) {
+        seen += stats->histogram[i];
+        if (seen >= target) {
+            uint32_t bound = latency_floor(i+1) - 1;
+            return bound < stats->max ? bound : stats->max;
+        }
+    }
+
+    return stats->max;
+}
+
+bd_size_t ProfilingBlockDevice::get_heat(operation op, size_t region) const
+{
+    if (!_heat || op >= HEAT_OPS || region >= _regions) {
+        return 0;
+    }
+
+    return _heat[op*_regions + region];
+}
+
+uint32_t ProfilingBlockDevice::get_max_depth() const
+{
+    return _max_depth;
+}
+
+uint32_t ProfilingBlockDevice::get_depth_histogram(uint32_t depth) const
+{
+    if (depth == 0) {
+        return 0;
+    }
+
+    return _depths[(depth < DEPTH_BUCKETS ? depth : DEPTH_BUCKETS) - 1];
+}
+
+int ProfilingBlockDevice::export_csv(FILE *stream) const
+{
+    bd_size_t bytes[OP_COUNT] = {_read_count, _program_count, _erase_count, 0, 0};
+    bd_size_t region_size = _heat ? _region_size() : 0;
+
+    fprintf(stream, "metric,op,key,value\n");
+    for (int op = 0; op < OP_COUNT; op++) {
+        const op_stats *stats = &_stats[op];
+        fprintf(stream, "count,%s,,%lu\n", op_names[op],
+                (unsigned long)stats->count);
+        fprintf(stream, "bytes,%s,,%llu\n", op_names[op],
+                (unsigned long long)bytes[op]);
+        fprintf(stream, "total_us,%s,,%llu\n", op_names[op],
+                (unsigned long long)stats->total);
+        fprintf(stream, "max_us,%s,,%lu\n", op_names[op],
+                (unsigned long)stats->max);
+
+        for (int i = 0; i < LATENCY_BUCKETS; i++) {
+            fprintf(stream, "latency_us,%s,%lu,%lu\n", op_names[op],
+                    (unsigned long)latency_floor(i),
+                    (unsigned long)stats->histogram[i]);
+        }
+
+        for (size_t i = 0; op < HEAT_OPS && i < _regions; i++) {
+            fprintf(stream, "heat,%s,%llu,%llu\n", op_names[op],
+                    (unsigned long long)(i*region_size),
+                    (unsigned long long)_heat[op*_regions + i]);
+        }
+    }
+
+    fprintf(stream, "max_depth,,,%lu\n", (unsigned long)_max_depth);
+    for (int i = 0; i < DEPTH_BUCKETS; i++) {
+        fprintf(stream, "depth,,%d,%lu\n", i+1, (unsigned long)_depths[i]);
+    }
+
+    return ferror(stream) ? BD_ERROR_DEVICE_ERROR : 0;
+}
+
+int ProfilingBlockDevice::export_json(FILE *stream) const
+{
+    bd_size_t bytes[OP_COUNT] = {_read_count, _program_count, _erase_count, 0, 0};
+    bd_size_t region_size = _heat ? _region_size() : 0;
+
+    fprintf(stream, "{");
+    for (int op = 0; op < OP_COUNT; op++) {
+        const op_stats *stats = &_stats[op];
+        fprintf(stream, "\"%s\":{\"count\":%lu,\"bytes\":%llu,"
+                "\"total_us\":%llu,\"max_us\":%lu,"
+                "\"p50_us\":%lu,\"p99_us\":%lu,\"latency_us\":[",
+                op_names[op],
+                (unsigned long)stats->count,
+                (unsigned long long)bytes[op],
+                (unsigned long long)stats->total,
+                (unsigned long)stats->max,
+                (unsigned long)get_latency_percentile((operation)op, 50),
+                (unsigned long)get_latency_percentile((operation)op, 99));
+
+        for (int i = 0; i < LATENCY_BUCKETS; i++) {
+            fprintf(stream, "%s%lu", i ? "," : "",
+                    (unsigned long)stats->histogram[i]);
+        }
+        fprintf(stream, "]");
+
+        if (op < HEAT_OPS && _heat) {
+            fprintf(stream, ",\"heat\":[");
+            for (size_t i = 0; i < _regions; i++) {
+                fprintf(stream, "%s%llu", i ? "," : "",
+                        (unsigned long long)_heat[op*_regions + i]);
+            }
+            fprintf(stream, "]");
+        }
+        fprintf(stream, "},");
+    }
+
+    fprintf(stream, "\"region_size\":%llu,\"max_depth\":%lu,\"depth\":[",
+            (unsigned long long)region_size, (unsigned long)_max_depth);
+    for (int i = 0; i < DEPTH_BUCKETS; i++) {
+        fprintf(stream, "%s%lu", i ? "," : "", (unsigned long)_depths[i]);
+    }
+    fprintf(stream, "]}\n");
+
+    return ferror(stream) ? BD_ERROR_DEVICE_ERROR : 0;
+}
@@ -24,6 +24,7 @@
 
 #include "BlockDevice.h"
 #include "mbed.h"
+#include <stdio.h>
 
 
 /** Block device for measuring storage operations of another block device
@@ -42,20 +43,48 @@
  *  printf("read count: %lld\n", profiler.get_read_count());
  *  printf("program count: %lld\n", profiler.get_program_count());
  *  printf("erase count: %lld\n", profiler.get_erase_count());
+ *
+ *  // or dump the latency distributions and heat map
+ *  profiler.export_json(stdout);
  *  @endcode
  */
 class ProfilingBlockDevice : public BlockDevice
 {
 public:
+    /** Operations that are timed by the profiler
+     */
+    enum operation {
+        OP_READ,
+        OP_PROGRAM,
+        OP_ERASE,
+        OP_TRIM,
+        OP_SYNC,
+        OP_COUNT,
+    };
+
+    enum {
+        /** Number of log2 latency buckets, bucket n holds latencies
+         *  in [2^(n-1), 2^n) us, the last bucket holds everything longer
+         */
+        LATENCY_BUCKETS = 24,
+
+        /** Number of queue depth buckets, bucket n holds operations
+         *  that started with n+1 operations in flight
+         */
+        DEPTH_BUCKETS = 8,
+    };
+
     /** Lifetime of the memory block device
      *
      *  @param bd       Block device to back the ProfilingBlockDevice
+     *  @param regions  Number of equally sized address ranges to track in
+     *                  the heat map, 0 disables the heat map
      */
-    ProfilingBlockDevice(BlockDevice *bd);
+    ProfilingBlockDevice(BlockDevice *bd, size_t regions = 0);
 
     /** Lifetime of a block device
      */
-    virtual ~ProfilingBlockDevice() {};
+    virtual ~ProfilingBlockDevice();
 
     /** Initialize a block device
      *
@@ -71,6 +100,12 @@ public:
      */
     virtual int deinit();
 
+    /** Ensure data on storage is in sync with the driver
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int sync();
+
     /** Read blocks from a block device
      *
      *  @param buffer   Buffer to read blocks into
@@ -101,6 +136,14 @@ public:
      */
     virtual int erase(bd_addr_t addr, bd_size_t size);
 
+    /** Mark blocks as no longer in use
+     *
+     *  @param addr     Address of block to mark as unused
+     *  @param size     Size to mark as unused in bytes, must be a multiple of erase block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int trim(bd_addr_t addr, bd_size_t size);
+
     /** Get the size of a readable block
      *
      *  @return         Size of a readable block in bytes
@@ -127,6 +170,16 @@ public:
      */
     virtual bd_size_t size() const;
 
+    /** Set the clock used to time operations
+     *
+     *  Defaults to the microsecond ticker. Host tests can pass in a fake
+     *  clock to get deterministic latencies.
+     *
+     *  @param clock    Callback returning the current time in microseconds,
+     *                  differences are taken modulo 2^32
+     */
+    void set_clock(mbed::Callback<uint32_t()> clock);
+
     /** Reset the current profile counts to zero
      */
     void reset();
@@ -149,11 +202,110 @@ public:
      */
     bd_size_t get_erase_count() const;
 
+    /** Get number of times an operation has been issued
+     *
+     *  Failed operations are timed and counted, but their bytes are not
+     *
+     *  @param op       Operation to query
+     *  @return         The number of operations issued
+     */
+    uint32_t get_op_count(operation op) const;
+
+    /** Get the total time spent in an operation
+     *
+     *  @param op       Operation to query
+     *  @return         Total latency in microseconds
+     */
+    uint64_t get_total_latency(operation op) const;
+
+    /** Get the longest time spent in a single operation
+     *
+     *  @param op       Operation to query
+     *  @return         Worst case latency in microseconds
+     */
+    uint32_t get_max_latency(operation op) const;
+
+    /** Get the number of operations that fell into a latency bucket
+     *
+     *  @param op       Operation to query
+     *  @param bucket   Bucket less than LATENCY_BUCKETS, bucket n holds
+     *                  latencies in [2^(n-1), 2^n) us
+     *  @return         The number of operations in the bucket
+     */
+    uint32_t get_latency_histogram(operation op, int bucket) const;
+
+    /** Estimate a latency percentile from the histogram
+     *
+     *  @param op       Operation to query
+     *  @param percent  Percentile to find, for example 99.9
+     *  @return         Upper bound of the bucket containing the percentile
+     *                  in microseconds, clamped to the worst case latency
+     */
+    uint32_t get_latency_percentile(operation op, float percent) const;
+
+    /** Get the number of bytes an operation touched in an address range
+     *
+     *  @param op       Operation to query, sync is not tracked
+     *  @param region   Address range less than the number of regions passed
+     *                  to the constructor, each covers size()/regions bytes
+     *  @return         The number of bytes touched, or 0 without a heat map
+     */
+    bd_size_t get_heat(operation op, size_t region) const;
+
+    /** Get the largest number of operations that were in flight at once
+     *
+     *  @return         Maximum queue depth seen
+     */
+    uint32_t get_max_depth() const;
+
+    /** Get the number of operations that started at a queue depth
+     *
+     *  @param depth    Queue depth in flight including the operation itself,
+     *                  the last bucket holds everything deeper
+     *  @return         The number of operations issued at that depth
+     */
+    uint32_t get_depth_histogram(uint32_t depth) const;
+
+    /** Write the profile as CSV to a stream
+     *
+     *  Each line is a "metric,op,key,value" record so the output loads
+     *  directly into a spreadsheet or pandas
+     *
+     *  @param stream   Stream to write to
+     *  @return         0 on success or a negative error code on failure
+     */
+    int export_csv(FILE *stream) const;
+
+    /** Write the profile as a JSON object to a stream
+     *
+     *  @param stream   Stream to write to
+     *  @return         0 on success or a negative error code on failure
+     */
+    int export_json(FILE *stream) const;
+
 private:
+    struct op_stats {
+        uint32_t count;
+        uint32_t max;
+        uint64_t total;
+        uint32_t histogram[LATENCY_BUCKETS];
+    };
+
+    void _finish(operation op, bd_addr_t addr, bd_size_t size, uint32_t start, uint32_t depth);
+    bd_size_t _region_size() const;
+
     BlockDevice *_bd;
     bd_size_t _read_count;
     bd_size_t _program_count;
     bd_size_t _erase_count;
+
+    mbed::Callback<uint32_t()> _clock;
+    op_stats _stats[OP_COUNT];
+    uint32_t _depth;
+    uint32_t _max_depth;
+    uint32_t _depths[DEPTH_BUCKETS];
+    size_t _regions;
+    bd_size_t *_heat;
 };
 
 
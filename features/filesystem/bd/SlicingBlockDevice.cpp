@@ -64,6 +64,11 @@ int SlicingBlockDevice::deinit()
     return _bd->deinit();
 }
 
+int SlicingBlockDevice::sync()
+{
+    return _bd->sync();
+}
+
 int SlicingBlockDevice::read(void *b, bd_addr_t addr, bd_size_t size)
 {
     MBED_ASSERT(is_valid_read(addr, size));
@@ -82,6 +87,24 @@ int SlicingBlockDevice::erase(bd_addr_t addr, bd_size_t size)
     return _bd->erase(addr + _start, size);
 }
 
+int SlicingBlockDevice::read_async(void *b, bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    MBED_ASSERT(is_valid_read(addr, size));
+    return _bd->read_async(b, addr + _start, size, cb);
+}
+
+int SlicingBlockDevice::program_async(const void *b, bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    MBED_ASSERT(is_valid_program(addr, size));
+    return _bd->program_async(b, addr + _start, size, cb);
+}
+
+int SlicingBlockDevice::erase_async(bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    MBED_ASSERT(is_valid_erase(addr, size));
+    return _bd->erase_async(addr + _start, size, cb);
+}
+
 bd_size_t SlicingBlockDevice::get_read_size() const
 {
     return _bd->get_read_size();
@@ -0,0 +1,117 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "StripingBlockDevice.h"
+
+
+StripingBlockDevice::StripingBlockDevice(BlockDevice **bds, size_t bd_count)
+    : ChainingBlockDevice(bds, bd_count)
+{
+}
+
+int StripingBlockDevice::init()
+{
+    int err = ChainingBlockDevice::init();
+    if (err) {
+        return err;
+    }
+
+    // Every block device holds the same number of stripes
+    bd_size_t blocks = 0;
+    for (size_t i = 0; i < _bd_count; i++) {
+        bd_size_t count = _bds[i]->size() / _erase_size;
+        if (i == 0 || count < blocks) {
+            blocks = count;
+        }
+    }
+
+    _size = blocks * _erase_size * _bd_count;
+    return 0;
+}
+
+int StripingBlockDevice::_stripe(int op, uint8_t *buffer, bd_addr_t addr, bd_size_t size)
+{
+    // Issue every erase block before waiting so the block devices overlap
+    async_group group;
+    while (size > 0) {
+        bd_addr_t block = addr / _erase_size;
+        bd_addr_t off = addr % _erase_size;
+        bd_size_t count = _erase_size - off;
+        if (count > size) {
+            count = size;
+        }
+
+        _issue(&group, block % _bd_count, op, buffer,
+                (block / _bd_count)*_erase_size + off, count);
+
+        if (buffer) {
+            buffer += count;
+        }
+        addr += count;
+        size -= count;
+    }
+
+    return group.wait();
+}
+
+int StripingBlockDevice::read(void *b, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_read(addr, size));
+    return _stripe(CHAINING_READ, static_cast<uint8_t*>(b), addr, size);
+}
+
+int StripingBlockDevice::program(const void *b, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_program(addr, size));
+    return _stripe(CHAINING_PROGRAM, const_cast<uint8_t*>(static_cast<const uint8_t*>(b)), addr, size);
+}
+
+int StripingBlockDevice::erase(bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_erase(addr, size));
+    return _stripe(CHAINING_ERASE, 0, addr, size);
+}
+
+int StripingBlockDevice::trim(bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_erase(addr, size));
+
+    for (; size > 0; addr += _erase_size, size -= _erase_size) {
+        bd_addr_t block = addr / _erase_size;
+        int err = _bds[block % _bd_count]->trim(
+                (block / _bd_count)*_erase_size, _erase_size);
+        if (err) {
+            return err;
+        }
+    }
+
+    return 0;
+}
+
+int StripingBlockDevice::read_async(void *b, bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    return BlockDevice::read_async(b, addr, size, cb);
+}
+
+int StripingBlockDevice::program_async(const void *b, bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    return BlockDevice::program_async(b, addr, size, cb);
+}
+
+int StripingBlockDevice::erase_async(bd_addr_t addr, bd_size_t size, bd_callback_t cb)
+{
+    return BlockDevice::erase_async(addr, size, cb);
+}
@@ -0,0 +1,173 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MBED_STRIPING_BLOCK_DEVICE_H
+#define MBED_STRIPING_BLOCK_DEVICE_H
+
+#include "ChainingBlockDevice.h"
+#include "mbed.h"
+
+
+/** Block device for striping erase blocks across multiple block devices
+ *
+ *  Consecutive erase blocks are interleaved across the block devices, so
+ *  block n is stored on block device n % count. Operations spanning
+ *  several erase blocks are issued to every block device they touch
+ *  before waiting for any of them, so block devices that complete in the
+ *  background, such as AsyncBlockDevice, work in parallel and sequential
+ *  throughput scales with the number of block devices.
+ *
+ *  The size is limited by the smallest block device.
+ *
+ *  @code
+ *  #include "mbed.h"
+ *  #include "HeapBlockDevice.h"
+ *  #include "AsyncBlockDevice.h"
+ *  #include "StripingBlockDevice.h"
+ *
+ *  // Two block devices of 64 blocks of size 512 bytes, each with
+ *  // their own worker thread
+ *  HeapBlockDevice mem1(64*512, 512);
+ *  HeapBlockDevice mem2(64*512, 512);
+ *  AsyncBlockDevice async1(&mem1);
+ *  AsyncBlockDevice async2(&mem2);
+ *
+ *  // Create a block device with 128 blocks of size 512 bytes,
+ *  // even blocks on mem1 and odd blocks on mem2
+ *  BlockDevice *bds[] = {&async1, &async2};
+ *  StripingBlockDevice stripemem(bds);
+ *  @endcode
+ */
+class StripingBlockDevice : public ChainingBlockDevice
+{
+public:
+    /** Lifetime of the memory block device
+     *
+     *  @param bds         Array of block devices to stripe across
+     *  @param bd_count    Number of block devices to stripe across
+     *  @note All block devices must have similar block sizes
+     */
+    StripingBlockDevice(BlockDevice **bds, size_t bd_count);
+
+    /** Lifetime of the memory block device
+     *
+     *  @param bds          Array of block devices to stripe across
+     *  @note All block devices must have similar block sizes
+     */
+    template <size_t Size>
+    StripingBlockDevice(BlockDevice *(&bds)[Size])
+        : ChainingBlockDevice(bds)
+    {
+    }
+
+    /** Lifetime of the memory block device
+     *
+     */
+    virtual ~StripingBlockDevice() {}
+
+    /** Initialize a block device
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int init();
+
+    /** Read blocks from a block device
+     *
+     *  @param buffer   Buffer to write blocks to
+     *  @param addr     Address of block to begin reading from
+     *  @param size     Size to read in bytes, must be a multiple of read block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Program blocks to a block device
+     *
+     *  The blocks must have been erased prior to being programmed
+     *
+     *  @param buffer   Buffer of data to write to blocks
+     *  @param addr     Address of block to begin writing to
+     *  @param size     Size to write in bytes, must be a multiple of program block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Erase blocks on a block device
+     *
+     *  The state of an erased block is undefined until it has been programmed
+     *
+     *  @param addr     Address of block to begin erasing
+     *  @param size     Size to erase in bytes, must be a multiple of erase block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int erase(bd_addr_t addr, bd_size_t size);
+
+    /** Mark blocks as no longer in use
+     *
+     *  @param addr     Address of block to mark as unused
+     *  @param size     Size to mark as unused in bytes, must be a multiple of erase block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int trim(bd_addr_t addr, bd_size_t size);
+
+    /** Start reading blocks from a block device
+     *
+     *  Completes before returning, the read itself is spread across the
+     *  block devices
+     *
+     *  @param buffer   Buffer to write blocks to
+     *  @param addr     Address of block to begin reading from
+     *  @param size     Size to read in bytes, must be a multiple of read block size
+     *  @param cb       Callback called with the result of the read
+     *  @return         0 if the read was started, negative error code on failure
+     */
+    virtual int read_async(void *buffer, bd_addr_t addr, bd_size_t size, bd_callback_t cb);
+
+    /** Start programming blocks to a block device
+     *
+     *  Completes before returning, the program itself is spread across the
+     *  block devices
+     *
+     *  @param buffer   Buffer of data to write to blocks
+     *  @param addr     Address of block to begin writing to
+     *  @param size     Size to write in bytes, must be a multiple of program block size
+     *  @param cb       Callback called with the result of the program
+     *  @return         0 if the program was started, negative error code on failure
+     */
+    virtual int program_async(const void *buffer, bd_addr_t addr, bd_size_t size, bd_callback_t cb);
+
+    /** Start erasing blocks on a block device
+     *
+     *  Completes before returning, the erase itself is spread across the
+     *  block devices
+     *
+     *  @param addr     Address of block to begin erasing
+     *  @param size     Size to erase in bytes, must be a multiple of erase block size
+     *  @param cb       Callback called with the result of the erase
+     *  @return         0 if the erase was started, negative error code on failure
+     */
+    virtual int erase_async(bd_addr_t addr, bd_size_t size, bd_callback_t cb);
+
+protected:
+    int _stripe(int op, uint8_t *buffer, bd_addr_t addr, bd_size_t size);
+};
+
+
+#endif
@@ -0,0 +1,639 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "WearLevelingBlockDevice.h"
+#include "platform/mbed_crc.h"
+
+
+#define WL_BLOCK_MAGIC  0x6b6c6277 // "wblk"
+#define WL_SLOT_MAGIC   0x746c7377 // "wslt"
+#define WL_NONE         0xffffffff
+
+// Written after the erase of each block
+struct wl_block_header {
+    uint32_t magic;
+    uint32_t erases;
+    uint32_t crc;
+};
+
+// Written once the data of a slot has been verified, a slot with a valid
+// header and matching data holds a complete copy of the sector
+struct wl_slot_header {
+    uint32_t magic;
+    uint32_t sector;
+    uint32_t seq;
+    uint32_t data_crc;
+    uint32_t crc;
+};
+
+static uint32_t wl_crc(const void *buffer, size_t size)
+{
+    return mbed_crc32_update(0xffffffff, buffer, size);
+}
+
+WearLevelingBlockDevice::WearLevelingBlockDevice(BlockDevice *bd,
+        bd_size_t sector_size, size_t spare, uint32_t wear_threshold)
+    : _bd(bd), _sector_size(sector_size), _spare(spare), _wear_threshold(wear_threshold)
+    , _header_size(0), _block_size(0), _block_count(0), _slots(0), _sectors(0)
+    , _blocks(0), _map(0), _rev(0), _header(0), _scratch(0), _copy(0)
+    , _seq(0), _free(0), _bad(0)
+    , _queue(0), _gc_free(0), _gc_event(0)
+{
+    MBED_ASSERT(_spare >= 3);
+    _open_block[STREAM_HOT] = WL_NONE;
+    _open_block[STREAM_COLD] = WL_NONE;
+    _next_slot[STREAM_HOT] = 0;
+    _next_slot[STREAM_COLD] = 0;
+}
+
+WearLevelingBlockDevice::~WearLevelingBlockDevice()
+{
+    delete[] _blocks;
+    delete[] _map;
+    delete[] _rev;
+    delete[] _header;
+    delete[] _scratch;
+    delete[] _copy;
+}
+
+int WearLevelingBlockDevice::init()
+{
+    int err = _bd->init();
+    if (err) {
+        return err;
+    }
+
+    _mutex.lock();
+    bd_size_t program = _bd->get_program_size();
+    MBED_ASSERT(_sector_size % program == 0);
+    _header_size = ((sizeof(wl_slot_header) + program - 1) / program) * program;
+    _block_size = _bd->get_erase_size();
+    _block_count = _bd->size() / _block_size;
+    _slots = (_block_size - _header_size) / (_header_size + _sector_size);
+    MBED_ASSERT(_slots > 0 && _block_count > _spare);
+    _sectors = (_block_count - _spare) * _slots;
+
+    delete[] _blocks;
+    delete[] _map;
+    delete[] _rev;
+    delete[] _header;
+    delete[] _scratch;
+    delete[] _copy;
+    _blocks = new block[_block_count];
+    _map = new uint32_t[_sectors];
+    _rev = new uint32_t[_block_count*_slots];
+    _header = new uint8_t[_header_size];
+    _scratch = new uint8_t[_header_size > _sector_size ? _header_size : _sector_size];
+    _copy = new uint8_t[_sector_size];
+    memset(_map, 0xff, _sectors*sizeof(uint32_t));
+    memset(_rev, 0xff, _block_count*_slots*sizeof(uint32_t));
+
+    // Rebuild the mapping from the slot headers, the copy of a sector with
+    // the latest sequence number wins
+    uint32_t *seqs = new uint32_t[_sectors];
+    uint64_t erases = 0;
+    size_t known = 0;
+    bool seen = false;
+    _seq = 0;
+    _free = 0;
+    _bad = 0;
+
+    for (size_t b = 0; b < _block_count; b++) {
+        _blocks[b].valid = 0;
+        _blocks[b].state = BLOCK_FREE;
+        _blocks[b].erases = WL_NONE;
+
+        err = _bd->read(_header, b*_block_size, _header_size);
+        if (err) {
+            goto cleanup;
+        }
+
+        wl_block_header bh;
+        memcpy(&bh, _header, sizeof(bh));
+        if (bh.magic != WL_BLOCK_MAGIC || bh.crc != wl_crc(&bh, 2*sizeof(uint32_t))) {
+            continue;
+        }
+
+        _blocks[b].erases = bh.erases;
+        erases += bh.erases;
+        known += 1;
+
+        for (size_t s = 0; s < _slots; s++) {
+            uint32_t slot = b*_slots + s;
+            err = _bd->read(_header, _slot_addr(slot), _header_size);
+            if (err) {
+                goto cleanup;
+            }
+
+            wl_slot_header sh;
+            memcpy(&sh, _header, sizeof(sh));
+            if (sh.magic != WL_SLOT_MAGIC || sh.crc != wl_crc(&sh, 4*sizeof(uint32_t))) {
+                continue;
+            }
+
+            // Anything written closes the block, it's erased before reuse
+            _blocks[b].state = BLOCK_CLOSED;
+            if (!seen || (int32_t)(sh.seq - _seq) >= 0) {
+                _seq = sh.seq + 1;
+                seen = true;
+            }
+
+            if (sh.sector >= _sectors) {
+                continue;
+            }
+
+            uint32_t old = _map[sh.sector];
+            if (old != WL_NONE && (int32_t)(sh.seq - seqs[sh.sector]) < 0) {
+                continue;
+            }
+
+            // Only data that still matches its header replaces an older copy
+            err = _bd->read(_scratch, _slot_addr(slot) + _header_size, _sector_size);
+            if (err) {
+                goto cleanup;
+            }
+
+            if (sh.data_crc != wl_crc(_scratch, _sector_size)) {
+                continue;
+            }
+
+            if (old != WL_NONE) {
+                _blocks[old / _slots].valid -= 1;
+                _rev[old] = WL_NONE;
+            }
+
+            _map[sh.sector] = slot;
+            _rev[slot] = sh.sector;
+            _blocks[b].valid += 1;
+            seqs[sh.sector] = sh.seq;
+        }
+    }
+
+    // Blocks without a header haven't been used, or were interrupted
+    // between their erase and header, assume average wear
+    for (size_t b = 0; b < _block_count; b++) {
+        if (_blocks[b].erases == WL_NONE) {
+            _blocks[b].erases = known ? erases / known : 0;
+        }
+
+        if (_blocks[b].state == BLOCK_FREE) {
+            _free += 1;
+        }
+    }
+
+    _open_block[STREAM_HOT] = WL_NONE;
+    _open_block[STREAM_COLD] = WL_NONE;
+
+cleanup:
+    delete[] seqs;
+    _mutex.unlock();
+    return err;
+}
+
+int WearLevelingBlockDevice::deinit()
+{
+    _mutex.lock();
+    if (_queue && _gc_event) {
+        _queue->cancel(_gc_event);
+        _gc_event = 0;
+    }
+
+    delete[] _blocks;
+    delete[] _map;
+    delete[] _rev;
+    delete[] _header;
+    delete[] _scratch;
+    delete[] _copy;
+    _blocks = 0;
+    _map = 0;
+    _rev = 0;
+    _header = 0;
+    _scratch = 0;
+    _copy = 0;
+    _mutex.unlock();
+
+    return _bd->deinit();
+}
+
+int WearLevelingBlockDevice::sync()
+{
+    return _bd->sync();
+}
+
+int WearLevelingBlockDevice::read(void *b, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_read(addr, size));
+    uint8_t *buffer = static_cast<uint8_t*>(b);
+
+    _mutex.lock();
+    while (size > 0) {
+        uint32_t slot = _map[addr / _sector_size];
+        if (slot == WL_NONE) {
+            memset(buffer, 0xff, _sector_size);
+        } else {
+            int err = _bd->read(buffer, _slot_addr(slot) + _header_size, _sector_size);
+            if (err) {
+                _mutex.unlock();
+                return err;
+            }
+        }
+
+        buffer += _sector_size;
+        addr += _sector_size;
+        size -= _sector_size;
+    }
+    _mutex.unlock();
+
+    return 0;
+}
+
+int WearLevelingBlockDevice::program(const void *b, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_program(addr, size));
+    const uint8_t *buffer = static_cast<const uint8_t*>(b);
+
+    _mutex.lock();
+    while (size > 0) {
+        int err = _write(STREAM_HOT, addr / _sector_size, buffer);
+        if (err) {
+            _mutex.unlock();
+            return err;
+        }
+
+        buffer += _sector_size;
+        addr += _sector_size;
+        size -= _sector_size;
+    }
+
+    if (_free < _gc_free) {
+        _schedule();
+    }
+    _mutex.unlock();
+
+    return 0;
+}
+
+int WearLevelingBlockDevice::erase(bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_erase(addr, size));
+    return 0;
+}
+
+int WearLevelingBlockDevice::trim(bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_erase(addr, size));
+
+    _mutex.lock();
+    while (size > 0) {
+        uint32_t sector = addr / _sector_size;
+        uint32_t old = _map[sector];
+        if (old != WL_NONE) {
+            _blocks[old / _slots].valid -= 1;
+            _rev[old] = WL_NONE;
+            _map[sector] = WL_NONE;
+        }
+
+        addr += _sector_size;
+        size -= _sector_size;
+    }
+    _mutex.unlock();
+
+    return 0;
+}
+
+bd_size_t WearLevelingBlockDevice::get_read_size() const
+{
+    return _sector_size;
+}
+
+bd_size_t WearLevelingBlockDevice::get_program_size() const
+{
+    return _sector_size;
+}
+
+bd_size_t WearLevelingBlockDevice::get_erase_size() const
+{
+    return _sector_size;
+}
+
+bd_size_t WearLevelingBlockDevice::size() const
+{
+    return (bd_size_t)_sectors * _sector_size;
+}
+
+void WearLevelingBlockDevice::set_gc_queue(events::EventQueue *queue, size_t free)
+{
+    _mutex.lock();
+    if (_queue && _gc_event) {
+        _queue->cancel(_gc_event);
+        _gc_event = 0;
+    }
+
+    _queue = queue;
+    _gc_free = free;
+    _mutex.unlock();
+}
+
+int WearLevelingBlockDevice::gc()
+{
+    _mutex.lock();
+    int b = _victim(false);
+    if (b < 0) {
+        b = _victim(true);
+    }
+
+    int err = (b < 0) ? 1 : _collect(b);
+    _mutex.unlock();
+    return err;
+}
+
+size_t WearLevelingBlockDevice::get_bad_block_count() const
+{
+    return _bad;
+}
+
+bd_addr_t WearLevelingBlockDevice::_slot_addr(uint32_t slot) const
+{
+    return (bd_addr_t)(slot / _slots) * _block_size + _header_size
+            + (bd_addr_t)(slot % _slots) * (_header_size + _sector_size);
+}
+
+int WearLevelingBlockDevice::_write(int stream, uint32_t sector, const uint8_t *data)
+{
+    while (true) {
+        if (_open_block[stream] == WL_NONE) {
+            int err = _open(stream);
+            if (err) {
+                return err;
+            }
+        }
+
+        size_t b = _open_block[stream];
+        uint32_t slot = b*_slots + _next_slot[stream];
+        _next_slot[stream] += 1;
+        if (_next_slot[stream] == _slots) {
+            _blocks[b].state = BLOCK_CLOSED;
+            _open_block[stream] = WL_NONE;
+        }
+
+        wl_slot_header sh = {WL_SLOT_MAGIC, sector, _seq, 0, 0};
+        sh.data_crc = wl_crc(data, _sector_size);
+        sh.crc = wl_crc(&sh, 4*sizeof(uint32_t));
+        memset(_header, 0xff, _header_size);
+        memcpy(_header, &sh, sizeof(sh));
+        _seq += 1;
+
+        // Data goes first and is read back before the header commits the
+        // slot, so a slot that failed or was interrupted never looks newer
+        // than the last good copy. A block that doesn't keep either is
+        // retired
+        bd_addr_t addr = _slot_addr(slot);
+        int err = _bd->program(data, addr + _header_size, _sector_size);
+        if (!err) {
+            err = _bd->read(_scratch, addr + _header_size, _sector_size);
+        }
+        if (!err && memcmp(_scratch, data, _sector_size) != 0) {
+            err = BD_ERROR_DEVICE_ERROR;
+        }
+        if (!err) {
+            err = _bd->program(_header, addr, _header_size);
+        }
+        if (!err) {
+            err = _bd->read(_scratch, addr, _header_size);
+        }
+        if (!err && memcmp(_scratch, _header, _header_size) != 0) {
+            err = BD_ERROR_DEVICE_ERROR;
+        }
+
+        if (err) {
+            _retire(b);
+            continue;
+        }
+
+        uint32_t old = _map[sector];
+        if (old != WL_NONE) {
+            _blocks[old / _slots].valid -= 1;
+            _rev[old] = WL_NONE;
+        }
+
+        _map[sector] = slot;
+        _rev[slot] = sector;
+        _blocks[b].valid += 1;
+        return 0;
+    }
+}
+
+int WearLevelingBlockDevice::_open(int stream)
+{
+    if (stream == STREAM_HOT) {
+        // Keep a free block back so garbage collection can always relocate
+        while (_free <= 1) {
+            int b = _victim(false);
+            if (b < 0) {
+                return BD_ERROR_DEVICE_ERROR;
+            }
+
+            int err = _collect(b);
+            if (err) {
+                return err;
+            }
+        }
+
+        // Without a queue, level wear a block at a time as blocks are opened
+        if (!_queue) {
+            int b = _victim(true);
+            if (b >= 0) {
+                int err = _collect(b);
+                if (err) {
+                    return err;
+                }
+            }
+        }
+    }
+
+    while (true) {
+        // New data goes to the least worn free block, relocated data that
+        // has already proven to be cold goes to the most worn
+        size_t b = WL_NONE;
+        for (size_t i = 0; i < _block_count; i++) {
+            if (_blocks[i].state == BLOCK_FREE && (b == WL_NONE ||
+                    (stream == STREAM_HOT && _blocks[i].erases < _blocks[b].erases) ||
+                    (stream == STREAM_COLD && _blocks[i].erases > _blocks[b].erases))) {
+                b = i;
+            }
+        }
+
+        if (b == WL_NONE) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+
+        _free -= 1;
+        _blocks[b].erases += 1;
+        wl_block_header bh = {WL_BLOCK_MAGIC, _blocks[b].erases, 0};
+        bh.crc = wl_crc(&bh, 2*sizeof(uint32_t));
+        memset(_header, 0xff, _header_size);
+        memcpy(_header, &bh, sizeof(bh));
+
+        int err = _bd->erase(b*_block_size, _block_size);
+        if (!err) {
+            err = _bd->program(_header, b*_block_size, _header_size);
+        }
+        if (!err) {
+            err = _bd->read(_scratch, b*_block_size, _header_size);
+        }
+        if (!err && memcmp(_scratch, _header, _header_size) != 0) {
+            err = BD_ERROR_DEVICE_ERROR;
+        }
+
+        if (err) {
+            _retire(b);
+            continue;
+        }
+
+        _blocks[b].state = BLOCK_OPEN;
+        _blocks[b].valid = 0;
+        _open_block[stream] = b;
+        _next_slot[stream] = 0;
+
+        if (stream == STREAM_HOT) {
+            _schedule();
+        }
+
+        return 0;
+    }
+}
+
+void WearLevelingBlockDevice::_retire(size_t b)
+{
+    // Any data still in the block is relocated by garbage collection
+    _blocks[b].state = BLOCK_BAD;
+    _bad += 1;
+
+    for (int stream = STREAM_HOT; stream <= STREAM_COLD; stream++) {
+        if (_open_block[stream] == b) {
+            _open_block[stream] = WL_NONE;
+        }
+    }
+}
+
+int WearLevelingBlockDevice::_victim(bool level)
+{
+    size_t best = WL_NONE;
+
+    if (!level) {
+        // Empty bad blocks first, then the block with the least valid data
+        for (size_t b = 0; b < _block_count; b++) {
+            if (_blocks[b].state == BLOCK_BAD && _blocks[b].valid > 0) {
+                return b;
+            }
+
+            if (_blocks[b].state == BLOCK_CLOSED && _blocks[b].valid < _slots &&
+                    (best == WL_NONE || _blocks[b].valid < _blocks[best].valid)) {
+                best = b;
+            }
+        }
+
+        return (best == WL_NONE) ? -1 : (int)best;
+    }
+
+    // The least worn block is holding static data if it lags far behind
+    uint32_t max = 0;
+    for (size_t b = 0; b < _block_count; b++) {
+        if (_blocks[b].state != BLOCK_BAD && _blocks[b].erases > max) {
+            max = _blocks[b].erases;
+        }
+
+        if (_blocks[b].state == BLOCK_CLOSED &&
+                (best == WL_NONE || _blocks[b].erases < _blocks[best].erases)) {
+            best = b;
+        }
+    }
+
+    if (best == WL_NONE || max - _blocks[best].erases <= _wear_threshold) {
+        return -1;
+    }
+
+    return best;
+}
+
+int WearLevelingBlockDevice::_collect(size_t b)
+{
+    for (size_t s = 0; s < _slots; s++) {
+        uint32_t slot = b*_slots + s;
+        uint32_t sector = _rev[slot];
+        if (sector == WL_NONE) {
+            continue;
+        }
+
+        int err = _bd->read(_copy, _slot_addr(slot) + _header_size, _sector_size);
+        if (err) {
+            return err;
+        }
+
+        err = _write(STREAM_COLD, sector, _copy);
+        if (err) {
+            return err;
+        }
+    }
+
+    if (_blocks[b].state != BLOCK_BAD) {
+        _blocks[b].state = BLOCK_FREE;
+        _free += 1;
+    }
+
+    return 0;
+}
+
+void WearLevelingBlockDevice::_schedule()
+{
+    if (_queue && !_gc_event) {
+        _gc_event = _queue->call(this, &WearLevelingBlockDevice::_background);
+    }
+}
+
+void WearLevelingBlockDevice::_background()
+{
+    _mutex.lock();
+    _gc_event = 0;
+    if (!_blocks) {
+        _mutex.unlock();
+        return;
+    }
+
+    // Only collect for space when it's worth it, mostly full blocks are
+    // left for writes that actually run out
+    int b = -1;
+    if (_free < _gc_free) {
+        b = _victim(false);
+        if (b >= 0 && _blocks[b].state != BLOCK_BAD && _blocks[b].valid > _slots/2) {
+            b = -1;
+        }
+    }
+
+    // Collecting for space continues until enough blocks are free, wear
+    // leveling is paced at one block each time a block is opened
+    if (b >= 0) {
+        if (_collect(b) == 0) {
+            _schedule();
+        }
+    } else {
+        b = _victim(true);
+        if (b >= 0) {
+            _collect(b);
+        }
+    }
+    _mutex.unlock();
+}
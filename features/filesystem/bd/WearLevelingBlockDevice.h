@@ -0,0 +1,255 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MBED_WEAR_LEVELING_BLOCK_DEVICE_H
+#define MBED_WEAR_LEVELING_BLOCK_DEVICE_H
+
+#include "BlockDevice.h"
+#include "mbed.h"
+
+
+/** Block device for spreading wear over the erase blocks of a flash device
+ *
+ *  A log-structured flash translation layer that presents small logical
+ *  sectors, which can be programmed without erasing, on top of a block
+ *  device with large erase blocks. Every program of a sector is written
+ *  to a fresh slot in an open erase block along with a header recording
+ *  the sector, a sequence number and a CRC of the data, and the previous
+ *  copy is left for garbage collection.
+ *
+ *  - Sectors written by the user and sectors relocated by garbage
+ *    collection go to separate erase blocks, so rarely changing data
+ *    collects in blocks that rarely need collecting.
+ *  - Free blocks with the fewest erases take new writes, and blocks
+ *    holding data that never changes are collected once their erase
+ *    count lags too far behind, so those blocks get worn too.
+ *  - Programs are read back, blocks that fail are retired and the
+ *    write is retried in another block.
+ *  - The header is only programmed once the data has been read back,
+ *    and the mapping is rebuilt in init from the slots whose data still
+ *    matches their header, so a failed write or one interrupted by power
+ *    loss leaves the previous copy of the sector.
+ *
+ *  Garbage collection runs when writes run out of free blocks, or ahead
+ *  of time on an EventQueue. Trimmed sectors read as 0xff, but may come
+ *  back with older contents after init.
+ *
+ *  @code
+ *  #include "mbed.h"
+ *  #include "HeapBlockDevice.h"
+ *  #include "WearLevelingBlockDevice.h"
+ *
+ *  // Create a block device with 64 erase blocks of size 4096 and programs of 16 bytes
+ *  HeapBlockDevice mem(64*4096, 16, 16, 4096);
+ *
+ *  // Present 512 byte sectors, keeping 4 erase blocks spare
+ *  WearLevelingBlockDevice ftl(&mem, 512, 4);
+ *  @endcode
+ */
+class WearLevelingBlockDevice : public BlockDevice
+{
+public:
+    /** Lifetime of the wear leveling block device
+     *
+     *  @param bd               Block device to back the WearLevelingBlockDevice
+     *  @param sector_size      Size of the logical sectors, must be a multiple of
+     *                          the program size of the underlying block device
+     *  @param spare            Number of erase blocks held back for garbage
+     *                          collection and replacing bad blocks, at least 3
+     *  @param wear_threshold   Difference in erase counts at which blocks holding
+     *                          static data are collected
+     */
+    WearLevelingBlockDevice(BlockDevice *bd, bd_size_t sector_size = 512,
+            size_t spare = 4, uint32_t wear_threshold = 16);
+
+    /** Lifetime of a block device
+     */
+    virtual ~WearLevelingBlockDevice();
+
+    /** Initialize a block device
+     *
+     *  Rebuilds the mapping of logical sectors from the underlying block device
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int init();
+
+    /** Deinitialize a block device
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int deinit();
+
+    /** Ensure data on storage is in sync with the driver
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int sync();
+
+    /** Read blocks from a block device
+     *
+     *  @param buffer   Buffer to read blocks into
+     *  @param addr     Address of block to begin reading from
+     *  @param size     Size to read in bytes, must be a multiple of read block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Program blocks to a block device
+     *
+     *  Sectors don't need to be erased before being programmed
+     *
+     *  @param buffer   Buffer of data to write to blocks
+     *  @param addr     Address of block to begin writing to
+     *  @param size     Size to write in bytes, must be a multiple of program block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Erase blocks on a block device
+     *
+     *  Does nothing, programs always go to erased storage
+     *
+     *  @param addr     Address of block to begin erasing
+     *  @param size     Size to erase in bytes, must be a multiple of erase block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int erase(bd_addr_t addr, bd_size_t size);
+
+    /** Mark blocks as no longer in use
+     *
+     *  Trimmed sectors are dropped by garbage collection instead of being relocated
+     *
+     *  @param addr     Address of block to mark as unused
+     *  @param size     Size to mark as unused in bytes, must be a multiple of erase block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int trim(bd_addr_t addr, bd_size_t size);
+
+    /** Get the size of a readable block
+     *
+     *  @return         Size of a readable block in bytes
+     */
+    virtual bd_size_t get_read_size() const;
+
+    /** Get the size of a programable block
+     *
+     *  @return         Size of a programable block in bytes
+     */
+    virtual bd_size_t get_program_size() const;
+
+    /** Get the size of a eraseable block
+     *
+     *  @return         Size of a eraseable block in bytes, the sector size
+     */
+    virtual bd_size_t get_erase_size() const;
+
+    /** Get the total size of the underlying device
+     *
+     *  @return         Size of the logical sectors in bytes
+     */
+    virtual bd_size_t size() const;
+
+    /** Run garbage collection in the background
+     *
+     *  Collection is scheduled on the queue whenever fewer than the given
+     *  number of erase blocks are free, or a new erase block is opened for
+     *  writing, and runs one erase block per event.
+     *
+     *  @param queue    Event queue to run garbage collection on, or NULL to
+     *                  only collect when writes need space
+     *  @param free     Number of free erase blocks to keep available
+     */
+    void set_gc_queue(events::EventQueue *queue, size_t free = 4);
+
+    /** Run garbage collection on one erase block
+     *
+     *  @return         0 if a block was collected, 1 if there was nothing
+     *                  worth collecting, negative error code on failure
+     */
+    int gc();
+
+    /** Get the number of erase blocks retired after failing
+     *
+     *  @return         Number of bad erase blocks
+     */
+    size_t get_bad_block_count() const;
+
+protected:
+    enum {
+        BLOCK_FREE,
+        BLOCK_OPEN,
+        BLOCK_CLOSED,
+        BLOCK_BAD,
+    };
+
+    enum {
+        STREAM_HOT,
+        STREAM_COLD,
+    };
+
+    struct block {
+        uint32_t erases;
+        uint16_t valid;
+        uint8_t state;
+    };
+
+    bd_addr_t _slot_addr(uint32_t slot) const;
+    int _write(int stream, uint32_t sector, const uint8_t *data);
+    int _open(int stream);
+    void _retire(size_t b);
+    int _victim(bool level);
+    int _collect(size_t b);
+    void _schedule();
+    void _background();
+
+    BlockDevice *_bd;
+    bd_size_t _sector_size;
+    size_t _spare;
+    uint32_t _wear_threshold;
+
+    bd_size_t _header_size;
+    bd_size_t _block_size;
+    size_t _block_count;
+    size_t _slots;
+    uint32_t _sectors;
+
+    block *_blocks;
+    uint32_t *_map;
+    uint32_t *_rev;
+    uint8_t *_header;
+    uint8_t *_scratch;
+    uint8_t *_copy;
+
+    uint32_t _seq;
+    size_t _free;
+    size_t _bad;
+    size_t _open_block[2];
+    size_t _next_slot[2];
+
+    events::EventQueue *_queue;
+    size_t _gc_free;
+    int _gc_event;
+    PlatformMutex _mutex;
+};
+
+
+#endif
@@ -0,0 +1,188 @@
+/*
+ * Host tests for the file and mmap backed block devices
+ *
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "FileBlockDevice.h"
+#include "MmapBlockDevice.h"
+#include <unistd.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+
+// Testing setup
+static jmp_buf test_buf;
+static int test_line;
+static int test_failure;
+
+#define test_assert(test) do {                                              \
+    if (!(test)) {                                                          \
+        test_line = __LINE__;                                               \
+        longjmp(test_buf, 1);                                               \
+    }                                                                       \
+} while (0)
+
+#define test_run(func) do {                                                 \
+    printf("%s: ...", #func);                                               \
+    fflush(stdout);                                                         \
+                                                                            \
+    if (!setjmp(test_buf)) {                                                \
+        func();                                                             \
+        printf("\r%s: \e[32mpassed\e[0m\n", #func);                         \
+    } else {                                                                \
+        printf("\r%s: \e[31mfailed\e[0m at line %d\n", #func, test_line);   \
+        test_failure = true;                                                \
+    }                                                                       \
+} while (0)
+
+// Asserts fail the current test instead of halting
+extern "C" void mbed_assert_internal(const char *expr, const char *file, int line) {
+    printf("\nassert %s at %s:%d", expr, file, line);
+    test_line = line;
+    longjmp(test_buf, 1);
+}
+
+
+// Test parameters
+#define TEST_IMAGE      "tests/test.img"
+#define READ_SIZE       16
+#define PROGRAM_SIZE    64
+#define ERASE_SIZE      4096
+#define ERASE_COUNT     32
+
+
+// Test functions
+static void fill(uint8_t *buffer, bd_size_t size, unsigned seed) {
+    srand(seed);
+    for (bd_size_t i = 0; i < size; i++) {
+        buffer[i] = rand();
+    }
+}
+
+// Runs a block device through its lifetime, checking the data
+// survives a deinit and init of a new block device on the same image
+template <typename A, typename B>
+void lifetime_test() {
+    unlink(TEST_IMAGE);
+    uint8_t *write_block = new uint8_t[ERASE_SIZE];
+    uint8_t *read_block = new uint8_t[ERASE_SIZE];
+
+    {
+        A bd(TEST_IMAGE, ERASE_COUNT*ERASE_SIZE, READ_SIZE, PROGRAM_SIZE, ERASE_SIZE);
+        test_assert(bd.init() == 0);
+        test_assert(bd.get_read_size() == READ_SIZE);
+        test_assert(bd.get_program_size() == PROGRAM_SIZE);
+        test_assert(bd.get_erase_size() == ERASE_SIZE);
+        test_assert(bd.size() == ERASE_COUNT*ERASE_SIZE);
+
+        // The image is grown to the device size
+        struct stat st;
+        test_assert(stat(TEST_IMAGE, &st) == 0);
+        test_assert(st.st_size == ERASE_COUNT*ERASE_SIZE);
+
+        for (int i = 0; i < ERASE_COUNT; i++) {
+            fill(write_block, ERASE_SIZE, i);
+            test_assert(bd.erase(i*ERASE_SIZE, ERASE_SIZE) == 0);
+            test_assert(bd.program(write_block, i*ERASE_SIZE, ERASE_SIZE) == 0);
+        }
+
+        // Smallest reads and programs, at the end of the device
+        bd_addr_t last = (ERASE_COUNT-1)*ERASE_SIZE;
+        memset(write_block, 0x5a, PROGRAM_SIZE);
+        test_assert(bd.program(write_block, last + PROGRAM_SIZE, PROGRAM_SIZE) == 0);
+        test_assert(bd.read(read_block, last + PROGRAM_SIZE + READ_SIZE, READ_SIZE) == 0);
+        test_assert(memcmp(read_block, write_block, READ_SIZE) == 0);
+
+        test_assert(bd.sync() == 0);
+        test_assert(bd.deinit() == 0);
+    }
+
+    {
+        B bd(TEST_IMAGE, ERASE_COUNT*ERASE_SIZE, READ_SIZE, PROGRAM_SIZE, ERASE_SIZE);
+        test_assert(bd.init() == 0);
+        for (int i = 0; i < ERASE_COUNT; i++) {
+            fill(write_block, ERASE_SIZE, i);
+            if (i == ERASE_COUNT-1) {
+                memset(&write_block[PROGRAM_SIZE], 0x5a, PROGRAM_SIZE);
+            }
+
+            test_assert(bd.read(read_block, i*ERASE_SIZE, ERASE_SIZE) == 0);
+            test_assert(memcmp(read_block, write_block, ERASE_SIZE) == 0);
+        }
+
+        // init and deinit are idempotent
+        test_assert(bd.init() == 0);
+        test_assert(bd.deinit() == 0);
+        test_assert(bd.deinit() == 0);
+    }
+
+    delete[] write_block;
+    delete[] read_block;
+    unlink(TEST_IMAGE);
+}
+
+void latency_test() {
+    unlink(TEST_IMAGE);
+    uint8_t block[ERASE_SIZE] = {0};
+
+    FileBlockDevice bd(TEST_IMAGE, ERASE_COUNT*ERASE_SIZE, READ_SIZE, PROGRAM_SIZE, ERASE_SIZE);
+    test_assert(bd.init() == 0);
+    test_assert(bd.read(block, 0, ERASE_SIZE) == 0);
+    test_assert(bd.get_time() == 0);
+
+    // A fixed cost per operation and a cost per block
+    FileBlockDevice::latency model = {10, 1, 2, 100};
+    bd.set_latency(model);
+    test_assert(bd.read(block, 0, ERASE_SIZE) == 0);
+    test_assert(bd.get_time() == 10 + 1*(ERASE_SIZE/READ_SIZE));
+    test_assert(bd.program(block, 0, ERASE_SIZE) == 0);
+    test_assert(bd.get_time() == 20 + 1*(ERASE_SIZE/READ_SIZE)
+            + 2*(ERASE_SIZE/PROGRAM_SIZE));
+    test_assert(bd.erase(0, 2*ERASE_SIZE) == 0);
+    test_assert(bd.get_time() == 30 + 1*(ERASE_SIZE/READ_SIZE)
+            + 2*(ERASE_SIZE/PROGRAM_SIZE) + 100*2);
+
+    test_assert(bd.deinit() == 0);
+    unlink(TEST_IMAGE);
+}
+
+void missing_directory_test() {
+    FileBlockDevice bd("tests/missing/test.img", ERASE_COUNT*ERASE_SIZE,
+            READ_SIZE, PROGRAM_SIZE, ERASE_SIZE);
+    test_assert(bd.init() == BD_ERROR_DEVICE_ERROR);
+
+    MmapBlockDevice mbd("tests/missing/test.img", ERASE_COUNT*ERASE_SIZE,
+            READ_SIZE, PROGRAM_SIZE, ERASE_SIZE);
+    test_assert(mbd.init() == BD_ERROR_DEVICE_ERROR);
+}
+
+
+int main() {
+    printf("beginning tests...\n");
+
+    test_run((lifetime_test<FileBlockDevice, FileBlockDevice>));
+    test_run((lifetime_test<MmapBlockDevice, MmapBlockDevice>));
+    test_run((lifetime_test<FileBlockDevice, MmapBlockDevice>));
+    test_run((lifetime_test<MmapBlockDevice, FileBlockDevice>));
+    test_run(latency_test);
+    test_run(missing_directory_test);
+
+    printf("done!\n");
+    return test_failure;
+}
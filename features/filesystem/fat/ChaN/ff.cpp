@@ -1634,6 +1634,48 @@ DWORD clmt_clust (	/* <2:Error, >=2:Cluster number */
 
 
 
+#if FF_FS_BURST
+/*-----------------------------------------------------------------------*/
+/* File handling - Extend a direct transfer over contiguous clusters     */
+/*-----------------------------------------------------------------------*/
+
+static
+UINT burst_extend (	/* Number of sectors that can be transferred at once */
+	FIL* fp,		/* Pointer to the file object, fp->clust is updated */
+	UINT cc,		/* Number of sectors to the end of the current cluster */
+	UINT nc,		/* Number of whole sectors requested */
+	int grow		/* Stretch the cluster chain if needed (write) */
+)
+{
+	DWORD clst;
+	FATFS *fs = fp->obj.fs;
+
+
+	while (cc < nc) {
+#if FF_USE_FASTSEEK
+		if (fp->cltbl) {
+			clst = clmt_clust(fp, fp->fptr + (FSIZE_t)cc * SS(fs));	/* Get cluster# from the CLMT */
+		} else
+#endif
+#if !FF_FS_READONLY
+		if (grow) {
+			clst = create_chain(&fp->obj, fp->clust);	/* Follow or stretch cluster chain on the FAT */
+		} else
+#endif
+		{
+			clst = get_fat(&fp->obj, fp->clust);	/* Follow cluster chain on the FAT */
+		}
+		if (clst != fp->clust + 1) break;	/* Not contiguous, errors are left to the next cluster boundary */
+		fp->clust = clst;
+		cc += (nc - cc < fs->csize) ? nc - cc : fs->csize;
+	}
+	return cc;
+}
+
+#endif	/* FF_FS_BURST */
+
+
+
 
 /*-----------------------------------------------------------------------*/
 /* Directory handling - Fill a cluster with zeros                        */
@@ -3796,7 +3838,11 @@ FRESULT f_read (
 			cc = btr / SS(fs);					/* When remaining bytes >= sector size, */
 			if (cc > 0) {						/* Read maximum contiguous sectors directly */
 				if (csect + cc > fs->csize) {	/* Clip at cluster boundary */
+#if FF_FS_BURST
+					cc = burst_extend(fp, fs->csize - csect, cc, 0);	/* Extend over contiguous clusters */
+#else
 					cc = fs->csize - csect;
+#endif
 				}
 				if (disk_read(fs->pdrv, rbuff, sect, cc) != RES_OK) ABORT(fs, FR_DISK_ERR);
 #if !FF_FS_READONLY && FF_FS_MINIMIZE <= 2		/* Replace one of the read sectors with cached data if it contains a dirty sector */
@@ -3917,7 +3963,16 @@ FRESULT f_write (
 			cc = btw / SS(fs);				/* When remaining bytes >= sector size, */
 			if (cc > 0) {					/* Write maximum contiguous sectors directly */
 				if (csect + cc > fs->csize) {	/* Clip at cluster boundary */
+#if FF_FS_BURST
+					cc = burst_extend(fp, fs->csize - csect, cc, 1);	/* Extend over contiguous clusters */
+#if FLUSH_ON_NEW_CLUSTER
+					if (csect + cc > fs->csize) {
+						need_sync = true;
+					}
+#endif
+#else
 					cc = fs->csize - csect;
+#endif
 				}
 				if (disk_write(fs->pdrv, wbuff, sect, cc) != RES_OK) ABORT(fs, FR_DISK_ERR);
 #if FF_FS_MINIMIZE <= 2
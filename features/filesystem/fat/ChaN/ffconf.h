@@ -44,11 +44,11 @@
 /* This option switches f_mkfs() function. (0:Disable or 1:Enable) */
 
 
-#define FF_USE_FASTSEEK	0
+#define FF_USE_FASTSEEK	1
 /* This option switches fast seek function. (0:Disable or 1:Enable) */
 
 
-#define FF_USE_EXPAND	0
+#define FF_USE_EXPAND	1
 /* This option switches f_expand function. (0:Disable or 1:Enable) */
 
 
@@ -266,9 +266,9 @@
 /      lock control is independent of re-entrancy. */
 
 
-#define FF_FS_REENTRANT	0
+#define FF_FS_REENTRANT	1
 #define FF_FS_TIMEOUT	1000
-#define FF_SYNC_t		HANDLE
+#define FF_SYNC_t		void*
 /* The option FF_FS_REENTRANT switches the re-entrancy (thread safe) of the FatFs
 /  module itself. Note that regardless of this option, file access to different
 /  volume is always re-entrant and volume control functions, f_mount(), f_mkfs()
@@ -288,6 +288,13 @@
 
 /* #include <windows.h>	// O/S definitions  */
 
+#define FF_FS_BURST     1
+/* This option switches multi-cluster direct transfers. (0:Disable or 1:Enable)
+/  When enabled, aligned f_read() and f_write() transfers spanning physically
+/  contiguous clusters are issued as a single disk_read() or disk_write()
+/  instead of being split at every cluster boundary. */
+
+
 #define FLUSH_ON_NEW_CLUSTER    0   /* Sync the file on every new cluster */
 #define FLUSH_ON_NEW_SECTOR     1   /* Sync the file on every new sector */
 /* Only one of these two defines needs to be set to 1. If both are set to 0
@@ -132,6 +132,12 @@ static Deferred<const char*> fat_path_prefix(int id, const char *path)
 
 // Global access to block device from FAT driver
 static BlockDevice *_ffs[FF_VOLUMES] = {0};
+
+// Per-volume locks, each volume is locked by the mutex of its filesystem
+static PlatformMutex *_ffs_locks[FF_VOLUMES] = {0};
+
+// Protects the volume table and ChaN's volume control functions,
+// f_mount and f_mkfs, which are not re-entrant across volumes
 static SingletonPtr<PlatformMutex> _ffs_mutex;
 
 
@@ -159,6 +165,31 @@ void ff_memfree(void *p)
     free(p);
 }
 
+// Re-entrancy hooks, ChaN locks the same recursive mutex that
+// FATFileSystem uses, so independent volumes never wait on each other
+int ff_cre_syncobj(BYTE vol, FF_SYNC_t *sobj)
+{
+    *sobj = _ffs_locks[vol];
+    return *sobj != NULL;
+}
+
+int ff_req_grant(FF_SYNC_t sobj)
+{
+    static_cast<PlatformMutex*>(sobj)->lock();
+    return 1;
+}
+
+void ff_rel_grant(FF_SYNC_t sobj)
+{
+    static_cast<PlatformMutex*>(sobj)->unlock();
+}
+
+int ff_del_syncobj(FF_SYNC_t sobj)
+{
+    // Owned by the FATFileSystem
+    return 1;
+}
+
 // Implementation of diskio functions (see ChaN/diskio.h)
 static WORD disk_get_sector_size(BYTE pdrv)
 {
@@ -224,6 +255,8 @@ DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
         case CTRL_SYNC:
             if (_ffs[pdrv] == NULL) {
                 return RES_NOTRDY;
+            } else if (_ffs[pdrv]->sync()) {
+                return RES_PARERR;
             } else {
                 return RES_OK;
             }
@@ -259,6 +292,40 @@ DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
 }
 
 
+////// Fast seek //////
+
+// Cluster link map tables let ChaN seek without following the cluster
+// chain, they are built on the first seek into a file spanning multiple
+// clusters. In fast seek mode ChaN can't grow a file, so the table is
+// dropped before any write or seek past the end of the file.
+static void fat_clmt_drop(FIL *fh)
+{
+    delete[] fh->cltbl;
+    fh->cltbl = NULL;
+}
+
+static void fat_clmt_build(FIL *fh)
+{
+#if MBED_CONF_FILESYSTEM_FAT_FASTSEEK
+    FATFS *fs = fh->obj.fs;
+    if (fh->cltbl || f_size(fh) <= (FSIZE_t)fs->csize * fs->ssize) {
+        return;
+    }
+
+    // Table holds its size, then a length and start for each fragment
+    DWORD size = 2 + 2*MBED_CONF_FILESYSTEM_FAT_FASTSEEK;
+    fh->cltbl = new DWORD[size];
+    fh->cltbl[0] = size;
+
+    FRESULT res = f_lseek(fh, CREATE_LINKMAP);
+    if (res != FR_OK) {
+        // Too fragmented, fall back to following the chain
+        fat_clmt_drop(fh);
+    }
+#endif
+}
+
+
 ////// Generic filesystem operations //////
 
 // Filesystem implementation (See FATFilySystem.h)
@@ -287,20 +354,24 @@ int FATFileSystem::mount(BlockDevice *bd, bool mount) {
         return -EINVAL;
     }
 
+    _ffs_mutex->lock();
     for (int i = 0; i < FF_VOLUMES; i++) {
         if (!_ffs[i]) {
             _id = i;
             _ffs[_id] = bd;
+            _ffs_locks[_id] = &_mutex;
             _fsid[0] = '0' + _id;
             _fsid[1] = ':';
             _fsid[2] = '\0';
             debug_if(FFS_DBG, "Mounting [%s] on ffs drive [%s]\n", getName(), _fsid);
             FRESULT res = f_mount(&_fs, _fsid, mount);
+            _ffs_mutex->unlock();
             unlock();
             return fat_error_remap(res);
         }
     }
 
+    _ffs_mutex->unlock();
     unlock();
     return -ENOMEM;
 }
@@ -313,9 +384,12 @@ int FATFileSystem::unmount()
         return -EINVAL;
     }
 
+    _ffs_mutex->lock();
     FRESULT res = f_mount(NULL, _fsid, 0);
     _ffs[_id] = NULL;
+    _ffs_locks[_id] = NULL;
     _id = -1;
+    _ffs_mutex->unlock();
     unlock();
     return fat_error_remap(res);
 }
@@ -331,7 +405,9 @@ int FATFileSystem::format(BlockDevice *bd, bd_size_t cluster_size) {
 
     // Logical drive number, Partitioning rule, Allocation unit size (bytes per cluster)
     fs.lock();
+    _ffs_mutex->lock();
     FRESULT res = f_mkfs(fs._fsid, FM_ANY, cluster_size, NULL, 0);
+    _ffs_mutex->unlock();
     fs.unlock();
     if (res != FR_OK) {
         return fat_error_remap(res);
@@ -443,11 +519,11 @@ int FATFileSystem::stat(const char *path, struct stat *st) {
 }
 
 void FATFileSystem::lock() {
-    _ffs_mutex->lock();
+    _mutex.lock();
 }
 
 void FATFileSystem::unlock() {
-    _ffs_mutex->unlock();
+    _mutex.unlock();
 }
 
 
@@ -503,6 +579,7 @@ int FATFileSystem::file_close(fs_file_t file) {
     FRESULT res = f_close(fh);
     unlock();
 
+    fat_clmt_drop(fh);
     delete fh;
     return fat_error_remap(res);
 }
@@ -527,6 +604,10 @@ ssize_t FATFileSystem::file_write(fs_file_t file, const void *buffer, size_t len
     FIL *fh = static_cast<FIL*>(file);
 
     lock();
+    if (fh->cltbl && f_tell(fh) + len > f_size(fh)) {
+        fat_clmt_drop(fh);
+    }
+
     UINT n;
     FRESULT res = f_write(fh, buffer, len, &n);
     unlock();
@@ -562,6 +643,14 @@ off_t FATFileSystem::file_seek(fs_file_t file, off_t offset, int whence) {
         offset += f_tell(fh);
     }
 
+    // Seeking to the end is usually followed by appending, which would
+    // just drop the table again
+    if ((FSIZE_t)offset > f_size(fh)) {
+        fat_clmt_drop(fh);
+    } else if ((FSIZE_t)offset < f_size(fh)) {
+        fat_clmt_build(fh);
+    }
+
     FRESULT res = f_lseek(fh, offset);
     off_t noffset = fh->fptr;
     unlock();
@@ -594,6 +683,19 @@ off_t FATFileSystem::file_size(fs_file_t file) {
     return res;
 }
 
+int FATFileSystem::file_preallocate(fs_file_t file, off_t size) {
+    FIL *fh = static_cast<FIL*>(file);
+
+    lock();
+    FRESULT res = f_expand(fh, size, 1);
+    unlock();
+
+    if (res != FR_OK) {
+        debug_if(FFS_DBG, "f_expand() failed: %d\n", res);
+    }
+    return fat_error_remap(res);
+}
+
 
 ////// Dir operations //////
 int FATFileSystem::dir_open(fs_dir_t *dir, const char *path) {
@@ -208,6 +208,14 @@ protected:
      */
     virtual off_t file_size(fs_file_t file);
 
+    /** Allocate contiguous clusters for an empty file
+     *
+     *  @param file     File handle
+     *  @param size     Size to allocate in bytes
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int file_preallocate(fs_file_t file, off_t size);
+
     /** Open a directory on the filesystem
      *
      *  @param dir      Destination for the handle to the directory
@@ -256,6 +264,7 @@ private:
     FATFS _fs; // Work area (file system object) for logical drive
     char _fsid[sizeof("0:")];
     int _id;
+    PlatformMutex _mutex; // Locks this volume, shared with ChaN's sync hooks
 
 protected:
     virtual void lock();
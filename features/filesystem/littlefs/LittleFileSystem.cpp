@@ -102,7 +102,8 @@ static int lfs_bd_erase(const struct lfs_config *c, lfs_block_t block)
 
 static int lfs_bd_sync(const struct lfs_config *c)
 {
-    return 0;
+    BlockDevice *bd = (BlockDevice *)c->context;
+    return bd->sync();
 }
 
 
@@ -162,6 +163,9 @@ int LittleFileSystem::mount(BlockDevice *bd)
     if (_config.lookahead > _lookahead) {
         _config.lookahead = _lookahead;
     }
+    _config.lookup = MBED_LFS_LOOKUP;
+    _config.read_cache = MBED_LFS_READ_CACHE;
+    _config.seek_index = MBED_LFS_SEEK_INDEX;
 
     err = lfs_mount(&_lfs, &_config);
     LFS_INFO("mount -> %d", lfs_toerror(err));
@@ -337,6 +341,23 @@ int LittleFileSystem::stat(const char *name, struct stat *st)
 }
 
 
+uint32_t LittleFileSystem::get_cache_hits()
+{
+    _mutex.lock();
+    uint32_t hits = _lfs.stats.read_hits;
+    _mutex.unlock();
+    return hits;
+}
+
+uint32_t LittleFileSystem::get_cache_misses()
+{
+    _mutex.lock();
+    uint32_t misses = _lfs.stats.read_misses;
+    _mutex.unlock();
+    return misses;
+}
+
+
 ////// File operations //////
 int LittleFileSystem::file_open(fs_file_t *file, const char *path, int flags)
 {
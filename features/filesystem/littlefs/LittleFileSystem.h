@@ -49,7 +49,10 @@ public:
      *      Number of blocks to lookahead during block allocation. A larger
      *      lookahead reduces the number of passes required to allocate a block.
      *      The lookahead buffer requires only 1 bit per block so it can be quite
-     *      large with little ram impact. Should be a multiple of 32.
+     *      large with little ram impact. Should be a multiple of 32. If the
+     *      lookahead covers the entire block device, it is kept as a bitmap
+     *      of blocks in use and the filesystem is only scanned once after
+     *      mounting.
      */
     LittleFileSystem(const char *name=NULL, BlockDevice *bd=NULL,
             lfs_size_t read_size=MBED_LFS_READ_SIZE,
@@ -79,7 +82,10 @@ public:
      *      Number of blocks to lookahead during block allocation. A larger
      *      lookahead reduces the number of passes required to allocate a block.
      *      The lookahead buffer requires only 1 bit per block so it can be quite
-     *      large with little ram impact. Should be a multiple of 32.
+     *      large with little ram impact. Should be a multiple of 32. If the
+     *      lookahead covers the entire block device, it is kept as a bitmap
+     *      of blocks in use and the filesystem is only scanned once after
+     *      mounting.
      */
     static int format(BlockDevice *bd,
         lfs_size_t read_size=MBED_LFS_READ_SIZE,
@@ -143,6 +149,18 @@ public:
      */
     virtual int mkdir(const char *path, mode_t mode);
 
+    /** Number of reads served from the read cache since mounting
+     *
+     *  @return         Number of cache hits
+     */
+    uint32_t get_cache_hits();
+
+    /** Number of reads that had to go to the block device since mounting
+     *
+     *  @return         Number of cache misses
+     */
+    uint32_t get_cache_misses();
+
 protected:
     /** Open a file on the filesystem
      *
@@ -24,6 +24,48 @@
 
 
 /// Caching block device operations ///
+static lfs_cache_t *lfs_cache_find(lfs_t *lfs,
+        lfs_block_t block, lfs_off_t off) {
+    if (!lfs->lines) {
+        return NULL;
+    }
+
+    for (lfs_size_t i = 0; i < lfs->cfg->read_cache; i++) {
+        lfs_cache_t *line = &lfs->lines[i];
+        if (block == line->block && off >= line->off &&
+                off < line->off + lfs->cfg->read_size) {
+            // move to front, lines are kept in lru order
+            lfs_cache_t t = *line;
+            memmove(&lfs->lines[1], &lfs->lines[0], i*sizeof(lfs_cache_t));
+            lfs->lines[0] = t;
+            return &lfs->lines[0];
+        }
+    }
+
+    return NULL;
+}
+
+static lfs_cache_t *lfs_cache_evict(lfs_t *lfs) {
+    // reuse least recently used line
+    lfs_size_t i = lfs->cfg->read_cache-1;
+    lfs_cache_t t = lfs->lines[i];
+    memmove(&lfs->lines[1], &lfs->lines[0], i*sizeof(lfs_cache_t));
+    lfs->lines[0] = t;
+    return &lfs->lines[0];
+}
+
+static void lfs_cache_drop(lfs_t *lfs, lfs_block_t block) {
+    if (!lfs->lines) {
+        return;
+    }
+
+    for (lfs_size_t i = 0; i < lfs->cfg->read_cache; i++) {
+        if (lfs->lines[i].block == block) {
+            lfs->lines[i].block = 0xffffffff;
+        }
+    }
+}
+
 static int lfs_cache_read(lfs_t *lfs, lfs_cache_t *rcache,
         const lfs_cache_t *pcache, lfs_block_t block,
         lfs_off_t off, void *buffer, lfs_size_t size) {
@@ -50,6 +92,7 @@ static int lfs_cache_read(lfs_t *lfs, lfs_cache_t *rcache,
             lfs_size_t diff = lfs_min(size,
                     lfs->cfg->read_size - (off-rcache->off));
             memcpy(data, &rcache->buffer[off-rcache->off], diff);
+            lfs->stats.read_hits += 1;
 
             data += diff;
             off += diff;
@@ -57,6 +100,22 @@ static int lfs_cache_read(lfs_t *lfs, lfs_cache_t *rcache,
             continue;
         }
 
+        const lfs_cache_t *line = lfs_cache_find(lfs, block, off);
+        if (line) {
+            // is already in shared read cache?
+            lfs_size_t diff = lfs_min(size,
+                    lfs->cfg->read_size - (off-line->off));
+            memcpy(data, &line->buffer[off-line->off], diff);
+            lfs->stats.read_hits += 1;
+
+            data += diff;
+            off += diff;
+            size -= diff;
+            continue;
+        }
+
+        lfs->stats.read_misses += 1;
+
         if (off % lfs->cfg->read_size == 0 && size >= lfs->cfg->read_size) {
             // bypass cache?
             lfs_size_t diff = size - (size % lfs->cfg->read_size);
@@ -71,6 +130,28 @@ static int lfs_cache_read(lfs_t *lfs, lfs_cache_t *rcache,
             continue;
         }
 
+        if (lfs->lines) {
+            // load to shared read cache instead of rcache
+            lfs_cache_t *line = lfs_cache_evict(lfs);
+            line->block = block;
+            line->off = off - (off % lfs->cfg->read_size);
+            int err = lfs->cfg->read(lfs->cfg, line->block,
+                    line->off, line->buffer, lfs->cfg->read_size);
+            if (err) {
+                line->block = 0xffffffff;
+                return err;
+            }
+
+            lfs_size_t diff = lfs_min(size,
+                    lfs->cfg->read_size - (off-line->off));
+            memcpy(data, &line->buffer[off-line->off], diff);
+
+            data += diff;
+            off += diff;
+            size -= diff;
+            continue;
+        }
+
         // load to cache, first condition can no longer fail
         rcache->block = block;
         rcache->off = off - (off % lfs->cfg->read_size);
@@ -125,6 +206,7 @@ static int lfs_cache_crc(lfs_t *lfs, lfs_cache_t *rcache,
 static int lfs_cache_flush(lfs_t *lfs,
         lfs_cache_t *pcache, lfs_cache_t *rcache) {
     if (pcache->block != 0xffffffff) {
+        lfs_cache_drop(lfs, pcache->block);
         int err = lfs->cfg->prog(lfs->cfg, pcache->block,
                 pcache->off, pcache->buffer, lfs->cfg->prog_size);
         if (err) {
@@ -186,6 +268,7 @@ static int lfs_cache_prog(lfs_t *lfs, lfs_cache_t *pcache,
                 size >= lfs->cfg->prog_size) {
             // bypass pcache?
             lfs_size_t diff = size - (size % lfs->cfg->prog_size);
+            lfs_cache_drop(lfs, block);
             int err = lfs->cfg->prog(lfs->cfg, block, off, data, diff);
             if (err) {
                 return err;
@@ -244,6 +327,7 @@ static int lfs_bd_crc(lfs_t *lfs, lfs_block_t block,
 }
 
 static int lfs_bd_erase(lfs_t *lfs, lfs_block_t block) {
+    lfs_cache_drop(lfs, block);
     return lfs->cfg->erase(lfs->cfg, block);
 }
 
@@ -285,7 +369,71 @@ static int lfs_alloc_lookahead(void *p, lfs_block_t block) {
     return 0;
 }
 
+static int lfs_alloc_bitmap(void *p, lfs_block_t block) {
+    lfs_t *lfs = p;
+
+    if (block < lfs->cfg->block_count) {
+        lfs->free.buffer[block / 32] |= 1U << (block % 32);
+    }
+
+    return 0;
+}
+
+static inline bool lfs_alloc_isbitmap(lfs_t *lfs) {
+    return lfs->cfg->lookahead >= lfs->cfg->block_count;
+}
+
+static int lfs_alloc_scan(lfs_t *lfs, lfs_block_t *block) {
+    if (lfs->free.count == 0) {
+        // bitmap is full, rebuild it from the tree in case
+        // we've lost track of any blocks
+        memset(lfs->free.buffer, 0, lfs->cfg->lookahead/8);
+        int err = lfs_traverse(lfs, lfs_alloc_bitmap, lfs);
+        if (err) {
+            return err;
+        }
+
+        // blocks allocated since last ack may not be in the tree yet
+        for (lfs_block_t i = lfs->free.end - lfs->cfg->block_count;
+                i != lfs->free.begin + lfs->free.off; i++) {
+            lfs_alloc_bitmap(lfs, i % lfs->cfg->block_count);
+        }
+
+        lfs->free.count = lfs->cfg->block_count;
+        for (lfs_size_t i = 0; i < lfs->cfg->lookahead/32; i++) {
+            lfs->free.count -= lfs_popc(lfs->free.buffer[i]);
+        }
+    }
+
+    while (lfs->free.count > 0) {
+        // check if we have looked at all blocks since last ack
+        if (lfs->free.begin + lfs->free.off == lfs->free.end) {
+            break;
+        }
+
+        lfs_block_t off = (lfs->free.begin + lfs->free.off)
+                % lfs->cfg->block_count;
+        lfs->free.off += 1;
+
+        if (!(lfs->free.buffer[off / 32] & (1U << (off % 32)))) {
+            // found a free block
+            lfs->free.buffer[off / 32] |= 1U << (off % 32);
+            lfs->free.count -= 1;
+            *block = off;
+            return 0;
+        }
+    }
+
+    LFS_WARN("No more free space %ld", lfs->free.end);
+    return LFS_ERR_NOSPC;
+}
+
 static int lfs_alloc(lfs_t *lfs, lfs_block_t *block) {
+    if (lfs_alloc_isbitmap(lfs)) {
+        // lookahead covers the whole device, keep it as a bitmap
+        return lfs_alloc_scan(lfs, block);
+    }
+
     while (true) {
         while (true) {
             // check if we have looked at all blocks since last ack
@@ -325,6 +473,26 @@ static void lfs_alloc_ack(lfs_t *lfs) {
     lfs->free.end = lfs->free.begin + lfs->free.off + lfs->cfg->block_count;
 }
 
+static void lfs_alloc_reset(lfs_t *lfs) {
+    lfs->free.end = lfs->free.begin + lfs->free.off + lfs->cfg->block_count;
+
+    // bitmap starts out full, forcing a scan on the first allocation
+    if (lfs_alloc_isbitmap(lfs)) {
+        memset(lfs->free.buffer, 0xff, lfs->cfg->lookahead/8);
+        lfs->free.count = 0;
+    }
+}
+
+static void lfs_alloc_release(lfs_t *lfs, lfs_block_t block) {
+    // only the bitmap remembers blocks, the lookahead finds released
+    // blocks on its next pass
+    if (lfs_alloc_isbitmap(lfs) && block < lfs->cfg->block_count &&
+            (lfs->free.buffer[block / 32] & (1U << (block % 32)))) {
+        lfs->free.buffer[block / 32] &= ~(1U << (block % 32));
+        lfs->free.count += 1;
+    }
+}
+
 
 /// Metadata pair and directory operations ///
 static inline void lfs_pairswap(lfs_block_t pair[2]) {
@@ -355,6 +523,25 @@ static inline lfs_size_t lfs_entry_size(const lfs_entry_t *entry) {
     return 4 + entry->d.elen + entry->d.alen + entry->d.nlen;
 }
 
+static lfs_lookup_t *lfs_lookup_slot(lfs_t *lfs, uint32_t hash) {
+    if (!lfs->cfg->lookup) {
+        return NULL;
+    }
+
+    return &lfs->lookup[hash % lfs->cfg->lookup];
+}
+
+static void lfs_lookup_drop(lfs_t *lfs, const lfs_block_t pair[2]) {
+    for (lfs_size_t i = 0; i < lfs->cfg->lookup; i++) {
+        lfs_lookup_t *c = &lfs->lookup[i];
+        if (lfs_paircmp(c->head, pair) == 0 ||
+                lfs_paircmp(c->pair, pair) == 0) {
+            c->head[0] = 0xffffffff;
+            c->head[1] = 0xffffffff;
+        }
+    }
+}
+
 static int lfs_dir_alloc(lfs_t *lfs, lfs_dir_t *dir) {
     // allocate pair of dir blocks
     for (int i = 0; i < 2; i++) {
@@ -583,6 +770,20 @@ relocate:
         }
     }
 
+    // and any names we've cached
+    for (lfs_size_t i = 0; i < lfs->cfg->lookup; i++) {
+        lfs_lookup_t *c = &lfs->lookup[i];
+        if (lfs_paircmp(c->head, dir->pair) == 0) {
+            c->head[0] = dir->pair[0];
+            c->head[1] = dir->pair[1];
+        }
+
+        if (lfs_paircmp(c->pair, dir->pair) == 0) {
+            c->pair[0] = dir->pair[0];
+            c->pair[1] = dir->pair[1];
+        }
+    }
+
     return 0;
 }
 
@@ -652,7 +853,15 @@ static int lfs_dir_remove(lfs_t *lfs, lfs_dir_t *dir, lfs_entry_t *entry) {
             pdir.d.size &= dir->d.size | 0x7fffffff;
             pdir.d.tail[0] = dir->d.tail[0];
             pdir.d.tail[1] = dir->d.tail[1];
-            return lfs_dir_commit(lfs, &pdir, NULL, 0);
+            int err = lfs_dir_commit(lfs, &pdir, NULL, 0);
+            if (err) {
+                return err;
+            }
+
+            lfs_lookup_drop(lfs, dir->pair);
+            lfs_alloc_release(lfs, dir->pair[0]);
+            lfs_alloc_release(lfs, dir->pair[1]);
+            return 0;
         }
     }
 
@@ -685,6 +894,18 @@ static int lfs_dir_remove(lfs_t *lfs, lfs_dir_t *dir, lfs_entry_t *entry) {
         }
     }
 
+    for (lfs_size_t i = 0; i < lfs->cfg->lookup; i++) {
+        lfs_lookup_t *c = &lfs->lookup[i];
+        if (lfs_paircmp(c->pair, dir->pair) == 0) {
+            if (c->off == entry->off) {
+                c->head[0] = 0xffffffff;
+                c->head[1] = 0xffffffff;
+            } else if (c->off > entry->off) {
+                c->off -= lfs_entry_size(entry);
+            }
+        }
+    }
+
     return 0;
 }
 
@@ -716,6 +937,42 @@ static int lfs_dir_next(lfs_t *lfs, lfs_dir_t *dir, lfs_entry_t *entry) {
     return 0;
 }
 
+static int lfs_dir_lookup(lfs_t *lfs, lfs_dir_t *dir, lfs_entry_t *entry,
+        const lfs_lookup_t *lookup, const char *name, size_t len) {
+    if (lfs_paircmp(dir->pair, lookup->pair) != 0) {
+        int err = lfs_dir_fetch(lfs, dir, lookup->pair);
+        if (err) {
+            return err;
+        }
+    }
+
+    if (lookup->off + sizeof(entry->d) > (0x7fffffff & dir->d.size)-4) {
+        return false;
+    }
+
+    int err = lfs_bd_read(lfs, dir->pair[0], lookup->off,
+            &entry->d, sizeof(entry->d));
+    if (err) {
+        return err;
+    }
+
+    if (((0x7f & entry->d.type) != LFS_TYPE_REG &&
+         (0x7f & entry->d.type) != LFS_TYPE_DIR) ||
+        entry->d.nlen != len) {
+        return false;
+    }
+
+    int res = lfs_bd_cmp(lfs, dir->pair[0],
+            lookup->off + 4+entry->d.elen+entry->d.alen, name, len);
+    if (res <= 0) {
+        return res;
+    }
+
+    entry->off = lookup->off;
+    dir->off = lookup->off + lfs_entry_size(entry);
+    return true;
+}
+
 static int lfs_dir_find(lfs_t *lfs, lfs_dir_t *dir,
         lfs_entry_t *entry, const char **path) {
     const char *pathname = *path;
@@ -761,8 +1018,31 @@ static int lfs_dir_find(lfs_t *lfs, lfs_dir_t *dir,
         // update what we've found
         *path = pathname;
 
+        // check if we've seen this name before
+        const lfs_block_t head[2] = {dir->pair[0], dir->pair[1]};
+        uint32_t hash = 0xffffffff;
+        lfs_crc(&hash, pathname, pathlen);
+        lfs_lookup_t *lookup = lfs_lookup_slot(lfs, hash);
+
+        int found = false;
+        if (lookup && lookup->hash == hash &&
+                lfs_paircmp(lookup->head, head) == 0) {
+            found = lfs_dir_lookup(lfs, dir, entry, lookup, pathname, pathlen);
+            if (found < 0) {
+                return found;
+            }
+
+            if (!found && lfs_paircmp(dir->pair, head) != 0) {
+                // stale, fall back to scanning the directory
+                int err = lfs_dir_fetch(lfs, dir, head);
+                if (err) {
+                    return err;
+                }
+            }
+        }
+
         // find path
-        while (true) {
+        while (!found) {
             int err = lfs_dir_next(lfs, dir, entry);
             if (err) {
                 return err;
@@ -783,6 +1063,14 @@ static int lfs_dir_find(lfs_t *lfs, lfs_dir_t *dir,
 
             // found match
             if (res) {
+                if (lookup) {
+                    lookup->head[0] = head[0];
+                    lookup->head[1] = head[1];
+                    lookup->pair[0] = dir->pair[0];
+                    lookup->pair[1] = dir->pair[1];
+                    lookup->off = entry->off;
+                    lookup->hash = hash;
+                }
                 break;
             }
         }
@@ -1048,6 +1336,28 @@ static int lfs_ctz_index(lfs_t *lfs, lfs_off_t *off) {
     return i;
 }
 
+static int lfs_ctz_skip(lfs_t *lfs,
+        lfs_cache_t *rcache, const lfs_cache_t *pcache,
+        lfs_block_t head, lfs_off_t current, lfs_off_t target,
+        lfs_block_t *block) {
+    while (current > target) {
+        lfs_size_t skip = lfs_min(
+                lfs_npw2(current-target+1) - 1,
+                lfs_ctz(current));
+
+        int err = lfs_cache_read(lfs, rcache, pcache, head, 4*skip, &head, 4);
+        if (err) {
+            return err;
+        }
+
+        assert(head >= 2 && head <= lfs->cfg->block_count);
+        current -= 1 << skip;
+    }
+
+    *block = head;
+    return 0;
+}
+
 static int lfs_ctz_find(lfs_t *lfs,
         lfs_cache_t *rcache, const lfs_cache_t *pcache,
         lfs_block_t head, lfs_size_t size,
@@ -1061,12 +1371,79 @@ static int lfs_ctz_find(lfs_t *lfs,
     lfs_off_t current = lfs_ctz_index(lfs, &(lfs_off_t){size-1});
     lfs_off_t target = lfs_ctz_index(lfs, &pos);
 
-    while (current > target) {
+    *off = pos;
+    return lfs_ctz_skip(lfs, rcache, pcache, head, current, target, block);
+}
+
+static void lfs_index_fit(lfs_t *lfs, lfs_file_t *file) {
+    // spread the index over the whole file, doubling the stride and
+    // keeping every other entry if the file has outgrown it
+    lfs_off_t last = lfs_ctz_index(lfs, &(lfs_off_t){file->size-1});
+    while (last / file->stride >= lfs->cfg->seek_index) {
+        for (lfs_off_t i = 0; i < lfs->cfg->seek_index; i++) {
+            file->index[i] = (2*i < lfs->cfg->seek_index)
+                    ? file->index[2*i] : 0xffffffff;
+        }
+
+        file->stride *= 2;
+    }
+}
+
+static void lfs_index_drop(lfs_t *lfs, lfs_file_t *file, lfs_off_t pos) {
+    if (!file->index) {
+        return;
+    }
+
+    // forget blocks that may be rewritten when writing at pos
+    lfs_off_t index = 0;
+    if (pos > 0) {
+        index = lfs_ctz_index(lfs, &(lfs_off_t){pos-1});
+    }
+
+    for (lfs_off_t i = (index + file->stride-1) / file->stride;
+            i < lfs->cfg->seek_index; i++) {
+        file->index[i] = 0xffffffff;
+    }
+}
+
+static int lfs_index_find(lfs_t *lfs, lfs_file_t *file,
+        lfs_size_t pos, lfs_block_t *block, lfs_off_t *off) {
+    if (!file->index || file->size == 0) {
+        return lfs_ctz_find(lfs, &file->cache, NULL,
+                file->head, file->size, pos, block, off);
+    }
+
+    lfs_index_fit(lfs, file);
+    lfs_off_t current = lfs_ctz_index(lfs, &(lfs_off_t){file->size-1});
+    lfs_off_t target = lfs_ctz_index(lfs, &pos);
+    lfs_block_t head = file->head;
+
+    // start from the nearest remembered block at or after the target
+    for (lfs_off_t i = (target + file->stride-1) / file->stride;
+            i*file->stride < current; i++) {
+        if (file->index[i] != 0xffffffff) {
+            current = i*file->stride;
+            head = file->index[i];
+            break;
+        }
+    }
+
+    // walk the skip-list, remembering any indexed blocks we pass
+    while (true) {
+        if (current % file->stride == 0) {
+            file->index[current / file->stride] = head;
+        }
+
+        if (current <= target) {
+            break;
+        }
+
         lfs_size_t skip = lfs_min(
                 lfs_npw2(current-target+1) - 1,
                 lfs_ctz(current));
 
-        int err = lfs_cache_read(lfs, rcache, pcache, head, 4*skip, &head, 4);
+        int err = lfs_cache_read(lfs, &file->cache, NULL,
+                head, 4*skip, &head, 4);
         if (err) {
             return err;
         }
@@ -1204,6 +1581,69 @@ static int lfs_ctz_traverse(lfs_t *lfs,
     }
 }
 
+static int lfs_ctz_shared(lfs_t *lfs, const lfs_cache_t *pcache,
+        lfs_block_t head, lfs_size_t size,
+        lfs_off_t index, lfs_block_t block) {
+    if (size == 0) {
+        return false;
+    }
+
+    lfs_off_t current = lfs_ctz_index(lfs, &(lfs_off_t){size-1});
+    if (current < index) {
+        return false;
+    }
+
+    int err = lfs_ctz_skip(lfs, &lfs->rcache, pcache,
+            head, current, index, &head);
+    if (err) {
+        return err;
+    }
+
+    return head == block;
+}
+
+static int lfs_ctz_release(lfs_t *lfs, lfs_block_t head, lfs_size_t size) {
+    if (!lfs_alloc_isbitmap(lfs) || size == 0) {
+        return 0;
+    }
+
+    lfs_off_t index = lfs_ctz_index(lfs, &(lfs_off_t){size-1});
+
+    while (true) {
+        // lists only share their tails, so once an open file uses a
+        // block it also uses every block after it
+        for (lfs_file_t *f = lfs->files; f; f = f->next) {
+            int res = 0;
+            if (f->flags & LFS_F_DIRTY) {
+                res = lfs_ctz_shared(lfs, &f->cache,
+                        f->head, f->size, index, head);
+            }
+
+            if (!res && (f->flags & LFS_F_WRITING)) {
+                res = lfs_ctz_shared(lfs, &f->cache,
+                        f->block, f->pos, index, head);
+            }
+
+            if (res) {
+                return res < 0 ? res : 0;
+            }
+        }
+
+        lfs_alloc_release(lfs, head);
+
+        if (index == 0) {
+            return 0;
+        }
+
+        int err = lfs_cache_read(lfs, &lfs->rcache, NULL, head, 0, &head, 4);
+        if (err) {
+            return err;
+        }
+
+        index -= 1;
+    }
+}
+
 
 /// Top level file operations ///
 int lfs_file_open(lfs_t *lfs, lfs_file_t *file,
@@ -1281,6 +1721,25 @@ int lfs_file_open(lfs_t *lfs, lfs_file_t *file,
         }
     }
 
+    // allocate seek index if needed
+    file->index = NULL;
+    file->stride = 1;
+    if (lfs->cfg->seek_index) {
+        if (lfs->cfg->seek_index_buffer) {
+            file->index = lfs->cfg->seek_index_buffer;
+        } else {
+            file->index = malloc(lfs->cfg->seek_index*sizeof(lfs_block_t));
+            if (!file->index) {
+                if (!lfs->cfg->file_buffer) {
+                    free(file->cache.buffer);
+                }
+                return LFS_ERR_NOMEM;
+            }
+        }
+
+        memset(file->index, 0xff, lfs->cfg->seek_index*sizeof(lfs_block_t));
+    }
+
     // add to list of files
     file->next = lfs->files;
     lfs->files = file;
@@ -1304,6 +1763,10 @@ int lfs_file_close(lfs_t *lfs, lfs_file_t *file) {
         free(file->cache.buffer);
     }
 
+    if (!lfs->cfg->seek_index_buffer) {
+        free(file->index);
+    }
+
     return err;
 }
 
@@ -1454,6 +1917,8 @@ int lfs_file_sync(lfs_t *lfs, lfs_file_t *file) {
             return LFS_ERR_INVAL;
         }
 
+        lfs_block_t ohead = entry.d.u.file.head;
+        lfs_size_t osize = entry.d.u.file.size;
         entry.d.u.file.head = file->head;
         entry.d.u.file.size = file->size;
 
@@ -1462,6 +1927,12 @@ int lfs_file_sync(lfs_t *lfs, lfs_file_t *file) {
             return err;
         }
 
+        // release blocks only the old version of the file used
+        err = lfs_ctz_release(lfs, ohead, osize);
+        if (err) {
+            return err;
+        }
+
         file->flags &= ~LFS_F_DIRTY;
     }
 
@@ -1497,8 +1968,7 @@ lfs_ssize_t lfs_file_read(lfs_t *lfs, lfs_file_t *file,
         // check if we need a new block
         if (!(file->flags & LFS_F_READING) ||
                 file->off == lfs->cfg->block_size) {
-            int err = lfs_ctz_find(lfs, &file->cache, NULL,
-                    file->head, file->size,
+            int err = lfs_index_find(lfs, file,
                     file->pos, &file->block, &file->off);
             if (err) {
                 return err;
@@ -1564,8 +2034,7 @@ lfs_ssize_t lfs_file_write(lfs_t *lfs, lfs_file_t *file,
                 file->off == lfs->cfg->block_size) {
             if (!(file->flags & LFS_F_WRITING) && file->pos > 0) {
                 // find out which block we're extending from
-                int err = lfs_ctz_find(lfs, &file->cache, NULL,
-                        file->head, file->size,
+                int err = lfs_index_find(lfs, file,
                         file->pos-1, &file->block, &file->off);
                 if (err) {
                     file->flags |= LFS_F_ERRED;
@@ -1576,6 +2045,11 @@ lfs_ssize_t lfs_file_write(lfs_t *lfs, lfs_file_t *file,
                 file->cache.block = 0xffffffff;
             }
 
+            // blocks past here are about to be replaced
+            if (!(file->flags & LFS_F_WRITING)) {
+                lfs_index_drop(lfs, file, file->pos);
+            }
+
             // extend file with new blocks
             lfs_alloc_ack(lfs);
             int err = lfs_ctz_extend(lfs, &lfs->rcache, &file->cache,
@@ -1762,6 +2236,16 @@ int lfs_remove(lfs_t *lfs, const char *path) {
         if (err) {
             return err;
         }
+
+        lfs_lookup_drop(lfs, dir.pair);
+        lfs_alloc_release(lfs, dir.pair[0]);
+        lfs_alloc_release(lfs, dir.pair[1]);
+    } else {
+        int err = lfs_ctz_release(lfs,
+                entry.d.u.file.head, entry.d.u.file.size);
+        if (err) {
+            return err;
+        }
     }
 
     return 0;
@@ -1879,6 +2363,17 @@ int lfs_rename(lfs_t *lfs, const char *oldpath, const char *newpath) {
         if (err) {
             return err;
         }
+
+        lfs_lookup_drop(lfs, dir.pair);
+        lfs_alloc_release(lfs, dir.pair[0]);
+        lfs_alloc_release(lfs, dir.pair[1]);
+    } else if (prevexists &&
+            preventry.d.u.file.head != oldentry.d.u.file.head) {
+        int err = lfs_ctz_release(lfs,
+                preventry.d.u.file.head, preventry.d.u.file.size);
+        if (err) {
+            return err;
+        }
     }
 
     return 0;
@@ -1900,6 +2395,29 @@ static int lfs_init(lfs_t *lfs, const struct lfs_config *cfg) {
         }
     }
 
+    // setup shared read cache, a single line just uses the rcache
+    lfs->lines = NULL;
+    lfs->stats.read_hits = 0;
+    lfs->stats.read_misses = 0;
+    if (lfs->cfg->read_cache > 1) {
+        // line buffers follow the lines unless statically allocated
+        lfs->lines = malloc(lfs->cfg->read_cache*(sizeof(lfs_cache_t) +
+                (lfs->cfg->read_cache_buffer ? 0 : lfs->cfg->read_size)));
+        if (!lfs->lines) {
+            return LFS_ERR_NOMEM;
+        }
+
+        uint8_t *buffer = lfs->cfg->read_cache_buffer;
+        if (!buffer) {
+            buffer = (uint8_t*)&lfs->lines[lfs->cfg->read_cache];
+        }
+
+        for (lfs_size_t i = 0; i < lfs->cfg->read_cache; i++) {
+            lfs->lines[i].block = 0xffffffff;
+            lfs->lines[i].buffer = &buffer[i*lfs->cfg->read_size];
+        }
+    }
+
     // setup program cache
     lfs->pcache.block = 0xffffffff;
     if (lfs->cfg->prog_buffer) {
@@ -1923,6 +2441,24 @@ static int lfs_init(lfs_t *lfs, const struct lfs_config *cfg) {
         }
     }
 
+    // setup lookup cache
+    lfs->lookup = NULL;
+    if (lfs->cfg->lookup) {
+        if (lfs->cfg->lookup_buffer) {
+            lfs->lookup = lfs->cfg->lookup_buffer;
+        } else {
+            lfs->lookup = malloc(lfs->cfg->lookup*sizeof(lfs_lookup_t));
+            if (!lfs->lookup) {
+                return LFS_ERR_NOMEM;
+            }
+        }
+
+        for (lfs_size_t i = 0; i < lfs->cfg->lookup; i++) {
+            lfs->lookup[i].head[0] = 0xffffffff;
+            lfs->lookup[i].head[1] = 0xffffffff;
+        }
+    }
+
     // check that the block size is large enough to fit ctz pointers
     assert(4*lfs_npw2(0xffffffff / (lfs->cfg->block_size-2*4))
             <= lfs->cfg->block_size);
@@ -1947,10 +2483,16 @@ static int lfs_deinit(lfs_t *lfs) {
         free(lfs->pcache.buffer);
     }
 
+    free(lfs->lines);
+
     if (!lfs->cfg->lookahead_buffer) {
         free(lfs->free.buffer);
     }
 
+    if (!lfs->cfg->lookup_buffer) {
+        free(lfs->lookup);
+    }
+
     return 0;
 }
 
@@ -1964,7 +2506,7 @@ int lfs_format(lfs_t *lfs, const struct lfs_config *cfg) {
     memset(lfs->free.buffer, 0, lfs->cfg->lookahead/8);
     lfs->free.begin = 0;
     lfs->free.off = 0;
-    lfs->free.end = lfs->free.begin + lfs->free.off + lfs->cfg->block_count;
+    lfs_alloc_reset(lfs);
 
     // create superblock dir
     lfs_alloc_ack(lfs);
@@ -2042,7 +2584,7 @@ int lfs_mount(lfs_t *lfs, const struct lfs_config *cfg) {
     // setup free lookahead
     lfs->free.begin = -lfs->cfg->lookahead;
     lfs->free.off = lfs->cfg->lookahead;
-    lfs->free.end = lfs->free.begin + lfs->free.off + lfs->cfg->block_count;
+    lfs_alloc_reset(lfs);
 
     // load superblock
     lfs_dir_t dir;
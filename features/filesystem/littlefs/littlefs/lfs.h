@@ -135,6 +135,11 @@ struct lfs_config {
     // lookahead reduces the number of passes required to allocate a block.
     // The lookahead buffer requires only 1 bit per block so it can be quite
     // large with little ram impact. Should be a multiple of 32.
+    //
+    // If the lookahead covers every block, the lookahead buffer is instead
+    // kept as a bitmap of blocks in use, updated as blocks are allocated
+    // and released. The filesystem is then only scanned on the first
+    // allocation after mount, or if the bitmap runs out of free blocks.
     lfs_size_t lookahead;
 
     // Optional, statically allocated read buffer. Must be read sized.
@@ -150,6 +155,36 @@ struct lfs_config {
     // Optional, statically allocated buffer for files. Must be program sized.
     // If enabled, only one file may be opened at a time.
     void *file_buffer;
+
+    // Number of directory entries to remember during path lookup. A cached
+    // name is found without scanning the rest of its directory, which helps
+    // large directories. Each entry requires 24 bytes of ram. Zero disables
+    // the lookup cache.
+    lfs_size_t lookup;
+
+    // Optional, statically allocated lookup cache. Must be lookup entries
+    // of lfs_lookup_t.
+    void *lookup_buffer;
+
+    // Number of read sized lines in the read cache. Metadata and file
+    // reads share these lines, and the least recently used line is
+    // evicted on a miss. Zero or one uses a single line.
+    lfs_size_t read_cache;
+
+    // Optional, statically allocated buffer for the read cache lines. Must
+    // be read_cache times read sized.
+    void *read_cache_buffer;
+
+    // Number of block addresses each open file remembers while walking its
+    // skip-list. The addresses are kept at evenly spaced block indices, so
+    // a seek only walks the skip-list from the nearest remembered block.
+    // Each entry requires 4 bytes of ram per open file. Zero disables the
+    // seek index.
+    lfs_size_t seek_index;
+
+    // Optional, statically allocated seek index. Must be seek_index entries
+    // of lfs_block_t. If enabled, only one file may be opened at a time.
+    void *seek_index_buffer;
 };
 
 
@@ -204,6 +239,9 @@ typedef struct lfs_file {
     lfs_block_t block;
     lfs_off_t off;
     lfs_cache_t cache;
+
+    lfs_block_t *index;
+    lfs_off_t stride;
 } lfs_file_t;
 
 typedef struct lfs_dir {
@@ -237,10 +275,18 @@ typedef struct lfs_superblock {
     } d;
 } lfs_superblock_t;
 
+typedef struct lfs_lookup {
+    lfs_block_t head[2];
+    lfs_block_t pair[2];
+    lfs_off_t off;
+    uint32_t hash;
+} lfs_lookup_t;
+
 typedef struct lfs_free {
     lfs_block_t begin;
     lfs_block_t end;
     lfs_block_t off;
+    lfs_size_t count;
     uint32_t *buffer;
 } lfs_free_t;
 
@@ -254,9 +300,16 @@ typedef struct lfs {
 
     lfs_cache_t rcache;
     lfs_cache_t pcache;
+    lfs_cache_t *lines;
 
     lfs_free_t free;
+    lfs_lookup_t *lookup;
     bool deorphaned;
+
+    struct {
+        uint32_t read_hits;
+        uint32_t read_misses;
+    } stats;
 } lfs_t;
 
 
@@ -18,6 +18,14 @@
 #include "lfs_util.h"
 
 
+#ifdef __MBED__
+#include "platform/mbed_crc.h"
+
+void lfs_crc(uint32_t *restrict crc, const void *buffer, size_t size) {
+    *crc = mbed_crc32_update(*crc, buffer, size);
+}
+
+#else
 void lfs_crc(uint32_t *restrict crc, const void *buffer, size_t size) {
     static const uint32_t rtable[16] = {
         0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
@@ -34,3 +42,4 @@ void lfs_crc(uint32_t *restrict crc, const void *buffer, size_t size) {
     }
 }
 
+#endif
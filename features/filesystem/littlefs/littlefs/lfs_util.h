@@ -85,6 +85,8 @@ static inline int lfs_scmp(uint32_t a, uint32_t b) {
 }
 
 // CRC-32 with polynomial = 0x04c11db7
+//
+// In mbed this uses the platform's CRC, see platform/mbed_crc.h
 void lfs_crc(uint32_t *crc, const void *buffer, size_t size);
 
 
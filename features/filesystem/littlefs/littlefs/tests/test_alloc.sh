@@ -266,6 +266,62 @@ tests/test.py << TEST
     lfs_mkdir(&lfs, "exhaustiondir2") => LFS_ERR_NOSPC;
 TEST
 
+echo "--- Allocation latency test ---"
+tests/test.py << TEST
+    lfs_format(&lfs, &cfg) => 0;
+    lfs_mount(&lfs, &cfg) => 0;
+    for (int i = 0; i < 64; i++) {
+        sprintf((char*)buffer, "log%d", i);
+        lfs_file_open(&lfs, &file[0], (char*)buffer,
+                LFS_O_WRONLY | LFS_O_CREAT) => 0;
+        size = strlen("blahblahblahblah");
+        memcpy(buffer, "blahblahblahblah", size);
+        for (int j = 0; j < 2*cfg.block_size; j += size) {
+            lfs_file_write(&lfs, &file[0], buffer, size) => size;
+        }
+        lfs_file_close(&lfs, &file[0]) => 0;
+    }
+    lfs_unmount(&lfs) => 0;
+
+    // a lookahead covering the whole device acts as a bitmap
+    struct lfs_config lcfg = cfg;
+    lcfg.lookahead = 128;
+    struct lfs_config bcfg = cfg;
+    bcfg.lookahead = 32*((cfg.block_count+31)/32);
+    const struct lfs_config *cfgs[2] = {&lcfg, &bcfg};
+    uint64_t worst[2] = {0, 0};
+    uint64_t total[2] = {0, 0};
+
+    for (int m = 0; m < 2; m++) {
+        lfs_mount(&lfs, cfgs[m]) => 0;
+        for (int i = 0; i < 512; i++) {
+            uint64_t reads = bd.stats.read_count;
+            sprintf((char*)buffer, "log%d", i % 64);
+            lfs_file_open(&lfs, &file[0], (char*)buffer,
+                    LFS_O_WRONLY | LFS_O_APPEND) => 0;
+            size = strlen("blahblahblahblah");
+            memcpy(buffer, "blahblahblahblah", size);
+            for (int j = 0; j < 64; j += size) {
+                lfs_file_write(&lfs, &file[0], buffer, size) => size;
+            }
+            lfs_file_close(&lfs, &file[0]) => 0;
+            reads = bd.stats.read_count - reads;
+
+            // first allocation after mount always scans
+            if (i > 0) {
+                worst[m] = lfs_max(worst[m], reads);
+                total[m] += reads;
+            }
+        }
+        lfs_unmount(&lfs) => 0;
+    }
+
+    test_log("lookahead worst reads", worst[0]);
+    test_log("lookahead total reads", total[0]);
+    test_log("bitmap worst reads", worst[1]);
+    test_log("bitmap total reads", total[1]);
+    worst[1] < worst[0] => true;
+TEST
 
 echo "--- Results ---"
 tests/stats.py
@@ -0,0 +1,147 @@
+#!/bin/bash
+set -eu
+
+echo "=== CRC tests ==="
+rm -rf blocks
+tests/test.py << TEST
+    lfs_format(&lfs, &cfg) => 0;
+TEST
+
+echo "--- CRC check value ---"
+tests/test.py << TEST
+    uint32_t crc = 0xffffffff;
+    lfs_crc(&crc, "123456789", 9);
+    crc ^ 0xffffffff => 0xcbf43926;
+
+    // split across calls
+    crc = 0xffffffff;
+    lfs_crc(&crc, "1234", 4);
+    lfs_crc(&crc, "", 0);
+    lfs_crc(&crc, "56789", 5);
+    crc ^ 0xffffffff => 0xcbf43926;
+TEST
+
+echo "--- CRC equivalence ---"
+tests/test.py << TEST
+    static const uint32_t rtable[16] = {
+        0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+        0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+        0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+        0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+    };
+
+    srand(1);
+    for (int i = 0; i < 1024; i++) {
+        buffer[i] = rand();
+    }
+
+    // every alignment and a spread of lengths and starting states
+    for (int i = 0; i < 4096; i++) {
+        lfs_size_t off = i % 8;
+        lfs_size_t len = (i < 64) ? i : rand() % (1024 - off);
+        uint32_t expected = rand();
+        uint32_t crc = expected;
+
+        for (lfs_size_t j = off; j < off+len; j++) {
+            expected = (expected >> 4) ^ rtable[(expected ^ (buffer[j] >> 0)) & 0xf];
+            expected = (expected >> 4) ^ rtable[(expected ^ (buffer[j] >> 4)) & 0xf];
+        }
+
+        lfs_crc(&crc, &buffer[off], len);
+        crc => expected;
+    }
+TEST
+
+echo "--- CRC benchmark ---"
+tests/test.py << TEST
+    srand(1);
+    for (int i = 0; i < 1024; i++) {
+        buffer[i] = rand();
+    }
+
+    uint32_t crc = 0xffffffff;
+    clock_t start = clock();
+    for (int i = 0; i < 16*1024; i++) {
+        lfs_crc(&crc, buffer, 1024);
+    }
+    clock_t ticks = clock() - start;
+    test_log("crc", crc);
+    test_log("crc KiB/s", (uintmax_t)(16*1024.0 * CLOCKS_PER_SEC
+            / (ticks ? ticks : 1)));
+TEST
+
+# mbed builds use the platform CRC instead, check each of its software
+# implementations against the nibble loop and time it against lfs_crc
+MBED=../../../..
+BASE_CFLAGS="${CFLAGS:-}"
+for SLICE8 in 0 1
+do
+export SRC="$MBED/platform/mbed_crc.c"
+export CFLAGS="$BASE_CFLAGS -I$MBED -include platform/mbed_crc.h \
+    -DMBED_CONF_PLATFORM_CRC_SLICE8=$SLICE8"
+rm -f $MBED/platform/mbed_crc.o
+
+echo "--- Platform CRC equivalence, slice-by-8 $SLICE8 ---"
+tests/test.py << TEST
+    static const uint32_t rtable[16] = {
+        0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+        0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+        0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+        0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+    };
+
+    mbed_crc32_update(0xffffffff, "123456789", 9) ^ 0xffffffff => 0xcbf43926;
+
+    srand(1);
+    for (int i = 0; i < 1024; i++) {
+        buffer[i] = rand();
+    }
+
+    // every alignment with every short length, then random lengths
+    // and starting states
+    for (int i = 0; i < 8*72 + 4096; i++) {
+        lfs_size_t off = i % 8;
+        lfs_size_t len = (i < 8*72) ? i / 8 : rand() % (1024 - off);
+        uint32_t expected = rand();
+        uint32_t crc = expected;
+
+        for (lfs_size_t j = off; j < off+len; j++) {
+            expected = (expected >> 4) ^ rtable[(expected ^ (buffer[j] >> 0)) & 0xf];
+            expected = (expected >> 4) ^ rtable[(expected ^ (buffer[j] >> 4)) & 0xf];
+        }
+
+        mbed_crc32_update(crc, &buffer[off], len) => expected;
+    }
+TEST
+
+echo "--- Platform CRC benchmark, slice-by-8 $SLICE8 ---"
+tests/test.py << TEST
+    srand(1);
+    for (int i = 0; i < 1024; i++) {
+        buffer[i] = rand();
+    }
+
+    uint32_t crc = 0xffffffff;
+    clock_t start = clock();
+    for (int i = 0; i < 16*1024; i++) {
+        lfs_crc(&crc, buffer, 1024);
+    }
+    clock_t ticks = clock() - start;
+    test_log("lfs_crc KiB/s", (uintmax_t)(16*1024.0 * CLOCKS_PER_SEC
+            / (ticks ? ticks : 1)));
+
+    uint32_t mcrc = 0xffffffff;
+    start = clock();
+    for (int i = 0; i < 16*1024; i++) {
+        mcrc = mbed_crc32_update(mcrc, buffer, 1024);
+    }
+    ticks = clock() - start;
+    test_log("mbed_crc32_update KiB/s", (uintmax_t)(16*1024.0 * CLOCKS_PER_SEC
+            / (ticks ? ticks : 1)));
+    mcrc => crc;
+TEST
+rm -f $MBED/platform/mbed_crc.o $MBED/platform/mbed_crc.d
+done
+
+echo "--- Results ---"
+tests/stats.py
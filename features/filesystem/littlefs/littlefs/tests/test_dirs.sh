@@ -355,5 +355,57 @@ tests/test.py << TEST
     lfs_unmount(&lfs) => 0;
 TEST
 
+echo "--- Directory lookup latency ---"
+tests/test.py << TEST
+    lfs_format(&lfs, &cfg) => 0;
+    lfs_mount(&lfs, &cfg) => 0;
+    const int sizes[3] = {16, 64, 256};
+    for (int s = 0; s < 3; s++) {
+        sprintf((char*)buffer, "lookup%d", sizes[s]);
+        lfs_mkdir(&lfs, (char*)buffer) => 0;
+        for (int i = 0; i < sizes[s]; i++) {
+            sprintf((char*)buffer, "lookup%d/file%d", sizes[s], i);
+            lfs_file_open(&lfs, &file[0], (char*)buffer,
+                    LFS_O_WRONLY | LFS_O_CREAT) => 0;
+            lfs_file_close(&lfs, &file[0]) => 0;
+        }
+    }
+    lfs_unmount(&lfs) => 0;
+
+    struct lfs_config ucfg = cfg;
+    ucfg.lookup = 0;
+    struct lfs_config ccfg = cfg;
+    ccfg.lookup = 64;
+    const struct lfs_config *cfgs[2] = {&ucfg, &ccfg};
+    uint64_t reads[2][3];
+
+    for (int m = 0; m < 2; m++) {
+        lfs_mount(&lfs, cfgs[m]) => 0;
+        for (int s = 0; s < 3; s++) {
+            uint64_t start = bd.stats.read_count;
+            for (int j = 0; j < 4; j++) {
+                // the newest names sit at the end of the directory
+                for (int i = sizes[s]-8; i < sizes[s]; i++) {
+                    sprintf((char*)buffer, "lookup%d/file%d", sizes[s], i);
+                    lfs_stat(&lfs, (char*)buffer, &info) => 0;
+                    lfs_file_open(&lfs, &file[0], (char*)buffer,
+                            LFS_O_RDONLY) => 0;
+                    lfs_file_close(&lfs, &file[0]) => 0;
+                }
+            }
+            reads[m][s] = (bd.stats.read_count - start) / (2*4*8);
+        }
+        lfs_unmount(&lfs) => 0;
+    }
+
+    test_log("reads per lookup, 16 entries, uncached", reads[0][0]);
+    test_log("reads per lookup, 16 entries, cached", reads[1][0]);
+    test_log("reads per lookup, 64 entries, uncached", reads[0][1]);
+    test_log("reads per lookup, 64 entries, cached", reads[1][1]);
+    test_log("reads per lookup, 256 entries, uncached", reads[0][2]);
+    test_log("reads per lookup, 256 entries, cached", reads[1][2]);
+    reads[1][2] < reads[0][2] => true;
+TEST
+
 echo "--- Results ---"
 tests/stats.py
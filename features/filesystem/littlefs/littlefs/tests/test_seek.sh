@@ -357,5 +357,103 @@ tests/test.py << TEST
     lfs_unmount(&lfs) => 0;
 TEST
 
+echo "--- Read cache test ---"
+tests/test.py << TEST
+    struct lfs_config scfg = cfg;
+    scfg.read_cache = 1;
+    struct lfs_config mcfg = cfg;
+    mcfg.read_cache = 64;
+    const struct lfs_config *cfgs[2] = {&scfg, &mcfg};
+    uint64_t reads[2];
+
+    for (int m = 0; m < 2; m++) {
+        lfs_mount(&lfs, cfgs[m]) => 0;
+        uint64_t start = bd.stats.read_count;
+
+        // alternate between two files and metadata lookups
+        lfs_file_open(&lfs, &file[0], "hello/kitty21", LFS_O_RDONLY) => 0;
+        lfs_file_open(&lfs, &file[1], "hello/kitty84", LFS_O_RDONLY) => 0;
+        size = strlen("kittycatcat");
+        srand(1);
+        for (int i = 0; i < $MEDIUMSIZE; i++) {
+            for (int f = 0; f < 2; f++) {
+                lfs_soff_t off = size*(rand() % $LARGESIZE);
+                lfs_file_seek(&lfs, &file[f], off, LFS_SEEK_SET) => off;
+                lfs_file_read(&lfs, &file[f], buffer, size) => size;
+                memcmp(buffer, "kittycatcat", size) => 0;
+            }
+
+            sprintf((char*)buffer, "hello/kitty%d", i % 4);
+            lfs_stat(&lfs, (char*)buffer, &info) => 0;
+        }
+        lfs_file_close(&lfs, &file[0]) => 0;
+        lfs_file_close(&lfs, &file[1]) => 0;
+
+        reads[m] = bd.stats.read_count - start;
+        test_log("read cache lines", cfgs[m]->read_cache);
+        test_log("read cache hits", lfs.stats.read_hits);
+        test_log("read cache misses", lfs.stats.read_misses);
+        test_log("block device reads", reads[m]);
+        lfs_unmount(&lfs) => 0;
+    }
+
+    reads[1] < reads[0] => true;
+TEST
+
+echo "--- Seek index test ---"
+tests/test.py << TEST
+    struct lfs_config ncfg = cfg;
+    ncfg.read_cache = 1;
+    ncfg.seek_index = 0;
+    struct lfs_config icfg = ncfg;
+    icfg.seek_index = 16;
+    const struct lfs_config *cfgs[2] = {&ncfg, &icfg};
+    uint64_t reads[2];
+
+    lfs_mount(&lfs, &cfg) => 0;
+    lfs_file_open(&lfs, &file[0], "bigseek",
+            LFS_O_WRONLY | LFS_O_CREAT) => 0;
+    for (lfs_size_t i = 0; i < 128*1024; i += 4) {
+        lfs_file_write(&lfs, &file[0], &i, 4) => 4;
+    }
+    lfs_file_close(&lfs, &file[0]) => 0;
+    lfs_unmount(&lfs) => 0;
+
+    for (int m = 0; m < 2; m++) {
+        lfs_mount(&lfs, cfgs[m]) => 0;
+        uint64_t start = bd.stats.read_count;
+
+        lfs_file_open(&lfs, &file[0], "bigseek", LFS_O_RDWR) => 0;
+        srand(1);
+        for (int i = 0; i < 512; i++) {
+            lfs_size_t off = 4*(rand() % (32*1024));
+            lfs_file_seek(&lfs, &file[0], off, LFS_SEEK_SET) => off;
+            lfs_file_read(&lfs, &file[0], &size, 4) => 4;
+            size => off;
+        }
+        reads[m] = bd.stats.read_count - start;
+
+        // rewrite the middle, the index must not point at stale blocks
+        lfs_size_t mark = 0xdeadbeef ^ m;
+        lfs_file_seek(&lfs, &file[0], 64*1024, LFS_SEEK_SET) => 64*1024;
+        lfs_file_write(&lfs, &file[0], &mark, 4) => 4;
+        for (int i = 0; i < 512; i++) {
+            lfs_size_t off = 4*(rand() % (32*1024));
+            lfs_file_seek(&lfs, &file[0], off, LFS_SEEK_SET) => off;
+            lfs_file_read(&lfs, &file[0], &size, 4) => 4;
+            size => (off == 64*1024 ? mark : off);
+        }
+        lfs_file_seek(&lfs, &file[0], 64*1024, LFS_SEEK_SET) => 64*1024;
+        lfs_file_write(&lfs, &file[0], &(lfs_size_t){64*1024}, 4) => 4;
+        lfs_file_close(&lfs, &file[0]) => 0;
+
+        test_log("seek index entries", cfgs[m]->seek_index);
+        test_log("block device reads", reads[m]);
+        lfs_unmount(&lfs) => 0;
+    }
+
+    reads[1] < reads[0] => true;
+TEST
+
 echo "--- Results ---"
 tests/stats.py
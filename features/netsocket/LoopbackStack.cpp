@@ -0,0 +1,564 @@
+/* LoopbackStack
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LoopbackStack.h"
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+#define LOOPBACK_EPHEMERAL_MIN 49152
+#define LOOPBACK_EPHEMERAL_MAX 65535
+
+
+// UDP packet waiting on a socket, the data follows the header
+struct LoopbackStack::packet {
+    packet *next;
+    nsapi_addr_t addr;
+    uint16_t port;
+    nsapi_size_t size;
+};
+
+struct LoopbackStack::loopback_socket {
+    loopback_socket *next;
+    nsapi_protocol_t proto;
+    nsapi_addr_t addr;
+    uint16_t port;
+    bool bound;
+
+    // TCP listener, connections wait here until accepted
+    bool listening;
+    int backlog;
+    int pending_count;
+    loopback_socket *pending;
+    loopback_socket *pending_tail;
+
+    // TCP connection, data sent by the peer waits in the ring buffer
+    bool connected;
+    loopback_socket *peer;
+    uint16_t peer_port;
+    uint8_t *buffer;
+    nsapi_size_t head;
+    nsapi_size_t length;
+
+    // UDP packets waiting to be received
+    packet *packets;
+    packet *packets_tail;
+    unsigned packet_count;
+
+    void (*callback)(void *);
+    void *data;
+};
+
+
+static nsapi_addr_t loopback_addr(nsapi_version_t version)
+{
+    nsapi_addr_t addr = nsapi_addr_t();
+    if (version == NSAPI_IPv6) {
+        addr.version = NSAPI_IPv6;
+        addr.bytes[NSAPI_IPv6_BYTES-1] = 1;
+    } else {
+        addr.version = NSAPI_IPv4;
+        addr.bytes[0] = 127;
+        addr.bytes[3] = 1;
+    }
+
+    return addr;
+}
+
+LoopbackStack::LoopbackStack(nsapi_size_t buffer_size, unsigned queue_size)
+    : _buffer_size(buffer_size), _queue_size(queue_size), _sockets(0)
+    , _next_port(LOOPBACK_EPHEMERAL_MIN)
+{
+}
+
+LoopbackStack::~LoopbackStack()
+{
+    while (_sockets) {
+        loopback_socket *s = _sockets;
+        _sockets = s->next;
+        destroy(s);
+    }
+}
+
+const char *LoopbackStack::get_ip_address()
+{
+    return "127.0.0.1";
+}
+
+LoopbackStack::loopback_socket *LoopbackStack::find(nsapi_protocol_t proto, uint16_t port)
+{
+    for (loopback_socket *s = _sockets; s; s = s->next) {
+        if (s->proto == proto && s->bound && s->port == port) {
+            return s;
+        }
+    }
+
+    return 0;
+}
+
+nsapi_error_t LoopbackStack::bind_ephemeral(loopback_socket *s)
+{
+    for (int i = LOOPBACK_EPHEMERAL_MIN; i <= LOOPBACK_EPHEMERAL_MAX; i++) {
+        uint16_t port = _next_port;
+        _next_port = (port == LOOPBACK_EPHEMERAL_MAX) ? LOOPBACK_EPHEMERAL_MIN : port + 1;
+
+        if (!find(s->proto, port)) {
+            s->port = port;
+            s->bound = true;
+            return NSAPI_ERROR_OK;
+        }
+    }
+
+    return NSAPI_ERROR_NO_SOCKET;
+}
+
+void LoopbackStack::signal(loopback_socket *s)
+{
+    // Called with the stack locked so the socket can not be closed under us
+    if (s->callback) {
+        s->callback(s->data);
+    }
+}
+
+void LoopbackStack::hangup(loopback_socket *s)
+{
+    if (s->peer) {
+        s->peer->peer = 0;
+        signal(s->peer);
+        s->peer = 0;
+    }
+}
+
+void LoopbackStack::destroy(loopback_socket *s)
+{
+    hangup(s);
+
+    // Refuse the connections that were never accepted
+    while (s->pending) {
+        loopback_socket *p = s->pending;
+        s->pending = p->next;
+        destroy(p);
+    }
+
+    while (s->packets) {
+        packet *p = s->packets;
+        s->packets = p->next;
+        free(p);
+    }
+
+    free(s->buffer);
+    delete s;
+}
+
+nsapi_error_t LoopbackStack::socket_open(nsapi_socket_t *handle, nsapi_protocol_t proto)
+{
+    if (proto != NSAPI_TCP && proto != NSAPI_UDP) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+    loopback_socket *s = new (std::nothrow) loopback_socket();
+    if (!s) {
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+
+    s->proto = proto;
+
+    _mutex.lock();
+    s->next = _sockets;
+    _sockets = s;
+    _mutex.unlock();
+
+    *handle = s;
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_error_t LoopbackStack::socket_close(nsapi_socket_t handle)
+{
+    loopback_socket *s = (loopback_socket *)handle;
+
+    _mutex.lock();
+    for (loopback_socket **p = &_sockets; *p; p = &(*p)->next) {
+        if (*p == s) {
+            *p = s->next;
+            break;
+        }
+    }
+
+    destroy(s);
+    _mutex.unlock();
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_error_t LoopbackStack::socket_bind(nsapi_socket_t handle, const SocketAddress &address)
+{
+    loopback_socket *s = (loopback_socket *)handle;
+    nsapi_error_t err = NSAPI_ERROR_OK;
+
+    _mutex.lock();
+    if (s->bound || s->connected) {
+        err = NSAPI_ERROR_PARAMETER;
+    } else if (address.get_port() == 0) {
+        err = bind_ephemeral(s);
+    } else if (find(s->proto, address.get_port())) {
+        err = NSAPI_ERROR_PARAMETER;
+    } else {
+        s->port = address.get_port();
+        s->bound = true;
+    }
+
+    if (!err) {
+        s->addr = address.get_addr();
+    }
+    _mutex.unlock();
+    return err;
+}
+
+nsapi_error_t LoopbackStack::socket_listen(nsapi_socket_t handle, int backlog)
+{
+    loopback_socket *s = (loopback_socket *)handle;
+    nsapi_error_t err = NSAPI_ERROR_OK;
+
+    _mutex.lock();
+    if (s->proto != NSAPI_TCP) {
+        err = NSAPI_ERROR_UNSUPPORTED;
+    } else if (s->connected) {
+        err = NSAPI_ERROR_PARAMETER;
+    } else if (!s->bound) {
+        err = bind_ephemeral(s);
+    }
+
+    if (!err) {
+        s->listening = true;
+        s->backlog = (backlog > 0) ? backlog : 1;
+    }
+    _mutex.unlock();
+    return err;
+}
+
+nsapi_error_t LoopbackStack::socket_connect(nsapi_socket_t handle, const SocketAddress &address)
+{
+    loopback_socket *s = (loopback_socket *)handle;
+    nsapi_error_t err = NSAPI_ERROR_OK;
+
+    if (s->proto != NSAPI_TCP) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+    _mutex.lock();
+    loopback_socket *server = find(NSAPI_TCP, address.get_port());
+    loopback_socket *a = 0;
+
+    if (s->connected) {
+        err = NSAPI_ERROR_IS_CONNECTED;
+    } else if (s->listening) {
+        err = NSAPI_ERROR_PARAMETER;
+    } else if (!server || !server->listening || server->pending_count >= server->backlog) {
+        // Nobody to answer, the connection is reset
+        err = NSAPI_ERROR_NO_CONNECTION;
+    } else if (!s->bound) {
+        err = bind_ephemeral(s);
+    }
+
+    if (!err) {
+        a = new (std::nothrow) loopback_socket();
+        if (a) {
+            a->buffer = (uint8_t *)malloc(_buffer_size);
+        }
+        if (!s->buffer) {
+            s->buffer = (uint8_t *)malloc(_buffer_size);
+        }
+
+        if (!a || !a->buffer || !s->buffer) {
+            if (a) {
+                destroy(a);
+            }
+            err = NSAPI_ERROR_NO_MEMORY;
+        }
+    }
+
+    if (!err) {
+        // The connection completes at once, the server side waits to be accepted
+        a->proto = NSAPI_TCP;
+        a->addr = address.get_addr();
+        a->port = server->port;
+        a->connected = true;
+        a->peer = s;
+        a->peer_port = s->port;
+
+        s->connected = true;
+        s->peer = a;
+        s->peer_port = server->port;
+
+        if (server->pending_tail) {
+            server->pending_tail->next = a;
+        } else {
+            server->pending = a;
+        }
+        server->pending_tail = a;
+        server->pending_count += 1;
+
+        signal(server);
+        signal(s);
+    }
+    _mutex.unlock();
+    return err;
+}
+
+nsapi_error_t LoopbackStack::socket_accept(nsapi_socket_t server, nsapi_socket_t *handle, SocketAddress *address)
+{
+    loopback_socket *s = (loopback_socket *)server;
+    nsapi_error_t err = NSAPI_ERROR_OK;
+
+    _mutex.lock();
+    loopback_socket *a = s->pending;
+    if (!s->listening) {
+        err = NSAPI_ERROR_PARAMETER;
+    } else if (!a) {
+        err = NSAPI_ERROR_WOULD_BLOCK;
+    } else {
+        s->pending = a->next;
+        if (!s->pending) {
+            s->pending_tail = 0;
+        }
+        s->pending_count -= 1;
+
+        a->next = _sockets;
+        _sockets = a;
+
+        *handle = a;
+        if (address) {
+            address->set_addr(loopback_addr(a->addr.version));
+            address->set_port(a->peer_port);
+        }
+    }
+    _mutex.unlock();
+    return err;
+}
+
+nsapi_size_or_error_t LoopbackStack::socket_send(nsapi_socket_t handle, const void *data, nsapi_size_t size)
+{
+    loopback_socket *s = (loopback_socket *)handle;
+    nsapi_size_or_error_t ret;
+
+    _mutex.lock();
+    loopback_socket *peer = s->peer;
+    if (!peer) {
+        ret = NSAPI_ERROR_NO_CONNECTION;
+    } else if (size == 0) {
+        ret = 0;
+    } else if (peer->length == _buffer_size) {
+        ret = NSAPI_ERROR_WOULD_BLOCK;
+    } else {
+        nsapi_size_t count = _buffer_size - peer->length;
+        if (count > size) {
+            count = size;
+        }
+
+        // Copy into the peer's ring buffer, wrapping at most once
+        nsapi_size_t tail = (peer->head + peer->length) % _buffer_size;
+        nsapi_size_t first = _buffer_size - tail;
+        if (first > count) {
+            first = count;
+        }
+        memcpy(&peer->buffer[tail], data, first);
+        memcpy(&peer->buffer[0], (const uint8_t *)data + first, count - first);
+        peer->length += count;
+
+        signal(peer);
+        ret = count;
+    }
+    _mutex.unlock();
+    return ret;
+}
+
+nsapi_size_or_error_t LoopbackStack::socket_recv(nsapi_socket_t handle, void *data, nsapi_size_t size)
+{
+    loopback_socket *s = (loopback_socket *)handle;
+    nsapi_size_or_error_t ret;
+
+    _mutex.lock();
+    if (!s->connected) {
+        ret = NSAPI_ERROR_NO_CONNECTION;
+    } else if (s->length == 0) {
+        // Once the peer has closed and the data is drained, report the end
+        ret = s->peer ? NSAPI_ERROR_WOULD_BLOCK : 0;
+    } else {
+        nsapi_size_t count = (s->length < size) ? s->length : size;
+
+        nsapi_size_t first = _buffer_size - s->head;
+        if (first > count) {
+            first = count;
+        }
+        memcpy(data, &s->buffer[s->head], first);
+        memcpy((uint8_t *)data + first, &s->buffer[0], count - first);
+        s->head = (s->head + count) % _buffer_size;
+        s->length -= count;
+
+        if (s->peer) {
+            signal(s->peer);
+        }
+        ret = count;
+    }
+    _mutex.unlock();
+    return ret;
+}
+
+nsapi_size_or_error_t LoopbackStack::sendto(loopback_socket *s, nsapi_addr_t addr, uint16_t port, const void *data, nsapi_size_t size)
+{
+    if (s->proto != NSAPI_UDP) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+    if (!s->bound) {
+        nsapi_error_t err = bind_ephemeral(s);
+        if (err) {
+            return err;
+        }
+    }
+
+    // Like any other UDP stack, drop the packet if nobody can take it
+    loopback_socket *dest = find(NSAPI_UDP, port);
+    if (!dest || dest->packet_count >= _queue_size) {
+        return size;
+    }
+
+    packet *p = (packet *)malloc(sizeof(packet) + size);
+    if (!p) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    bool any = (s->addr.version == NSAPI_UNSPEC);
+    for (int i = 0; any && i < NSAPI_IP_BYTES; i++) {
+        any = !s->addr.bytes[i];
+    }
+
+    p->next = 0;
+    p->addr = any ? loopback_addr(addr.version) : s->addr;
+    p->port = s->port;
+    p->size = size;
+    memcpy(p + 1, data, size);
+
+    if (dest->packets_tail) {
+        dest->packets_tail->next = p;
+    } else {
+        dest->packets = p;
+    }
+    dest->packets_tail = p;
+    dest->packet_count += 1;
+
+    signal(dest);
+    return size;
+}
+
+nsapi_size_or_error_t LoopbackStack::recvfrom(loopback_socket *s, nsapi_addr_t *addr, uint16_t *port, void *data, nsapi_size_t size)
+{
+    if (s->proto != NSAPI_UDP) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+    packet *p = s->packets;
+    if (!p) {
+        return NSAPI_ERROR_WOULD_BLOCK;
+    }
+
+    s->packets = p->next;
+    if (!s->packets) {
+        s->packets_tail = 0;
+    }
+    s->packet_count -= 1;
+
+    // The rest of a packet that does not fit is discarded
+    nsapi_size_t count = (p->size < size) ? p->size : size;
+    memcpy(data, p + 1, count);
+    *addr = p->addr;
+    *port = p->port;
+    free(p);
+
+    return count;
+}
+
+nsapi_size_or_error_t LoopbackStack::socket_sendto(nsapi_socket_t handle, const SocketAddress &address, const void *data, nsapi_size_t size)
+{
+    _mutex.lock();
+    nsapi_size_or_error_t ret = sendto((loopback_socket *)handle,
+            address.get_addr(), address.get_port(), data, size);
+    _mutex.unlock();
+    return ret;
+}
+
+nsapi_size_or_error_t LoopbackStack::socket_recvfrom(nsapi_socket_t handle, SocketAddress *address, void *buffer, nsapi_size_t size)
+{
+    nsapi_addr_t addr;
+    uint16_t port;
+
+    _mutex.lock();
+    nsapi_size_or_error_t ret = recvfrom((loopback_socket *)handle, &addr, &port, buffer, size);
+    _mutex.unlock();
+
+    if (ret >= 0 && address) {
+        address->set_addr(addr);
+        address->set_port(port);
+    }
+    return ret;
+}
+
+nsapi_size_or_error_t LoopbackStack::socket_sendto_batch(nsapi_socket_t handle, const nsapi_datagram_t *datagrams, unsigned count)
+{
+    nsapi_size_or_error_t ret = 0;
+    unsigned i;
+
+    _mutex.lock();
+    for (i = 0; i < count; i++) {
+        ret = sendto((loopback_socket *)handle, datagrams[i].addr,
+                datagrams[i].port, datagrams[i].data, datagrams[i].size);
+        if (ret < 0) {
+            break;
+        }
+    }
+    _mutex.unlock();
+
+    return (i || ret >= 0) ? (nsapi_size_or_error_t)i : ret;
+}
+
+nsapi_size_or_error_t LoopbackStack::socket_recvfrom_batch(nsapi_socket_t handle, nsapi_datagram_t *datagrams, unsigned count)
+{
+    nsapi_size_or_error_t ret = 0;
+    unsigned i;
+
+    _mutex.lock();
+    for (i = 0; i < count; i++) {
+        ret = recvfrom((loopback_socket *)handle, &datagrams[i].addr,
+                &datagrams[i].port, datagrams[i].data, datagrams[i].size);
+        if (ret < 0) {
+            break;
+        }
+
+        datagrams[i].length = ret;
+    }
+    _mutex.unlock();
+
+    return (i || ret >= 0) ? (nsapi_size_or_error_t)i : ret;
+}
+
+void LoopbackStack::socket_attach(nsapi_socket_t handle, void (*callback)(void *), void *data)
+{
+    loopback_socket *s = (loopback_socket *)handle;
+
+    _mutex.lock();
+    s->callback = callback;
+    s->data = data;
+    _mutex.unlock();
+}
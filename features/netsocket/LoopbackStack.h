@@ -0,0 +1,129 @@
+/* LoopbackStack
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LOOPBACK_STACK_H
+#define LOOPBACK_STACK_H
+
+#include "netsocket/NetworkStack.h"
+#include "rtos/Mutex.h"
+#include "platform/NonCopyable.h"
+
+#ifndef MBED_CONF_NSAPI_LOOPBACK_BUFFER_SIZE
+#define MBED_CONF_NSAPI_LOOPBACK_BUFFER_SIZE 2048
+#endif
+
+#ifndef MBED_CONF_NSAPI_LOOPBACK_QUEUE_SIZE
+#define MBED_CONF_NSAPI_LOOPBACK_QUEUE_SIZE 16
+#endif
+
+
+/** LoopbackStack class
+ *
+ *  In-memory network stack where every address is the local host.
+ *  TCP connections are pairs of byte buffers and UDP packets are queued
+ *  directly on the socket bound to the destination port, so sockets on
+ *  the stack can only talk to each other.
+ *
+ *  The stack needs no hardware or network, which makes it useful for
+ *  measuring the cost of the socket layer itself and for testing
+ *  applications off target.
+ *
+ *  Example:
+ *  @code
+ *  LoopbackStack loopback;
+ *  NetworkStack *stack = &loopback;
+ *
+ *  TCPServer server(stack);
+ *  server.bind(7);
+ *  server.listen(1);
+ *
+ *  TCPSocket client(stack);
+ *  client.connect("127.0.0.1", 7);
+ *  @endcode
+ *  @addtogroup netsocket
+ */
+class LoopbackStack : public NetworkStack, private mbed::NonCopyable<LoopbackStack>
+{
+public:
+    /** Create a loopback stack
+     *
+     *  @param buffer_size  Size of the buffer in each direction of a TCP
+     *                      connection in bytes
+     *  @param queue_size   Number of packets that can wait on a UDP socket
+     *                      before more packets to it are dropped
+     */
+    LoopbackStack(nsapi_size_t buffer_size = MBED_CONF_NSAPI_LOOPBACK_BUFFER_SIZE,
+                  unsigned queue_size = MBED_CONF_NSAPI_LOOPBACK_QUEUE_SIZE);
+
+    /** Destroy the loopback stack
+     *
+     *  All sockets on the stack must be closed first.
+     */
+    virtual ~LoopbackStack();
+
+    /** Get the local IP address
+     *
+     *  @return         Null-terminated representation of the local IP address
+     */
+    virtual const char *get_ip_address();
+
+protected:
+    virtual nsapi_error_t socket_open(nsapi_socket_t *handle, nsapi_protocol_t proto);
+    virtual nsapi_error_t socket_close(nsapi_socket_t handle);
+    virtual nsapi_error_t socket_bind(nsapi_socket_t handle, const SocketAddress &address);
+    virtual nsapi_error_t socket_listen(nsapi_socket_t handle, int backlog);
+    virtual nsapi_error_t socket_connect(nsapi_socket_t handle, const SocketAddress &address);
+    virtual nsapi_error_t socket_accept(nsapi_socket_t server,
+            nsapi_socket_t *handle, SocketAddress *address=0);
+    virtual nsapi_size_or_error_t socket_send(nsapi_socket_t handle,
+            const void *data, nsapi_size_t size);
+    virtual nsapi_size_or_error_t socket_recv(nsapi_socket_t handle,
+            void *data, nsapi_size_t size);
+    virtual nsapi_size_or_error_t socket_sendto(nsapi_socket_t handle, const SocketAddress &address,
+            const void *data, nsapi_size_t size);
+    virtual nsapi_size_or_error_t socket_recvfrom(nsapi_socket_t handle, SocketAddress *address,
+            void *buffer, nsapi_size_t size);
+    virtual nsapi_size_or_error_t socket_sendto_batch(nsapi_socket_t handle,
+            const nsapi_datagram_t *datagrams, unsigned count);
+    virtual nsapi_size_or_error_t socket_recvfrom_batch(nsapi_socket_t handle,
+            nsapi_datagram_t *datagrams, unsigned count);
+    virtual void socket_attach(nsapi_socket_t handle, void (*callback)(void *), void *data);
+
+private:
+    struct packet;
+    struct loopback_socket;
+
+    loopback_socket *find(nsapi_protocol_t proto, uint16_t port);
+    nsapi_error_t bind_ephemeral(loopback_socket *s);
+    nsapi_size_or_error_t sendto(loopback_socket *s, nsapi_addr_t addr,
+            uint16_t port, const void *data, nsapi_size_t size);
+    nsapi_size_or_error_t recvfrom(loopback_socket *s, nsapi_addr_t *addr,
+            uint16_t *port, void *data, nsapi_size_t size);
+    static void signal(loopback_socket *s);
+    static void hangup(loopback_socket *s);
+    static void destroy(loopback_socket *s);
+
+    nsapi_size_t _buffer_size;
+    unsigned _queue_size;
+    loopback_socket *_sockets;
+    uint16_t _next_port;
+    rtos::Mutex _mutex;
+};
+
+
+#endif
+
+/** @}*/
@@ -70,6 +70,191 @@ nsapi_error_t NetworkStack::getsockopt(void *handle, int level, int optname, voi
     return NSAPI_ERROR_UNSUPPORTED;
 }
 
+#ifndef MBED_CONF_NSAPI_LOAN_BUFFER_SIZE
+#define MBED_CONF_NSAPI_LOAN_BUFFER_SIZE 1024
+#endif
+
+// Stacks that can only copy lend a heap buffer holding a single segment
+static nsapi_size_or_error_t nsapi_lend_copy(void *buffer, nsapi_size_or_error_t size, nsapi_loan_t *loan)
+{
+    if (size < 0) {
+        free(buffer);
+        return size;
+    }
+
+    loan->segments[0].iov_base = buffer;
+    loan->segments[0].iov_len = size;
+    loan->count = 1;
+    loan->size = size;
+    loan->handle = buffer;
+    return size;
+}
+
+nsapi_size_or_error_t NetworkStack::socket_recv_loan(nsapi_socket_t handle, nsapi_loan_t *loan)
+{
+    void *buffer = malloc(MBED_CONF_NSAPI_LOAN_BUFFER_SIZE);
+    if (!buffer) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    return nsapi_lend_copy(buffer,
+            socket_recv(handle, buffer, MBED_CONF_NSAPI_LOAN_BUFFER_SIZE), loan);
+}
+
+nsapi_size_or_error_t NetworkStack::socket_recvfrom_loan(nsapi_socket_t handle, SocketAddress *address, nsapi_loan_t *loan)
+{
+    void *buffer = malloc(MBED_CONF_NSAPI_LOAN_BUFFER_SIZE);
+    if (!buffer) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    return nsapi_lend_copy(buffer,
+            socket_recvfrom(handle, address, buffer, MBED_CONF_NSAPI_LOAN_BUFFER_SIZE), loan);
+}
+
+void NetworkStack::socket_release(nsapi_loan_t *loan)
+{
+    free(loan->handle);
+    loan->handle = 0;
+}
+
+static nsapi_size_t nsapi_iov_size(const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    nsapi_size_t size = 0;
+    for (unsigned i = 0; i < iovcnt; i++) {
+        size += iov[i].iov_len;
+    }
+
+    return size;
+}
+
+nsapi_size_or_error_t NetworkStack::socket_sendmsg(nsapi_socket_t handle, const SocketAddress *address, const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    if (address) {
+        // Packets must be sent whole, so gather into a temporary buffer
+        if (iovcnt == 1) {
+            return socket_sendto(handle, *address, iov[0].iov_base, iov[0].iov_len);
+        }
+
+        nsapi_size_t size = nsapi_iov_size(iov, iovcnt);
+        uint8_t *buffer = (uint8_t *)malloc(size ? size : 1);
+        if (!buffer) {
+            return NSAPI_ERROR_NO_MEMORY;
+        }
+
+        nsapi_size_t off = 0;
+        for (unsigned i = 0; i < iovcnt; i++) {
+            memcpy(&buffer[off], iov[i].iov_base, iov[i].iov_len);
+            off += iov[i].iov_len;
+        }
+
+        nsapi_size_or_error_t ret = socket_sendto(handle, *address, buffer, size);
+        free(buffer);
+        return ret;
+    }
+
+    // Streams can be sent one buffer at a time
+    nsapi_size_t sent = 0;
+    for (unsigned i = 0; i < iovcnt; i++) {
+        if (!iov[i].iov_len) {
+            continue;
+        }
+
+        nsapi_size_or_error_t ret = socket_send(handle, iov[i].iov_base, iov[i].iov_len);
+        if (ret < 0) {
+            return sent ? sent : ret;
+        }
+
+        sent += ret;
+        if ((nsapi_size_t)ret < iov[i].iov_len) {
+            break;
+        }
+    }
+
+    return sent;
+}
+
+nsapi_size_or_error_t NetworkStack::socket_recvmsg(nsapi_socket_t handle, SocketAddress *address, const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    if (address) {
+        // Packets must be received whole, so scatter from a temporary buffer
+        if (iovcnt == 1) {
+            return socket_recvfrom(handle, address, iov[0].iov_base, iov[0].iov_len);
+        }
+
+        nsapi_size_t size = nsapi_iov_size(iov, iovcnt);
+        uint8_t *buffer = (uint8_t *)malloc(size ? size : 1);
+        if (!buffer) {
+            return NSAPI_ERROR_NO_MEMORY;
+        }
+
+        nsapi_size_or_error_t ret = socket_recvfrom(handle, address, buffer, size);
+        nsapi_size_t off = 0;
+        for (unsigned i = 0; i < iovcnt && ret > 0 && off < (nsapi_size_t)ret; i++) {
+            nsapi_size_t chunk = ret - off;
+            if (chunk > iov[i].iov_len) {
+                chunk = iov[i].iov_len;
+            }
+
+            memcpy(iov[i].iov_base, &buffer[off], chunk);
+            off += chunk;
+        }
+
+        free(buffer);
+        return ret;
+    }
+
+    // Streams can be received one buffer at a time
+    nsapi_size_t recv = 0;
+    for (unsigned i = 0; i < iovcnt; i++) {
+        if (!iov[i].iov_len) {
+            continue;
+        }
+
+        nsapi_size_or_error_t ret = socket_recv(handle, iov[i].iov_base, iov[i].iov_len);
+        if (ret < 0) {
+            return recv ? recv : ret;
+        }
+
+        recv += ret;
+        if ((nsapi_size_t)ret < iov[i].iov_len) {
+            break;
+        }
+    }
+
+    return recv;
+}
+
+nsapi_size_or_error_t NetworkStack::socket_sendto_batch(nsapi_socket_t handle, const nsapi_datagram_t *datagrams, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++) {
+        SocketAddress address(datagrams[i].addr, datagrams[i].port);
+        nsapi_size_or_error_t ret = socket_sendto(handle, address, datagrams[i].data, datagrams[i].size);
+        if (ret < 0) {
+            return i ? (nsapi_size_or_error_t)i : ret;
+        }
+    }
+
+    return count;
+}
+
+nsapi_size_or_error_t NetworkStack::socket_recvfrom_batch(nsapi_socket_t handle, nsapi_datagram_t *datagrams, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++) {
+        SocketAddress address;
+        nsapi_size_or_error_t ret = socket_recvfrom(handle, &address, datagrams[i].data, datagrams[i].size);
+        if (ret < 0) {
+            return i ? (nsapi_size_or_error_t)i : ret;
+        }
+
+        datagrams[i].addr = address.get_addr();
+        datagrams[i].port = address.get_port();
+        datagrams[i].length = ret;
+    }
+
+    return count;
+}
+
 
 // NetworkStackWrapper class for encapsulating the raw nsapi_stack structure
 class NetworkStackWrapper : public NetworkStack
@@ -275,6 +460,106 @@ protected:
 
         return _stack_api()->getsockopt(_stack(), socket, level, optname, optval, optlen);
     }
+
+    // Loans are only taken from the stack if it can also release them,
+    // otherwise they are emulated by copying
+    virtual nsapi_size_or_error_t socket_recv_loan(nsapi_socket_t socket, nsapi_loan_t *loan)
+    {
+        if (!_stack_api()->socket_release) {
+            return NetworkStack::socket_recv_loan(socket, loan);
+        }
+
+        if (!_stack_api()->socket_recv_loan) {
+            return NSAPI_ERROR_UNSUPPORTED;
+        }
+
+        return _stack_api()->socket_recv_loan(_stack(), socket, loan);
+    }
+
+    virtual nsapi_size_or_error_t socket_recvfrom_loan(nsapi_socket_t socket, SocketAddress *address, nsapi_loan_t *loan)
+    {
+        if (!_stack_api()->socket_release) {
+            return NetworkStack::socket_recvfrom_loan(socket, address, loan);
+        }
+
+        if (!_stack_api()->socket_recvfrom_loan) {
+            return NSAPI_ERROR_UNSUPPORTED;
+        }
+
+        nsapi_addr_t addr = {NSAPI_IPv4, 0};
+        uint16_t port = 0;
+
+        nsapi_size_or_error_t err = _stack_api()->socket_recvfrom_loan(_stack(), socket, &addr, &port, loan);
+
+        if (address) {
+            address->set_addr(addr);
+            address->set_port(port);
+        }
+
+        return err;
+    }
+
+    virtual void socket_release(nsapi_loan_t *loan)
+    {
+        if (!_stack_api()->socket_release) {
+            return NetworkStack::socket_release(loan);
+        }
+
+        return _stack_api()->socket_release(_stack(), loan);
+    }
+
+    virtual nsapi_size_or_error_t socket_sendmsg(nsapi_socket_t socket, const SocketAddress *address, const nsapi_iovec_t *iov, unsigned iovcnt)
+    {
+        if (!_stack_api()->socket_sendmsg) {
+            return NetworkStack::socket_sendmsg(socket, address, iov, iovcnt);
+        }
+
+        if (!address) {
+            return _stack_api()->socket_sendmsg(_stack(), socket, NULL, 0, iov, iovcnt);
+        }
+
+        nsapi_addr_t addr = address->get_addr();
+        return _stack_api()->socket_sendmsg(_stack(), socket, &addr, address->get_port(), iov, iovcnt);
+    }
+
+    virtual nsapi_size_or_error_t socket_recvmsg(nsapi_socket_t socket, SocketAddress *address, const nsapi_iovec_t *iov, unsigned iovcnt)
+    {
+        if (!_stack_api()->socket_recvmsg) {
+            return NetworkStack::socket_recvmsg(socket, address, iov, iovcnt);
+        }
+
+        if (!address) {
+            return _stack_api()->socket_recvmsg(_stack(), socket, NULL, NULL, iov, iovcnt);
+        }
+
+        nsapi_addr_t addr = {NSAPI_IPv4, 0};
+        uint16_t port = 0;
+
+        nsapi_size_or_error_t err = _stack_api()->socket_recvmsg(_stack(), socket, &addr, &port, iov, iovcnt);
+
+        address->set_addr(addr);
+        address->set_port(port);
+
+        return err;
+    }
+
+    virtual nsapi_size_or_error_t socket_sendto_batch(nsapi_socket_t socket, const nsapi_datagram_t *datagrams, unsigned count)
+    {
+        if (!_stack_api()->socket_sendto_batch) {
+            return NetworkStack::socket_sendto_batch(socket, datagrams, count);
+        }
+
+        return _stack_api()->socket_sendto_batch(_stack(), socket, datagrams, count);
+    }
+
+    virtual nsapi_size_or_error_t socket_recvfrom_batch(nsapi_socket_t socket, nsapi_datagram_t *datagrams, unsigned count)
+    {
+        if (!_stack_api()->socket_recvfrom_batch) {
+            return NetworkStack::socket_recvfrom_batch(socket, datagrams, count);
+        }
+
+        return _stack_api()->socket_recvfrom_batch(_stack(), socket, datagrams, count);
+    }
 };
 
 
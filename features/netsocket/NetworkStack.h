@@ -299,6 +299,144 @@ protected:
      */
     virtual nsapi_error_t getsockopt(nsapi_socket_t handle, int level,
             int optname, void *optval, unsigned *optlen);
+
+    /** Lend received data over a TCP socket
+     *
+     *  Fills the loan with segments of received data and returns the
+     *  number of bytes lent. The lent data is consumed from the socket and
+     *  must be returned with socket_release.
+     *
+     *  This call is non-blocking. If recv would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  By default, data is copied into a heap buffer with socket_recv.
+     *  Stacks that can lend their own buffers should override both this
+     *  and socket_release.
+     *
+     *  @param handle   Socket handle
+     *  @param loan     Destination for the lent data
+     *  @return         Number of lent bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_recv_loan(nsapi_socket_t handle,
+            nsapi_loan_t *loan);
+
+    /** Lend a received packet over a UDP socket
+     *
+     *  Fills the loan with segments of a received packet and stores the
+     *  source address in address if address is not NULL. Returns the number
+     *  of bytes lent. The loan must be returned with socket_release.
+     *
+     *  This call is non-blocking. If recvfrom would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  By default, data is copied into a heap buffer with socket_recvfrom.
+     *
+     *  @param handle   Socket handle
+     *  @param address  Destination for the source address or NULL
+     *  @param loan     Destination for the lent data
+     *  @return         Number of lent bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_recvfrom_loan(nsapi_socket_t handle,
+            SocketAddress *address, nsapi_loan_t *loan);
+
+    /** Return a loan to the stack
+     *
+     *  @param loan     Loan returned by socket_recv_loan or
+     *                  socket_recvfrom_loan
+     */
+    virtual void socket_release(nsapi_loan_t *loan);
+
+    /** Send data gathered from multiple buffers
+     *
+     *  If address is NULL, the data is sent over a connected TCP socket as
+     *  if by socket_send. Otherwise the buffers are sent as a single UDP
+     *  packet to the address as if by socket_sendto. Returns the number of
+     *  bytes sent from the buffers.
+     *
+     *  This call is non-blocking. If sendmsg would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  By default, TCP buffers are passed to socket_send one at a time and
+     *  UDP buffers are copied into a temporary buffer for socket_sendto.
+     *
+     *  @param handle   Socket handle
+     *  @param address  The SocketAddress of the remote host or NULL
+     *  @param iov      Array of buffers to send
+     *  @param iovcnt   Number of buffers in the array
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_sendmsg(nsapi_socket_t handle, const SocketAddress *address,
+            const nsapi_iovec_t *iov, unsigned iovcnt);
+
+    /** Receive data scattered into multiple buffers
+     *
+     *  If address is NULL, data is received over a connected TCP socket as
+     *  if by socket_recv. Otherwise a single UDP packet is received as if by
+     *  socket_recvfrom and its source is stored in address. Returns the
+     *  number of bytes received into the buffers.
+     *
+     *  This call is non-blocking. If recvmsg would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  By default, TCP buffers are filled by socket_recv one at a time and
+     *  UDP packets are received into a temporary buffer with
+     *  socket_recvfrom.
+     *
+     *  @param handle   Socket handle
+     *  @param address  Destination for the source address or NULL
+     *  @param iov      Array of buffers to receive into
+     *  @param iovcnt   Number of buffers in the array
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_recvmsg(nsapi_socket_t handle, SocketAddress *address,
+            const nsapi_iovec_t *iov, unsigned iovcnt);
+
+    /** Send a batch of UDP packets
+     *
+     *  Sends each packet to its own address as if by socket_sendto, in
+     *  order, stopping at the first packet that fails. Returns the number
+     *  of packets sent.
+     *
+     *  This call is non-blocking. If no packet can be sent without
+     *  blocking, NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  By default, the packets are sent one at a time with socket_sendto.
+     *  Stacks should override this to send the whole batch with a single
+     *  crossing into the stack.
+     *
+     *  @param handle       Socket handle
+     *  @param datagrams    Array of packets to send
+     *  @param count        Number of packets in the array
+     *  @return             Number of packets sent on success, negative
+     *                      error code if no packet could be sent
+     */
+    virtual nsapi_size_or_error_t socket_sendto_batch(nsapi_socket_t handle,
+            const nsapi_datagram_t *datagrams, unsigned count);
+
+    /** Receive a batch of UDP packets
+     *
+     *  Receives the packets that are already waiting, up to count, as if
+     *  by socket_recvfrom. The length, address and port of each packet
+     *  are stored in its datagram. Returns the number of packets received.
+     *
+     *  This call is non-blocking. If no packet is waiting,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  By default, the packets are received one at a time with
+     *  socket_recvfrom.
+     *
+     *  @param handle       Socket handle
+     *  @param datagrams    Array of buffers to receive packets into
+     *  @param count        Number of buffers in the array
+     *  @return             Number of packets received on success, negative
+     *                      error code if no packet was received
+     */
+    virtual nsapi_size_or_error_t socket_recvfrom_batch(nsapi_socket_t handle,
+            nsapi_datagram_t *datagrams, unsigned count);
 };
 
 
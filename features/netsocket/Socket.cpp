@@ -21,6 +21,8 @@ Socket::Socket()
     : _stack(0)
     , _socket(0)
     , _timeout(osWaitForever)
+    , _readable(true)
+    , _writable(true)
 {
 }
 
@@ -42,6 +44,8 @@ nsapi_error_t Socket::open(NetworkStack *stack)
     }
 
     _socket = socket;
+    _readable = true;
+    _writable = true;
     _event = callback(this, &Socket::event);
     _stack->socket_attach(_socket, Callback<void()>::thunk, &_event);
 
@@ -70,6 +74,17 @@ nsapi_error_t Socket::close()
     return ret;
 }
 
+void Socket::release(nsapi_loan_t *loan)
+{
+    // The lending stack is recorded in the loan since the
+    // socket may have been closed in the meantime
+    NetworkStack *stack = static_cast<NetworkStack *>(loan->_owner);
+    if (stack) {
+        stack->socket_release(loan);
+        loan->_owner = 0;
+    }
+}
+
 int Socket::modify_multicast_group(const SocketAddress &address, nsapi_socket_option_t socketopt)
 {
     nsapi_ip_mreq_t mreq;
@@ -178,6 +193,32 @@ void Socket::sigio(Callback<void()> callback)
     _lock.unlock();
 }
 
+short Socket::poll(short events) const
+{
+    if (!_socket) {
+        return POLLNVAL;
+    }
+
+    short revents = 0;
+    if (_readable) {
+        revents |= POLLIN;
+    }
+    if (_writable) {
+        revents |= POLLOUT;
+    }
+    return revents & events;
+}
+
+void Socket::attach_poll(mbed::PollListener *listener)
+{
+    _poll_listeners.attach(listener);
+}
+
+void Socket::detach_poll(mbed::PollListener *listener)
+{
+    _poll_listeners.detach(listener);
+}
+
 void Socket::attach(Callback<void()> callback)
 {
     sigio(callback);
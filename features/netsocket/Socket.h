@@ -24,6 +24,7 @@
 #include "netsocket/NetworkStack.h"
 #include "rtos/Mutex.h"
 #include "Callback.h"
+#include "platform/mbed_poll.h"
 #include "mbed_toolchain.h"
 
 
@@ -168,6 +169,17 @@ public:
      */    
     nsapi_error_t getsockopt(int level, int optname, void *optval, unsigned *optlen);
 
+    /** Return data lent by a receive loan
+     *
+     *  Every successful TCPSocket::recv_loan or UDPSocket::recvfrom_loan
+     *  must be matched by a call to release once the application is done
+     *  with the lent data. Loans may be released from any thread and after
+     *  the socket has been closed.
+     *
+     *  @param loan     Loan to return to the network stack
+     */
+    void release(nsapi_loan_t *loan);
+
     /** Register a callback on state change of the socket
      *
      *  The specified callback will be called on state changes such as when
@@ -186,6 +198,37 @@ public:
      */
     void sigio(mbed::Callback<void()> func);
 
+    /** Check for poll event flags
+     *
+     *  Reports POLLIN until a receive or accept operation would block, and
+     *  POLLOUT until a connect or send operation would block. Both are
+     *  reported again after the next state change signalled through sigio.
+     *  The report may be spurious, so sockets being polled should be used
+     *  in non-blocking mode.
+     *
+     *  @param events   Bitmask of poll events we're interested in
+     *  @return         Bitmask of poll events that may have occurred,
+     *                  POLLNVAL if the socket is not open
+     */
+    short poll(short events) const;
+
+    /** Attach a listener woken on state change of the socket
+     *
+     *  Used through SocketPollHandle by mbed::poll and mbed::Poller, which
+     *  leave the sigio callback to the owner of the socket. The listener is
+     *  woken wherever the sigio callback would be and may be called in an
+     *  interrupt context.
+     *
+     *  @param listener Listener to attach, must stay valid until detached
+     */
+    void attach_poll(mbed::PollListener *listener);
+
+    /** Detach a listener attached with attach_poll
+     *
+     *  @param listener Listener to detach
+     */
+    void detach_poll(mbed::PollListener *listener);
+
     /** Register a callback on state change of the socket
      *
      *  @see Socket::sigio
@@ -222,8 +265,11 @@ protected:
     NetworkStack *_stack;
     nsapi_socket_t _socket;
     uint32_t _timeout;
+    volatile bool _readable;
+    volatile bool _writable;
     mbed::Callback<void()> _event;
     mbed::Callback<void()> _callback;
+    mbed::PollListenerList _poll_listeners;
     rtos::Mutex _lock;
 };
 
@@ -0,0 +1,70 @@
+/* SocketPollHandle
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SocketPollHandle.h"
+#include "platform/mbed_retarget.h"
+
+SocketPollHandle::SocketPollHandle(Socket *socket)
+    : _socket(socket)
+{
+}
+
+Socket *SocketPollHandle::socket() const
+{
+    return _socket;
+}
+
+ssize_t SocketPollHandle::read(void *buffer, size_t size)
+{
+    return -EBADF;
+}
+
+ssize_t SocketPollHandle::write(const void *buffer, size_t size)
+{
+    return -EBADF;
+}
+
+off_t SocketPollHandle::seek(off_t offset, int whence)
+{
+    return -ESPIPE;
+}
+
+int SocketPollHandle::close()
+{
+    // The socket is closed through the socket itself
+    return 0;
+}
+
+short SocketPollHandle::poll(short events) const
+{
+    return _socket->poll(events);
+}
+
+void SocketPollHandle::sigio(mbed::Callback<void()> func)
+{
+    _socket->sigio(func);
+}
+
+bool SocketPollHandle::attach_poll(mbed::PollListener *listener)
+{
+    _socket->attach_poll(listener);
+    return true;
+}
+
+void SocketPollHandle::detach_poll(mbed::PollListener *listener)
+{
+    _socket->detach_poll(listener);
+}
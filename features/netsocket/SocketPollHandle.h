@@ -0,0 +1,72 @@
+/* SocketPollHandle
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOCKET_POLL_HANDLE_H
+#define SOCKET_POLL_HANDLE_H
+
+#include "netsocket/Socket.h"
+#include "platform/FileHandle.h"
+
+
+/** FileHandle view of a socket for mbed::poll and mbed::Poller
+ *
+ *  Forwards poll, sigio and poll listeners to the socket so sockets can
+ *  be waited on together with other file handles such as UARTSerial.
+ *  Waiting on the handle leaves the socket's sigio callback alone. Data
+ *  is still sent and received through the socket itself, read and write
+ *  on the handle fail with -EBADF.
+ *
+ *  Example:
+ *  @code
+ *  TCPSocket socket;
+ *  SocketPollHandle handle(&socket);
+ *  socket.set_blocking(false);
+ *
+ *  mbed::Poller poller;
+ *  poller.add(&handle, POLLIN);
+ *  @endcode
+ *
+ *  @addtogroup netsocket
+ */
+class SocketPollHandle : public mbed::FileHandle {
+public:
+    /** Create a handle for a socket
+     *
+     *  @param socket   Socket to watch, must outlive the handle
+     */
+    SocketPollHandle(Socket *socket);
+
+    /** Socket behind this handle
+     *
+     *  @return         Socket passed to the constructor
+     */
+    Socket *socket() const;
+
+    virtual ssize_t read(void *buffer, size_t size);
+    virtual ssize_t write(const void *buffer, size_t size);
+    virtual off_t seek(off_t offset, int whence = SEEK_SET);
+    virtual int close();
+    virtual short poll(short events) const;
+    virtual void sigio(mbed::Callback<void()> func);
+    virtual bool attach_poll(mbed::PollListener *listener);
+    virtual void detach_poll(mbed::PollListener *listener);
+
+private:
+    Socket *_socket;
+};
+
+
+#endif
@@ -59,8 +59,12 @@ nsapi_error_t TCPServer::accept(TCPSocket *connection, SocketAddress *address)
         } 
 
         _pending = 0;
+        _readable = false;
         void *socket;
         ret = _stack->socket_accept(_socket, &socket, address);
+        if (ret != NSAPI_ERROR_WOULD_BLOCK) {
+            _readable = true;
+        }
 
         if (0 == ret) {
             connection->_lock.lock();
@@ -71,6 +75,8 @@ nsapi_error_t TCPServer::accept(TCPSocket *connection, SocketAddress *address)
 
             connection->_stack = _stack;
             connection->_socket = socket;
+            connection->_readable = true;
+            connection->_writable = true;
             connection->_event = Callback<void()>(connection, &TCPSocket::event);
             _stack->socket_attach(socket, &Callback<void()>::thunk, &connection->_event);
 
@@ -101,11 +107,16 @@ nsapi_error_t TCPServer::accept(TCPSocket *connection, SocketAddress *address)
 
 void TCPServer::event()
 {
+    _readable = true;
+    _writable = true;
     int32_t acount = _accept_sem.wait(0);
     if (acount <= 1) {
         _accept_sem.release();
     }
 
+    // Wake any poll() or Poller waiting on the socket
+    _poll_listeners.wake();
+
     _pending += 1;
     if (_callback && _pending == 1) {
         _callback();
@@ -57,7 +57,11 @@ nsapi_error_t TCPSocket::connect(const SocketAddress &address)
         }
 
         _pending = 0;
+        _writable = false;
         ret = _stack->socket_connect(_socket, address);
+        if (ret != NSAPI_ERROR_IN_PROGRESS && ret != NSAPI_ERROR_ALREADY) {
+            _writable = true;
+        }
         if ((_timeout == 0) || !(ret == NSAPI_ERROR_IN_PROGRESS || ret == NSAPI_ERROR_ALREADY)) {
             break;
         } else {
@@ -125,12 +129,102 @@ nsapi_size_or_error_t TCPSocket::send(const void *data, nsapi_size_t size)
         }
 
         _pending = 0;
+        _writable = false;
         ret = _stack->socket_send(_socket, data_ptr + written, size - written);
+        if (ret != NSAPI_ERROR_WOULD_BLOCK) {
+            _writable = true;
+        }
+        if (ret >= 0) {
+            written += ret;
+            if (written >= size) {
+                break;
+            }
+        }
+        if (_timeout == 0) {
+            break;
+        } else if (ret == NSAPI_ERROR_WOULD_BLOCK) {
+            uint32_t flag;
+
+            // Release lock before blocking so other threads
+            // accessing this object aren't blocked
+            _lock.unlock();
+            flag = _event_flag.wait_any(WRITE_FLAG, _timeout);
+            _lock.lock();
+
+            if (flag & osFlagsError) {
+                // Timeout break
+                break;
+            }
+        } else if (ret < 0) {
+            break;
+        }
+    }
+
+    _write_in_progress = false;
+    _lock.unlock();
+    if (ret <= 0 && ret != NSAPI_ERROR_WOULD_BLOCK) {
+        return ret;
+    } else if (written == 0) {
+        return NSAPI_ERROR_WOULD_BLOCK;
+    } else {
+        return written;
+    }
+}
+
+nsapi_size_or_error_t TCPSocket::sendmsg(const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    _lock.lock();
+    nsapi_size_or_error_t ret;
+    nsapi_size_t written = 0;
+    nsapi_size_t size = 0;
+
+    for (unsigned i = 0; i < iovcnt; i++) {
+        size += iov[i].iov_len;
+    }
+
+    // If this assert is hit then there are two threads
+    // performing a send at the same time which is undefined
+    // behavior
+    MBED_ASSERT(!_write_in_progress);
+    _write_in_progress = true;
+
+    // Position in the buffers, a partially written buffer
+    // is resumed on its own before moving on to the rest
+    unsigned index = 0;
+    nsapi_size_t offset = 0;
+
+    while (true) {
+        if (!_socket) {
+            ret = NSAPI_ERROR_NO_SOCKET;
+            break;
+        }
+
+        _pending = 0;
+        _writable = false;
+        if (offset) {
+            nsapi_iovec_t rest = {
+                static_cast<uint8_t *>(iov[index].iov_base) + offset,
+                iov[index].iov_len - offset,
+            };
+            ret = _stack->socket_sendmsg(_socket, NULL, &rest, 1);
+        } else {
+            ret = _stack->socket_sendmsg(_socket, NULL, &iov[index], iovcnt - index);
+        }
+        if (ret != NSAPI_ERROR_WOULD_BLOCK) {
+            _writable = true;
+        }
+
         if (ret >= 0) {
             written += ret;
             if (written >= size) {
                 break;
             }
+
+            offset += ret;
+            while (index < iovcnt && offset >= iov[index].iov_len) {
+                offset -= iov[index].iov_len;
+                index += 1;
+            }
         }
         if (_timeout == 0) {
             break;
@@ -181,7 +275,110 @@ nsapi_size_or_error_t TCPSocket::recv(void *data, nsapi_size_t size)
         }
 
         _pending = 0;
+        _readable = false;
         ret = _stack->socket_recv(_socket, data, size);
+        if (ret != NSAPI_ERROR_WOULD_BLOCK) {
+            _readable = true;
+        }
+        if ((_timeout == 0) || (ret != NSAPI_ERROR_WOULD_BLOCK)) {
+            break;
+        } else {
+            uint32_t flag;
+
+            // Release lock before blocking so other threads
+            // accessing this object aren't blocked
+            _lock.unlock();
+            flag = _event_flag.wait_any(READ_FLAG, _timeout);
+            _lock.lock();
+
+            if (flag & osFlagsError) {
+                // Timeout break
+                ret = NSAPI_ERROR_WOULD_BLOCK;
+                break;
+            }
+        }
+    }
+
+    _read_in_progress = false;
+    _lock.unlock();
+    return ret;
+}
+
+nsapi_size_or_error_t TCPSocket::recvmsg(const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    _lock.lock();
+    nsapi_size_or_error_t ret;
+
+    // If this assert is hit then there are two threads
+    // performing a recv at the same time which is undefined
+    // behavior
+    MBED_ASSERT(!_read_in_progress);
+    _read_in_progress = true;
+
+    while (true) {
+        if (!_socket) {
+            ret = NSAPI_ERROR_NO_SOCKET;
+            break;
+        }
+
+        _pending = 0;
+        _readable = false;
+        ret = _stack->socket_recvmsg(_socket, NULL, iov, iovcnt);
+        if (ret != NSAPI_ERROR_WOULD_BLOCK) {
+            _readable = true;
+        }
+        if ((_timeout == 0) || (ret != NSAPI_ERROR_WOULD_BLOCK)) {
+            break;
+        } else {
+            uint32_t flag;
+
+            // Release lock before blocking so other threads
+            // accessing this object aren't blocked
+            _lock.unlock();
+            flag = _event_flag.wait_any(READ_FLAG, _timeout);
+            _lock.lock();
+
+            if (flag & osFlagsError) {
+                // Timeout break
+                ret = NSAPI_ERROR_WOULD_BLOCK;
+                break;
+            }
+        }
+    }
+
+    _read_in_progress = false;
+    _lock.unlock();
+    return ret;
+}
+
+nsapi_size_or_error_t TCPSocket::recv_loan(nsapi_loan_t *loan)
+{
+    _lock.lock();
+    nsapi_size_or_error_t ret;
+
+    // If this assert is hit then there are two threads
+    // performing a recv at the same time which is undefined
+    // behavior
+    MBED_ASSERT(!_read_in_progress);
+    _read_in_progress = true;
+    loan->_owner = 0;
+
+    while (true) {
+        if (!_socket) {
+            ret = NSAPI_ERROR_NO_SOCKET;
+            break;
+        }
+
+        _pending = 0;
+        _readable = false;
+        ret = _stack->socket_recv_loan(_socket, loan);
+        if (ret != NSAPI_ERROR_WOULD_BLOCK) {
+            _readable = true;
+        }
+        if (ret >= 0) {
+            loan->_owner = _stack;
+        }
+
         if ((_timeout == 0) || (ret != NSAPI_ERROR_WOULD_BLOCK)) {
             break;
         } else {
@@ -208,8 +405,13 @@ nsapi_size_or_error_t TCPSocket::recv(void *data, nsapi_size_t size)
 
 void TCPSocket::event()
 {
+    _readable = true;
+    _writable = true;
     _event_flag.set(READ_FLAG|WRITE_FLAG);
 
+    // Wake any poll() or Poller waiting on the socket
+    _poll_listeners.wake();
+
     _pending += 1;
     if (_callback && _pending == 1) {
         _callback();
@@ -98,6 +98,23 @@ public:
      *                  code on failure
      */
     nsapi_size_or_error_t send(const void *data, nsapi_size_t size);
+
+    /** Send data gathered from multiple buffers over a TCP socket
+     *
+     *  The socket must be connected to a remote host. The buffers are sent
+     *  in order as one stream without first being copied together. Returns
+     *  the number of bytes sent from the buffers.
+     *
+     *  By default, sendmsg blocks until all data is sent. If socket is set
+     *  to non-blocking or times out, a partial amount can be written.
+     *  NSAPI_ERROR_WOULD_BLOCK is returned if no data was written.
+     *
+     *  @param iov      Array of buffers to send
+     *  @param iovcnt   Number of buffers in the array
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t sendmsg(const nsapi_iovec_t *iov, unsigned iovcnt);
     
     /** Receive data over a TCP socket
      *
@@ -115,6 +132,43 @@ public:
      */
     nsapi_size_or_error_t recv(void *data, nsapi_size_t size);
 
+    /** Receive data over a TCP socket into multiple buffers
+     *
+     *  The socket must be connected to a remote host. Received data fills
+     *  the buffers in order. Returns the number of bytes received into the
+     *  buffers.
+     *
+     *  By default, recvmsg blocks until some data is received. If socket is
+     *  set to non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK can be
+     *  returned to indicate no data.
+     *
+     *  @param iov      Array of buffers to receive into
+     *  @param iovcnt   Number of buffers in the array
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t recvmsg(const nsapi_iovec_t *iov, unsigned iovcnt);
+
+    /** Receive data over a TCP socket without copying
+     *
+     *  The socket must be connected to a remote host. Lends up to
+     *  MBED_CONF_NSAPI_LOAN_SEGMENTS segments of the stack's receive
+     *  buffers and returns the number of bytes lent. The lent data is
+     *  consumed from the stream and must be returned with Socket::release.
+     *
+     *  Stacks that cannot lend their buffers copy into a heap buffer
+     *  instead.
+     *
+     *  By default, recv_loan blocks until some data is received. If socket
+     *  is set to non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK can be
+     *  returned to indicate no data.
+     *
+     *  @param loan     Destination for the lent data
+     *  @return         Number of lent bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t recv_loan(nsapi_loan_t *loan);
+
 protected:
     friend class TCPServer;
 
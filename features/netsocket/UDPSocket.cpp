@@ -64,7 +64,11 @@ nsapi_size_or_error_t UDPSocket::sendto(const SocketAddress &address, const void
         }
 
         _pending = 0;
+        _writable = false;
         nsapi_size_or_error_t sent = _stack->socket_sendto(_socket, address, data, size);
+        if (sent != NSAPI_ERROR_WOULD_BLOCK) {
+            _writable = true;
+        }
         if ((0 == _timeout) || (NSAPI_ERROR_WOULD_BLOCK != sent)) {
             ret = sent;
             break;
@@ -89,6 +93,100 @@ nsapi_size_or_error_t UDPSocket::sendto(const SocketAddress &address, const void
     return ret;
 }
 
+nsapi_size_or_error_t UDPSocket::sendmsg(const SocketAddress &address, const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    _lock.lock();
+    nsapi_size_or_error_t ret;
+
+    while (true) {
+        if (!_socket) {
+            ret = NSAPI_ERROR_NO_SOCKET;
+            break;
+        }
+
+        _pending = 0;
+        _writable = false;
+        nsapi_size_or_error_t sent = _stack->socket_sendmsg(_socket, &address, iov, iovcnt);
+        if (sent != NSAPI_ERROR_WOULD_BLOCK) {
+            _writable = true;
+        }
+        if ((0 == _timeout) || (NSAPI_ERROR_WOULD_BLOCK != sent)) {
+            ret = sent;
+            break;
+        } else {
+            uint32_t flag;
+
+            // Release lock before blocking so other threads
+            // accessing this object aren't blocked
+            _lock.unlock();
+            flag = _event_flag.wait_any(WRITE_FLAG, _timeout);
+            _lock.lock();
+
+            if (flag & osFlagsError) {
+                // Timeout break
+                ret = NSAPI_ERROR_WOULD_BLOCK;
+                break;
+            }
+        }
+    }
+
+    _lock.unlock();
+    return ret;
+}
+
+nsapi_size_or_error_t UDPSocket::sendto_batch(const nsapi_datagram_t *datagrams, unsigned count)
+{
+    _lock.lock();
+    nsapi_size_or_error_t ret;
+    unsigned sent = 0;
+
+    while (true) {
+        if (!_socket) {
+            ret = NSAPI_ERROR_NO_SOCKET;
+            break;
+        }
+
+        _pending = 0;
+        _writable = false;
+        ret = _stack->socket_sendto_batch(_socket, &datagrams[sent], count - sent);
+        if (ret != NSAPI_ERROR_WOULD_BLOCK) {
+            _writable = true;
+        }
+
+        if (ret >= 0) {
+            sent += ret;
+            if (sent >= count) {
+                break;
+            }
+        }
+        if (_timeout == 0) {
+            break;
+        } else if (ret == NSAPI_ERROR_WOULD_BLOCK) {
+            uint32_t flag;
+
+            // Release lock before blocking so other threads
+            // accessing this object aren't blocked
+            _lock.unlock();
+            flag = _event_flag.wait_any(WRITE_FLAG, _timeout);
+            _lock.lock();
+
+            if (flag & osFlagsError) {
+                // Timeout break
+                break;
+            }
+        } else if (ret < 0) {
+            break;
+        }
+    }
+
+    _lock.unlock();
+    if (sent == 0 && ret < 0) {
+        return ret;
+    } else {
+        return sent;
+    }
+}
+
 nsapi_size_or_error_t UDPSocket::recvfrom(SocketAddress *address, void *buffer, nsapi_size_t size)
 {
     _lock.lock();
@@ -101,7 +199,145 @@ nsapi_size_or_error_t UDPSocket::recvfrom(SocketAddress *address, void *buffer,
         }
 
         _pending = 0;
+        _readable = false;
         nsapi_size_or_error_t recv = _stack->socket_recvfrom(_socket, address, buffer, size);
+        if (recv != NSAPI_ERROR_WOULD_BLOCK) {
+            _readable = true;
+        }
+        if ((0 == _timeout) || (NSAPI_ERROR_WOULD_BLOCK != recv)) {
+            ret = recv;
+            break;
+        } else {
+            uint32_t flag;
+
+            // Release lock before blocking so other threads
+            // accessing this object aren't blocked
+            _lock.unlock();
+            flag = _event_flag.wait_any(READ_FLAG, _timeout);
+            _lock.lock();
+
+            if (flag & osFlagsError) {
+                // Timeout break
+                ret = NSAPI_ERROR_WOULD_BLOCK;
+                break;
+            }
+        }
+    }
+
+    _lock.unlock();
+    return ret;
+}
+
+nsapi_size_or_error_t UDPSocket::recvmsg(SocketAddress *address, const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    _lock.lock();
+    nsapi_size_or_error_t ret;
+
+    // The stack tells packets from streams by the address
+    SocketAddress source;
+    if (!address) {
+        address = &source;
+    }
+
+    while (true) {
+        if (!_socket) {
+            ret = NSAPI_ERROR_NO_SOCKET;
+            break;
+        }
+
+        _pending = 0;
+        _readable = false;
+        nsapi_size_or_error_t recv = _stack->socket_recvmsg(_socket, address, iov, iovcnt);
+        if (recv != NSAPI_ERROR_WOULD_BLOCK) {
+            _readable = true;
+        }
+        if ((0 == _timeout) || (NSAPI_ERROR_WOULD_BLOCK != recv)) {
+            ret = recv;
+            break;
+        } else {
+            uint32_t flag;
+
+            // Release lock before blocking so other threads
+            // accessing this object aren't blocked
+            _lock.unlock();
+            flag = _event_flag.wait_any(READ_FLAG, _timeout);
+            _lock.lock();
+
+            if (flag & osFlagsError) {
+                // Timeout break
+                ret = NSAPI_ERROR_WOULD_BLOCK;
+                break;
+            }
+        }
+    }
+
+    _lock.unlock();
+    return ret;
+}
+
+nsapi_size_or_error_t UDPSocket::recvfrom_batch(nsapi_datagram_t *datagrams, unsigned count)
+{
+    _lock.lock();
+    nsapi_size_or_error_t ret;
+
+    while (true) {
+        if (!_socket) {
+            ret = NSAPI_ERROR_NO_SOCKET;
+            break;
+        }
+
+        _pending = 0;
+        _readable = false;
+        nsapi_size_or_error_t recv = _stack->socket_recvfrom_batch(_socket, datagrams, count);
+        if (recv != NSAPI_ERROR_WOULD_BLOCK) {
+            _readable = true;
+        }
+        if ((0 == _timeout) || (NSAPI_ERROR_WOULD_BLOCK != recv)) {
+            ret = recv;
+            break;
+        } else {
+            uint32_t flag;
+
+            // Release lock before blocking so other threads
+            // accessing this object aren't blocked
+            _lock.unlock();
+            flag = _event_flag.wait_any(READ_FLAG, _timeout);
+            _lock.lock();
+
+            if (flag & osFlagsError) {
+                // Timeout break
+                ret = NSAPI_ERROR_WOULD_BLOCK;
+                break;
+            }
+        }
+    }
+
+    _lock.unlock();
+    return ret;
+}
+
+nsapi_size_or_error_t UDPSocket::recvfrom_loan(SocketAddress *address, nsapi_loan_t *loan)
+{
+    _lock.lock();
+    nsapi_size_or_error_t ret;
+    loan->_owner = 0;
+
+    while (true) {
+        if (!_socket) {
+            ret = NSAPI_ERROR_NO_SOCKET;
+            break;
+        }
+
+        _pending = 0;
+        _readable = false;
+        nsapi_size_or_error_t recv = _stack->socket_recvfrom_loan(_socket, address, loan);
+        if (recv != NSAPI_ERROR_WOULD_BLOCK) {
+            _readable = true;
+        }
+        if (recv >= 0) {
+            loan->_owner = _stack;
+        }
+
         if ((0 == _timeout) || (NSAPI_ERROR_WOULD_BLOCK != recv)) {
             ret = recv;
             break;
@@ -128,8 +364,13 @@ nsapi_size_or_error_t UDPSocket::recvfrom(SocketAddress *address, void *buffer,
 
 void UDPSocket::event()
 {
+    _readable = true;
+    _writable = true;
     _event_flag.set(READ_FLAG|WRITE_FLAG);
 
+    // Wake any poll() or Poller waiting on the socket
+    _poll_listeners.wake();
+
     _pending += 1;
     if (_callback && _pending == 1) {
         _callback();
@@ -94,6 +94,42 @@ public:
     nsapi_size_or_error_t sendto(const SocketAddress &address,
             const void *data, nsapi_size_t size);
 
+    /** Send a packet gathered from multiple buffers over a UDP socket
+     *
+     *  Sends the buffers as a single packet to the specified address
+     *  without first copying them together. Returns the number of bytes
+     *  sent from the buffers.
+     *
+     *  By default, sendmsg blocks until data is sent. If socket is set to
+     *  non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
+     *  immediately.
+     *
+     *  @param address  The SocketAddress of the remote host
+     *  @param iov      Array of buffers to send
+     *  @param iovcnt   Number of buffers in the array
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t sendmsg(const SocketAddress &address,
+            const nsapi_iovec_t *iov, unsigned iovcnt);
+
+    /** Send a batch of packets over a UDP socket
+     *
+     *  Sends each packet to the address and port in its datagram, in
+     *  order, with as few crossings into the network stack as the stack
+     *  allows. Returns the number of packets sent.
+     *
+     *  By default, sendto_batch blocks until all packets are sent. If
+     *  socket is set to non-blocking or times out, the number of packets
+     *  sent so far is returned, or NSAPI_ERROR_WOULD_BLOCK if none were.
+     *
+     *  @param datagrams    Array of packets to send
+     *  @param count        Number of packets in the array
+     *  @return             Number of packets sent on success, negative
+     *                      error code if no packet could be sent
+     */
+    nsapi_size_or_error_t sendto_batch(const nsapi_datagram_t *datagrams, unsigned count);
+
     /** Receive a packet over a UDP socket
      *
      *  Receives data and stores the source address in address if address
@@ -112,6 +148,64 @@ public:
     nsapi_size_or_error_t recvfrom(SocketAddress *address,
             void *data, nsapi_size_t size);
 
+    /** Receive a packet over a UDP socket into multiple buffers
+     *
+     *  Receives a single packet, filling the buffers in order, and stores
+     *  the source address in address if address is not NULL. Returns the
+     *  number of bytes received into the buffers.
+     *
+     *  By default, recvmsg blocks until data is sent. If socket is set to
+     *  non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
+     *  immediately.
+     *
+     *  @param address  Destination for the source address or NULL
+     *  @param iov      Array of buffers to receive into
+     *  @param iovcnt   Number of buffers in the array
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t recvmsg(SocketAddress *address,
+            const nsapi_iovec_t *iov, unsigned iovcnt);
+
+    /** Receive a batch of packets over a UDP socket
+     *
+     *  Receives the packets that are waiting, up to count, storing the
+     *  length, source address and port of each in its datagram. Returns
+     *  the number of packets received.
+     *
+     *  By default, recvfrom_batch blocks until at least one packet is
+     *  received. If socket is set to non-blocking or times out,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param datagrams    Array of buffers to receive packets into
+     *  @param count        Number of buffers in the array
+     *  @return             Number of packets received on success, negative
+     *                      error code on failure
+     */
+    nsapi_size_or_error_t recvfrom_batch(nsapi_datagram_t *datagrams, unsigned count);
+
+    /** Receive a packet over a UDP socket without copying
+     *
+     *  Lends up to MBED_CONF_NSAPI_LOAN_SEGMENTS segments of the stack's
+     *  receive buffers holding the packet and stores the source address in
+     *  address if address is not NULL. Any remainder of the packet is
+     *  discarded. Returns the number of bytes lent. The loan must be
+     *  returned with Socket::release.
+     *
+     *  Stacks that cannot lend their buffers copy into a heap buffer
+     *  instead.
+     *
+     *  By default, recvfrom_loan blocks until data is sent. If socket is set
+     *  to non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
+     *  immediately.
+     *
+     *  @param address  Destination for the source address or NULL
+     *  @param loan     Destination for the lent data
+     *  @return         Number of lent bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t recvfrom_loan(SocketAddress *address, nsapi_loan_t *loan);
+
 protected:
     virtual nsapi_protocol_t get_proto();
     virtual void event();
@@ -40,6 +40,8 @@
 #include "netsocket/UDPSocket.h"
 #include "netsocket/TCPSocket.h"
 #include "netsocket/TCPServer.h"
+#include "netsocket/SocketPollHandle.h"
+#include "netsocket/LoopbackStack.h"
 
 #endif
 
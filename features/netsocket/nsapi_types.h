@@ -275,6 +275,46 @@ typedef struct nsapi_ip_mreq {
     nsapi_addr_t imr_interface; /* local IP address of interface */
 } nsapi_ip_mreq_t;
 
+/** Maximum number of segments in a receive loan
+ */
+#ifndef MBED_CONF_NSAPI_LOAN_SEGMENTS
+#define MBED_CONF_NSAPI_LOAN_SEGMENTS 4
+#endif
+
+/** nsapi_iovec structure
+ *
+ *  Describes one contiguous segment of a scatter-gather buffer.
+ */
+typedef struct nsapi_iovec {
+    void *iov_base;         /* start of the segment */
+    nsapi_size_t iov_len;   /* size of the segment in bytes */
+} nsapi_iovec_t;
+
+/** nsapi_datagram structure
+ *
+ *  One UDP packet in a batch sent or received in a single call.
+ */
+typedef struct nsapi_datagram {
+    nsapi_addr_t addr;      /* remote address, set on receive */
+    uint16_t port;          /* remote port, set on receive */
+    void *data;             /* packet to send or buffer to receive into */
+    nsapi_size_t size;      /* size of the packet or of the buffer */
+    nsapi_size_t length;    /* bytes received, set on receive */
+} nsapi_datagram_t;
+
+/** nsapi_loan structure
+ *
+ *  Received data lent to the application by the network stack without
+ *  copying. The segments stay valid until the loan is released.
+ */
+typedef struct nsapi_loan {
+    nsapi_iovec_t segments[MBED_CONF_NSAPI_LOAN_SEGMENTS]; /* lent data */
+    unsigned count;         /* number of valid segments */
+    nsapi_size_t size;      /* total size of the segments in bytes */
+    void *handle;           /* stack-specific handle for the lent buffer */
+    void *_owner;           /* internal nsapi use */
+} nsapi_loan_t;
+
 /** nsapi_stack_api structure
  *
  *  Common api structure for network stack operations. A network stack
@@ -564,6 +604,151 @@ typedef struct nsapi_stack_api
      */
     nsapi_error_t (*getsockopt)(nsapi_stack_t *stack, nsapi_socket_t socket, int level,
             int optname, void *optval, unsigned *optlen);
+
+    /** Lend received data over a TCP socket
+     *
+     *  Fills the loan with up to MBED_CONF_NSAPI_LOAN_SEGMENTS segments of
+     *  the stack's own receive buffers and returns the number of bytes lent.
+     *  The lent data is consumed from the socket and must be returned with
+     *  socket_release.
+     *
+     *  This call is non-blocking. If recv would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  If socket_release is null, loans are emulated with socket_recv.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param loan     Destination for the lent data
+     *  @return         Number of lent bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t (*socket_recv_loan)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            nsapi_loan_t *loan);
+
+    /** Lend a received packet over a UDP socket
+     *
+     *  Fills the loan with up to MBED_CONF_NSAPI_LOAN_SEGMENTS segments of
+     *  the stack's own receive buffers and returns the number of bytes lent.
+     *  Any remainder of the packet is discarded. The loan must be returned
+     *  with socket_release.
+     *
+     *  This call is non-blocking. If recvfrom would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  If socket_release is null, loans are emulated with socket_recvfrom.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param addr     Destination for the address of the remote host
+     *  @param port     Destination for the port of the remote host
+     *  @param loan     Destination for the lent data
+     *  @return         Number of lent bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t (*socket_recvfrom_loan)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            nsapi_addr_t *addr, uint16_t *port, nsapi_loan_t *loan);
+
+    /** Return a loan to the stack
+     *
+     *  The loan is not tied to the socket that produced it and may be
+     *  released after the socket has been closed.
+     *
+     *  @param stack    Stack handle
+     *  @param loan     Loan returned by socket_recv_loan or socket_recvfrom_loan
+     */
+    void (*socket_release)(nsapi_stack_t *stack, nsapi_loan_t *loan);
+
+    /** Send data gathered from multiple buffers
+     *
+     *  If addr is NULL, the data is sent over a connected TCP socket as if
+     *  by socket_send. Otherwise the buffers are sent as a single UDP
+     *  packet to the specified address as if by socket_sendto. Returns the
+     *  number of bytes sent from the buffers.
+     *
+     *  This call is non-blocking. If sendmsg would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  If null, the buffers are sent with socket_send or socket_sendto.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param addr     The address of the remote host or NULL
+     *  @param port     The port of the remote host
+     *  @param iov      Array of buffers to send
+     *  @param iovcnt   Number of buffers in the array
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t (*socket_sendmsg)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            const nsapi_addr_t *addr, uint16_t port, const nsapi_iovec_t *iov, unsigned iovcnt);
+
+    /** Receive data scattered into multiple buffers
+     *
+     *  If addr is NULL, data is received over a connected TCP socket as if
+     *  by socket_recv. Otherwise a single UDP packet is received as if by
+     *  socket_recvfrom and its source is stored in addr and port. Returns
+     *  the number of bytes received into the buffers.
+     *
+     *  This call is non-blocking. If recvmsg would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  If null, data is received with socket_recv or socket_recvfrom.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param addr     Destination for the address of the remote host or NULL
+     *  @param port     Destination for the port of the remote host
+     *  @param iov      Array of buffers to receive into
+     *  @param iovcnt   Number of buffers in the array
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t (*socket_recvmsg)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            nsapi_addr_t *addr, uint16_t *port, const nsapi_iovec_t *iov, unsigned iovcnt);
+
+    /** Send a batch of UDP packets
+     *
+     *  Sends each packet to its own address as if by socket_sendto, in
+     *  order, stopping at the first packet that fails. Returns the number
+     *  of packets sent.
+     *
+     *  This call is non-blocking. If no packet can be sent without
+     *  blocking, NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  If null, the packets are sent one at a time with socket_sendto.
+     *
+     *  @param stack        Stack handle
+     *  @param socket       Socket handle
+     *  @param datagrams    Array of packets to send
+     *  @param count        Number of packets in the array
+     *  @return             Number of packets sent on success, negative
+     *                      error code if no packet could be sent
+     */
+    nsapi_size_or_error_t (*socket_sendto_batch)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            const nsapi_datagram_t *datagrams, unsigned count);
+
+    /** Receive a batch of UDP packets
+     *
+     *  Receives the packets that are already waiting, up to count, as if
+     *  by socket_recvfrom. The length, address and port of each packet
+     *  are stored in its datagram. Returns the number of packets received.
+     *
+     *  This call is non-blocking. If no packet is waiting,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  If null, the packets are received one at a time with
+     *  socket_recvfrom.
+     *
+     *  @param stack        Stack handle
+     *  @param socket       Socket handle
+     *  @param datagrams    Array of buffers to receive packets into
+     *  @param count        Number of buffers in the array
+     *  @return             Number of packets received on success, negative
+     *                      error code if no packet was received
+     */
+    nsapi_size_or_error_t (*socket_recvfrom_batch)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            nsapi_datagram_t *datagrams, unsigned count);
 } nsapi_stack_api_t;
 
 
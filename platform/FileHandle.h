@@ -250,6 +250,30 @@ public:
     {
         //Default for real files. Do nothing for real files.
     }
+
+    /** Attach a listener woken on state change of the file.
+     *
+     *  Used by poll() and Poller to sleep until the file changes state
+     *  without taking over the sigio() callback. Any number of listeners
+     *  may be attached, and they may be woken in an interrupt context.
+     *
+     *  @param listener Listener to attach, must stay valid until detached
+     *  @return         true if the listener is woken on every state change,
+     *                  false if the file must be polled periodically instead
+     */
+    virtual bool attach_poll(PollListener *listener)
+    {
+        // Default for real files, which never change state
+        return false;
+    }
+
+    /** Detach a listener attached with attach_poll().
+     *
+     *  @param listener Listener to detach
+     */
+    virtual void detach_poll(PollListener *listener)
+    {
+    }
 };
 
 /** Not a member function
@@ -0,0 +1,60 @@
+/** \addtogroup platform */
+/** @{*/
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_CRC_H
+#define MBED_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \defgroup platform_crc CRC functions
+ * @{
+ */
+
+/** Continue a CRC-32 calculation
+ *
+ * The CRC uses the polynomial 0x04c11db7 with reflected input and output.
+ * No initial value or final xor is applied, so the caller starts from
+ * 0xffffffff and inverts the result for a standard CRC-32. The state is
+ * passed in and returned, so calculations can be split across calls.
+ *
+ * Targets with DEVICE_CRC use their CRC peripheral through
+ * hal_crc32_update. Otherwise a 64 byte table is used by default, and
+ * enabling the platform.crc-slice8 option trades 8KiB of read-only tables
+ * for a considerably faster CRC.
+ *
+ * @param crc   The CRC state from a previous call
+ * @param data  The pointer to the data, may be unaligned
+ * @param size  The size of the data in bytes
+ * @return      The updated CRC state
+ */
+uint32_t mbed_crc32_update(uint32_t crc, const void *data, size_t size);
+
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/** @}*/
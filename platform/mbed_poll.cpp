@@ -16,29 +16,83 @@
 #include "mbed_poll.h"
 #include "FileHandle.h"
 #include "Timer.h"
-#ifdef MBED_CONF_RTOS_PRESENT
-#include "rtos/Thread.h"
+#include "platform/mbed_critical.h"
+#include "platform/mbed_retarget.h"
+#include <new>
+#ifndef MBED_CONF_RTOS_PRESENT
+#include "Timeout.h"
+#include "platform/DeepSleepLock.h"
+#endif
+
+#ifndef MBED_CONF_PLATFORM_POLL_RESCAN_MS
+#define MBED_CONF_PLATFORM_POLL_RESCAN_MS 1
 #endif
 
 namespace mbed {
 
+PollListenerList::PollListenerList()
+    : _head(NULL)
+{
+}
+
+void PollListenerList::attach(PollListener *listener)
+{
+    core_util_critical_section_enter();
+    listener->next = _head;
+    _head = listener;
+    core_util_critical_section_exit();
+}
+
+void PollListenerList::detach(PollListener *listener)
+{
+    core_util_critical_section_enter();
+    PollListener *volatile *prev = &_head;
+    while (*prev && *prev != listener) {
+        prev = &(*prev)->next;
+    }
+    if (*prev) {
+        *prev = listener->next;
+    }
+    core_util_critical_section_exit();
+}
+
+void PollListenerList::wake()
+{
+    // Listeners only wake their waiters, so this is short enough
+    // to hold off a concurrent detach
+    core_util_critical_section_enter();
+    for (PollListener *listener = _head; listener; listener = listener->next) {
+        listener->wake();
+    }
+    core_util_critical_section_exit();
+}
+
 // timeout -1 forever, or milliseconds
 int poll(pollfh fhs[], unsigned nfhs, int timeout)
 {
-    /**
-     * TODO Proper wake-up mechanism.
-     * In order to correctly detect availability of read/write a FileHandle, we needed
-     * a select or poll mechanisms. We opted for poll as POSIX defines in
-     * http://pubs.opengroup.org/onlinepubs/009695399/functions/poll.html Currently,
-     * mbed::poll() just spins and scans filehandles looking for any events we are
-     * interested in. In future, his spinning behaviour will be replaced with
-     * condition variables.
-     */
     Timer timer;
     if (timeout > 0) {
         timer.start();
     }
 
+    // Any state change on the file handles wakes us up to scan them again.
+    // The listeners are attached before the first scan so that nothing
+    // happening between a scan and the wait goes unnoticed. File handles
+    // that can't wake us are scanned again periodically.
+    Poller::Waker waker;
+    PollListener *listeners = NULL;
+    bool rescan = false;
+    if (timeout != 0) {
+        listeners = new (std::nothrow) PollListener[nfhs];
+        rescan = !listeners;
+        for (unsigned n = 0; listeners && n < nfhs; n++) {
+            listeners[n].wake = callback(&waker, &Poller::Waker::wake);
+            if (fhs[n].fh && !fhs[n].fh->attach_poll(&listeners[n])) {
+                rescan = true;
+            }
+        }
+    }
+
     int count = 0;
     for (;;) {
         /* Scan the file handles */
@@ -55,21 +109,317 @@ int poll(pollfh fhs[], unsigned nfhs, int timeout)
             }
         }
 
-        if (count) {
+        if (count || timeout == 0) {
             break;
         }
 
-        /* Nothing selected - this is where timeout handling would be needed */
-        if (timeout == 0 || (timeout > 0 && timer.read_ms() > timeout)) {
+        /* Nothing selected, sleep until a file handle signals or we time out */
+        int remaining = -1;
+        if (timeout > 0) {
+            remaining = timeout - timer.read_ms();
+            if (remaining <= 0) {
+                break;
+            }
+        }
+        if (rescan && (remaining < 0 || remaining > MBED_CONF_PLATFORM_POLL_RESCAN_MS)) {
+            remaining = MBED_CONF_PLATFORM_POLL_RESCAN_MS;
+        }
+        waker.wait(remaining);
+    }
+
+    if (listeners) {
+        for (unsigned n = 0; n < nfhs; n++) {
+            if (fhs[n].fh) {
+                fhs[n].fh->detach_poll(&listeners[n]);
+            }
+        }
+        delete[] listeners;
+    }
+    return count;
+}
+
+
+struct Poller::Entry {
+    Poller *poller;
+    FileHandle *fh;
+    short events;
+    bool queued;
+    bool rescan;
+    Entry *next;
+    Entry *next_ready;
+    PollListener listener;
+
+    // Poll listener, may be called from interrupt context
+    void signal()
+    {
+        poller->signal(this);
+    }
+};
+
+Poller::Poller()
+    : _entries(NULL)
+    , _rescans(0)
+    , _ready(NULL)
+    , _ready_tail(&_ready)
+{
+}
+
+Poller::~Poller()
+{
+    while (_entries) {
+        remove(_entries->fh);
+    }
+}
+
+Poller::Entry *Poller::find(FileHandle *fh)
+{
+    for (Entry *entry = _entries; entry; entry = entry->next) {
+        if (entry->fh == fh) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+void Poller::queue(Entry *entry)
+{
+    core_util_critical_section_enter();
+    if (!entry->queued) {
+        entry->queued = true;
+        entry->next_ready = NULL;
+        *_ready_tail = entry;
+        _ready_tail = &entry->next_ready;
+    }
+    core_util_critical_section_exit();
+}
+
+void Poller::signal(Entry *entry)
+{
+    queue(entry);
+    _waker.wake();
+}
+
+int Poller::add(FileHandle *fh, short events)
+{
+    if (!fh) {
+        return -EINVAL;
+    }
+
+    _mutex.lock();
+    if (find(fh)) {
+        _mutex.unlock();
+        return -EEXIST;
+    }
+
+    Entry *entry = new (std::nothrow) Entry;
+    if (!entry) {
+        _mutex.unlock();
+        return -ENOMEM;
+    }
+
+    entry->poller = this;
+    entry->fh = fh;
+    entry->events = events;
+    entry->queued = false;
+    entry->next = _entries;
+    _entries = entry;
+
+    // File handles only signal changes, so examine the current
+    // state on the next wait
+    entry->listener.wake = callback(entry, &Entry::signal);
+    entry->rescan = !fh->attach_poll(&entry->listener);
+    if (entry->rescan) {
+        _rescans += 1;
+    }
+    signal(entry);
+
+    _mutex.unlock();
+    return 0;
+}
+
+int Poller::modify(FileHandle *fh, short events)
+{
+    _mutex.lock();
+    Entry *entry = find(fh);
+    if (!entry) {
+        _mutex.unlock();
+        return -ENOENT;
+    }
+
+    entry->events = events;
+    signal(entry);
+
+    _mutex.unlock();
+    return 0;
+}
+
+int Poller::remove(FileHandle *fh)
+{
+    _mutex.lock();
+    Entry **prev = &_entries;
+    while (*prev && (*prev)->fh != fh) {
+        prev = &(*prev)->next;
+    }
+
+    Entry *entry = *prev;
+    if (!entry) {
+        _mutex.unlock();
+        return -ENOENT;
+    }
+
+    // Once detached the file handle can no longer queue the entry
+    fh->detach_poll(&entry->listener);
+    if (entry->rescan) {
+        _rescans -= 1;
+    }
+    *prev = entry->next;
+
+    core_util_critical_section_enter();
+    if (entry->queued) {
+        Entry **ready = &_ready;
+        while (*ready != entry) {
+            ready = &(*ready)->next_ready;
+        }
+        *ready = entry->next_ready;
+        if (_ready_tail == &entry->next_ready) {
+            _ready_tail = ready;
+        }
+    }
+    core_util_critical_section_exit();
+
+    delete entry;
+    _mutex.unlock();
+    return 0;
+}
+
+int Poller::wait(pollfh ready[], unsigned nready, int timeout)
+{
+    Timer timer;
+    if (timeout > 0) {
+        timer.start();
+    }
+
+    int count = 0;
+    for (;;) {
+        _mutex.lock();
+
+        // File handles that can't signal are examined on every pass
+        bool rescan = _rescans > 0;
+        if (rescan) {
+            for (Entry *entry = _entries; entry; entry = entry->next) {
+                if (entry->rescan) {
+                    queue(entry);
+                }
+            }
+        }
+
+        // Take the file handles that signalled, anything that
+        // signals from here on is queued for the next pass
+        core_util_critical_section_enter();
+        Entry *entry = _ready;
+        Entry **taken_tail = _ready_tail;
+        _ready = NULL;
+        _ready_tail = &_ready;
+        core_util_critical_section_exit();
+
+        while (entry && (unsigned)count < nready) {
+            Entry *next = entry->next_ready;
+
+            // Clear before examining so a signal that races
+            // with poll() queues the entry again
+            core_util_critical_section_enter();
+            entry->queued = false;
+            core_util_critical_section_exit();
+
+            short mask = entry->events | POLLERR | POLLHUP | POLLNVAL;
+            short revents = entry->fh->poll(mask) & mask;
+            if (revents) {
+                ready[count].fh = entry->fh;
+                ready[count].events = entry->events;
+                ready[count].revents = revents;
+                count++;
+
+                // Level-triggered, examine again on the next wait
+                // until it stops being ready
+                queue(entry);
+            }
+
+            entry = next;
+        }
+
+        // Out of room, the rest are still queued and go back
+        // ahead of anything reported so that none are starved
+        if (entry) {
+            core_util_critical_section_enter();
+            *taken_tail = _ready;
+            if (!_ready) {
+                _ready_tail = taken_tail;
+            }
+            _ready = entry;
+            core_util_critical_section_exit();
+        }
+
+        _mutex.unlock();
+
+        if (count || timeout == 0) {
             break;
         }
+
+        int remaining = -1;
+        if (timeout > 0) {
+            remaining = timeout - timer.read_ms();
+            if (remaining <= 0) {
+                break;
+            }
+        }
+        if (rescan && (remaining < 0 || remaining > MBED_CONF_PLATFORM_POLL_RESCAN_MS)) {
+            remaining = MBED_CONF_PLATFORM_POLL_RESCAN_MS;
+        }
+        _waker.wait(remaining);
+    }
+
+    return count;
+}
+
+
+Poller::Waker::Waker()
+#ifndef MBED_CONF_RTOS_PRESENT
+    : _woken(false)
+#endif
+{
+}
+
+void Poller::Waker::wake()
+{
 #ifdef MBED_CONF_RTOS_PRESENT
-        // TODO - proper blocking
-        // wait for condition variable, wait queue whatever here
-        rtos::Thread::wait(1);
+    _flags.set(1);
+#else
+    _woken = true;
 #endif
+}
+
+void Poller::Waker::wait(int timeout)
+{
+#ifdef MBED_CONF_RTOS_PRESENT
+    _flags.wait_any(1, timeout < 0 ? osWaitForever : timeout);
+#else
+    // Without an RTOS sleep until an interrupt wakes us, keeping
+    // the microsecond ticker running for the timeout
+    Timeout deadline;
+    if (timeout > 0) {
+        deadline.attach_us(callback(this, &Waker::wake), 1000ULL*timeout);
     }
-    return count;
+    DeepSleepLock lock;
+
+    core_util_critical_section_enter();
+    while (!_woken) {
+        sleep();
+        core_util_critical_section_exit();
+        core_util_critical_section_enter();
+    }
+    _woken = false;
+    core_util_critical_section_exit();
+#endif
 }
 
 } // namespace mbed
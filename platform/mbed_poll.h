@@ -22,6 +22,13 @@
 #define POLLHUP        0x2000 ///< The device has been disconnected
 #define POLLNVAL       0x4000 ///< The specified file handle value is invalid
 
+#include "platform/Callback.h"
+#include "platform/NonCopyable.h"
+#include "platform/PlatformMutex.h"
+#ifdef MBED_CONF_RTOS_PRESENT
+#include "rtos/EventFlags.h"
+#endif
+
 namespace mbed {
 
 class FileHandle;
@@ -39,10 +46,52 @@ struct pollfh {
     short revents;
 };
 
+/** A listener woken on state changes of a file handle
+ *
+ * poll() and Poller attach a listener to each file handle they wait on
+ * through FileHandle::attach_poll(), leaving the sigio() callback to the
+ * owner of the file handle.
+ */
+struct PollListener {
+    Callback<void()> wake;
+    PollListener *next;
+};
+
+/** The poll listeners attached to a file handle
+ *
+ * File handles that support poll listeners keep one of these and wake it
+ * wherever they call their sigio() callback.
+ */
+class PollListenerList : private NonCopyable<PollListenerList> {
+public:
+    PollListenerList();
+
+    /** Attach a listener, the listener must stay valid until detached
+     */
+    void attach(PollListener *listener);
+
+    /** Detach a listener, does nothing if the listener is not attached
+     */
+    void detach(PollListener *listener);
+
+    /** Wake every attached listener, may be called from interrupt context
+     */
+    void wake();
+
+private:
+    PollListener *volatile _head;
+};
+
 /** A mechanism to multiplex input/output over a set of file handles(file descriptors).
  * For every file handle provided, poll() examines it for any events registered for that particular
  * file handle.
  *
+ * While nothing is selected the caller sleeps until one of the file handles
+ * wakes the listener poll() attaches with FileHandle::attach_poll(). File
+ * handles that don't support poll listeners are examined again every
+ * MBED_CONF_PLATFORM_POLL_RESCAN_MS milliseconds. The sigio() callbacks of
+ * the file handles are left untouched.
+ *
  * @param fhs     an array of PollFh struct carrying a FileHandle and bitmasks of events
  * @param nfhs    number of file handles
  * @param timeout timer value to timeout or -1 for loop forever
@@ -51,6 +100,117 @@ struct pollfh {
  */
 int poll(pollfh fhs[], unsigned nfhs, int timeout);
 
+/** A persistent set of file handles to wait on
+ *
+ * Where poll() examines every file handle on every call, a Poller keeps the
+ * set of file handles registered between calls and attaches a poll listener
+ * to each of them. Only the file handles that signalled since the last call to wait()
+ * are examined again, so the cost of a wake-up does not grow with the number
+ * of registered file handles.
+ *
+ * Readiness is level-triggered: a file handle that is reported ready is
+ * reported again by the next wait() until it stops being ready.
+ *
+ * The sigio() callbacks of registered file handles are left untouched, and a
+ * file handle may be registered with several Pollers and passed to poll() at
+ * the same time. File handles that don't support poll listeners are examined
+ * on every pass, with passes at most MBED_CONF_PLATFORM_POLL_RESCAN_MS
+ * milliseconds apart. Only one thread may wait on a Poller at a time, but
+ * registrations may be changed from other threads while it waits.
+ *
+ * Example:
+ * @code
+ * Poller poller;
+ * poller.add(&serial, POLLIN);
+ * poller.add(&socket_handle, POLLIN);
+ *
+ * pollfh ready[2];
+ * int count = poller.wait(ready, 2, -1);
+ * for (int i = 0; i < count; i++) {
+ *     if (ready[i].revents & POLLIN) {
+ *         // read from ready[i].fh
+ *     }
+ * }
+ * @endcode
+ */
+class Poller : private NonCopyable<Poller> {
+public:
+    /** Create an empty Poller
+     */
+    Poller();
+
+    /** Destroy a Poller
+     *
+     * Removes any file handles that are still registered
+     */
+    ~Poller();
+
+    /** Register a file handle
+     *
+     * @param fh        file handle to watch
+     * @param events    bitmask of poll events to watch for, POLLERR, POLLHUP and
+     *                  POLLNVAL are always watched
+     * @return          0 on success, -EINVAL if fh is NULL, -EEXIST if fh is
+     *                  already registered, -ENOMEM if out of memory
+     */
+    int add(FileHandle *fh, short events);
+
+    /** Change the events watched for on a registered file handle
+     *
+     * @param fh        registered file handle
+     * @param events    new bitmask of poll events to watch for
+     * @return          0 on success, -ENOENT if fh is not registered
+     */
+    int modify(FileHandle *fh, short events);
+
+    /** Unregister a file handle
+     *
+     * @param fh        registered file handle
+     * @return          0 on success, -ENOENT if fh is not registered
+     */
+    int remove(FileHandle *fh);
+
+    /** Wait for events on the registered file handles
+     *
+     * @param ready     array filled with the file handles that are ready, their
+     *                  watched events and the events that occurred
+     * @param nready    size of the ready array
+     * @param timeout   timeout in milliseconds, 0 to not wait, or -1 to wait forever
+     * @return          number of entries filled in ready, 0 if timed out
+     */
+    int wait(pollfh ready[], unsigned nready, int timeout);
+
+private:
+    friend int poll(pollfh fhs[], unsigned nfhs, int timeout);
+
+    struct Entry;
+
+    // Sleeps the waiting thread until woken by a poll listener
+    class Waker : private NonCopyable<Waker> {
+    public:
+        Waker();
+        void wake();
+        void wait(int timeout);
+    private:
+#ifdef MBED_CONF_RTOS_PRESENT
+        rtos::EventFlags _flags;
+#else
+        volatile bool _woken;
+#endif
+    };
+
+    void queue(Entry *entry);
+    void signal(Entry *entry);
+    Entry *find(FileHandle *fh);
+
+    Entry *_entries;
+    unsigned _rescans;
+    Entry *_ready;
+    Entry **_ready_tail;
+    Waker _waker;
+    PlatformMutex _mutex;
+};
+
 /**@}*/
 
 /**@}*/